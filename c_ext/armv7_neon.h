@@ -13,7 +13,9 @@
 #include <arm_neon.h>
 
 #define PYGF2X_USE_ARMV7_NEON
+#define PYGF2X_BACKEND "armv7_neon"
 #define KARATSUBA_LIMIT 8
+#define TOOM_LIMIT 32
 
 #define ATOM 8
 #define mul_ATOM_15(a,b) mul_8_15(a,b)
@@ -51,6 +53,34 @@ mul_30_30(uint32_t l, uint32_t r)
                                   vshl_n_u64(vget_high_u64(p20),8)),0);   // 0 1 2 3 4 5 6 7
 }
 
+static inline uint64_t
+mul_32_32(uint32_t l, uint32_t r)
+// Multiply two unsigned 32-bit polynomials over GF(2) (stored in uint32_t)
+// Return as a 63-bit polynomial (stored in uint64_t)
+{
+    // The byte-sliced kernel of mul_30_30 is exact for all 4 bytes of its operands
+    return mul_30_30(l, r);
+}
+
+static inline uint64_t
+mul_64_64(uint64_t l, uint64_t r, uint64_t *h)
+// Multiply two unsigned 64-bit polynomials over GF(2) (stored in uint64_t)
+// Return the lower 64 bits of the 127-bit product, store the upper 63 bits in *h
+{
+    // Use Karatsubas formula and mul_32_32
+    uint32_t ll = (uint32_t)l;
+    uint32_t lh = (uint32_t)(l >> 32);
+    uint32_t rl = (uint32_t)r;
+    uint32_t rh = (uint32_t)(r >> 32);
+
+    uint64_t z0 = mul_32_32(ll,rl);
+    uint64_t z2 = mul_32_32(lh,rh);
+    uint64_t z1 = mul_32_32(ll ^ lh, rl ^ rh) ^z2 ^z0;
+
+    *h = z2 ^ (z1 >> 32);
+    return z0 ^ (z1 << 32);
+}
+
 
 static inline uint64_t
 mul_15_30(uint16_t l, uint32_t r)
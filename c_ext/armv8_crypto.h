@@ -12,7 +12,9 @@
 #include <arm_neon.h>
 
 #define PYGF2X_USE_ARMV8_CRYPTO
+#define PYGF2X_BACKEND "armv8_crypto"
 #define KARATSUBA_LIMIT 16
+#define TOOM_LIMIT 128
 
 #define ATOM 8
 #define mul_ATOM_15(a,b) mul_8_15(a,b)
@@ -74,6 +76,34 @@ mul_30_30(uint32_t l, uint32_t r)
     return vmull_p64((poly64_t)l,(poly64_t)r);
 }
 
+static inline uint64_t
+mul_64_64(uint64_t l, uint64_t r, uint64_t *h)
+// Multiply two unsigned 64-bit polynomials over GF(2) (stored in uint64_t)
+// Return the lower 64 bits of the 127-bit product, store the upper 63 bits in *h
+{
+    uint64x2_t pi = vreinterpretq_u64_p128(vmull_p64((poly64_t)l,(poly64_t)r));
+    *h = vgetq_lane_u64(pi, 1);
+    return vgetq_lane_u64(pi, 0);
+}
+
+#define PYGF2X_HAVE_MUL_128
+static inline void
+mul_128_128(uint64_t * restrict p, const uint64_t *a, const uint64_t *b)
+// Multiply two 128-bit polynomials over GF(2), stored in two words each
+// Store the 255-bit product in p[0..3]
+{
+    poly64x2_t ai = vreinterpretq_p64_u64(vld1q_u64(a));
+    poly64x2_t bi = vreinterpretq_p64_u64(vld1q_u64(b));
+    uint64x2_t lo = vreinterpretq_u64_p128(vmull_p64(vgetq_lane_p64(ai, 0), vgetq_lane_p64(bi, 0)));
+    uint64x2_t hi = vreinterpretq_u64_p128(vmull_high_p64(ai, bi));
+    // Karatsuba: (a0+a1)(b0+b1) + a0b0 + a1b1
+    uint64x2_t mi = vreinterpretq_u64_p128(vmull_p64((poly64_t)(a[0] ^ a[1]), (poly64_t)(b[0] ^ b[1])));
+    mi = veorq_u64(mi, veorq_u64(lo, hi));
+    const uint64x2_t zero = vdupq_n_u64(0);
+    vst1q_u64(p, veorq_u64(lo, vextq_u64(zero, mi, 1)));
+    vst1q_u64(p+2, veorq_u64(hi, vextq_u64(mi, zero, 1)));
+}
+
 static inline uint32_t
 sqr_15(uint16_t f)
 {
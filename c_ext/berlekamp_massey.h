@@ -0,0 +1,267 @@
+/* -*- mode: c; c-basic-offset: 4; -*- */
+/*******************************************************************************
+ *
+ * Copyright (c) 2021 Oskar Enoksson. All rights reserved.
+ * Licensed under the MIT license. See LICENSE file in the project root for details.
+ *
+ * Description:
+ * Berlekamp-Massey: the shortest LFSR generating a sequence of bits
+ *
+ * For the sequence s_0, s_1, ... with generating polynomial S = sum s_i x^i, the
+ * algorithm keeps a connection polynomial C of length L, i.e. with
+ *
+ *   s_n = sum_{i=1}^{L} c_i s_(n-i)   for L <= n
+ *
+ * and a previous one B, shifted so that x^m B is ready to be added. The
+ * discrepancy of step n is coefficient n of C*S, and each step is one of
+ *
+ *   d = 0:              C' = C,        B' = x B
+ *   d = 1, 2L <= n:     C' = C + B,    B' = x C,    L' = n+1-L
+ *   d = 1, 2L > n:      C' = C + B,    B' = x B
+ *
+ * a linear map of (C, B) with polynomial coefficients. The steps are done on the
+ * windows of C*S and B*S at the positions still to come, as 64-bit words, so each
+ * step is a few word-wide xors and shifts, while the product of the maps so far is
+ * kept in a 2x2 matrix.
+ *
+ * Above bm_recursive_limit bits the steps are split in two halves (the half-GCD
+ * structure). The matrix M1 of the first half has degree at most its length h, so
+ * the windows for the second half are the coefficients h .. of M1*(C*S, B*S),
+ * computed by mul_nl_nr, and the second half gives M2. The result is M2*M1. This
+ * costs O(M(n) log n) instead of O(n^2).
+ *
+ *******************************************************************************/
+
+static inline void
+bm_shl1(uint64_t *a, int nw)
+// a = x*a, with nw words
+{
+    uint64_t carry = 0;
+    for(int i=0; i<nw; i++) {
+        const uint64_t t = a[i];
+        a[i] = (t << 1) | carry;
+        carry = t >> 63;
+    }
+}
+
+static inline void
+bm_add_shl1(uint64_t *a, uint64_t *b, int nw)
+// a, b = a + b, x*b
+{
+    uint64_t carry = 0;
+    for(int i=0; i<nw; i++) {
+        const uint64_t t = b[i];
+        a[i] ^= t;
+        b[i] = (t << 1) | carry;
+        carry = t >> 63;
+    }
+}
+
+static inline void
+bm_add_swap_shl1(uint64_t *a, uint64_t *b, int nw)
+// a, b = a + b, x*a
+{
+    uint64_t carry = 0;
+    for(int i=0; i<nw; i++) {
+        const uint64_t t = a[i];
+        a[i] = t ^ b[i];
+        b[i] = (t << 1) | carry;
+        carry = t >> 63;
+    }
+}
+
+static void
+bm_steps(int n0, int len, uint64_t *e, uint64_t *f, int *L, uint64_t *m, int nwm)
+//
+// Run the steps n0 .. n0+len-1, where e and f hold the windows of C*S and B*S
+// at those positions and are overwritten. Store the map of the steps in m, as the
+// entries m11, m12, m21, m22 of nwm >= len/64+1 words each.
+//
+{
+    const int nwl = (len + 63)/64;
+    uint64_t *m11 = m;
+    uint64_t *m12 = m + nwm;
+    uint64_t *m21 = m + 2*nwm;
+    uint64_t *m22 = m + 3*nwm;
+    memset(m, 0, 4*nwm*sizeof(uint64_t));
+    m11[0] = 1;
+    m22[0] = 1;
+    int l = *L;
+    for(int j=0; j<len; j++) {
+        const int n = n0 + j;
+        const int w0 = j/64;            // Lower words of the windows are done
+        const int nw = (j+1)/64 + 1;    // Words of the matrix, of degree <= j+1
+        if(((e[w0] >> (j%64)) & 1) == 0) {
+            bm_shl1(f + w0, nwl - w0);
+            bm_shl1(m21, nw);
+            bm_shl1(m22, nw);
+        } else if(2*l <= n) {
+            bm_add_swap_shl1(e + w0, f + w0, nwl - w0);
+            bm_add_swap_shl1(m11, m21, nw);
+            bm_add_swap_shl1(m12, m22, nw);
+            l = n + 1 - l;
+        } else {
+            bm_add_shl1(e + w0, f + w0, nwl - w0);
+            bm_add_shl1(m11, m21, nw);
+            bm_add_shl1(m12, m22, nw);
+        }
+    }
+    *L = l;
+}
+
+static void
+bm_mul2(uint64_t *r, int lo, int nbits_r,
+        const uint64_t *a1, const uint64_t *b1, const uint64_t *a2, const uint64_t *b2,
+        int nwa, int nwb)
+//
+// r = bits lo .. lo+nbits_r-1 of a1*b1 + a2*b2, where the a have nwa and the b nwb words.
+// Bits of r above nbits_r are left undefined.
+//
+{
+    const uint64_t *w[4] = {a1, b1, a2, b2};
+    int nd[4];
+    int ndigs = 0;
+    for(int i=0; i<4; i++) {
+        nd[i] = (fw_nbits(w[i], i%2 ? nwb : nwa) + (PyLong_SHIFT-1))/PyLong_SHIFT;
+        ndigs += nd[i];
+    }
+    const int ndp = GF2X_MAX(nd[0] + nd[1], nd[2] + nd[3]);
+    const int ndr = (nbits_r + (PyLong_SHIFT-1))/PyLong_SHIFT;
+    const int nbuf = ndigs + ndp + ndr;
+    digit * restrict buf = ws_push(nbuf);
+    digit *d[4];
+    d[0] = buf;
+    for(int i=1; i<4; i++)
+        d[i] = d[i-1] + nd[i-1];
+    digit *p = d[3] + nd[3];
+    digit *dr = p + ndp;
+    for(int i=0; i<4; i++)
+        fw_to_digits(d[i], nd[i], w[i], nd[i] ? (i%2 ? nwb : nwa) : 0);
+    memset(p, 0, ndp*sizeof(digit));
+    for(int i=0; i<4; i+=2)
+        if(nd[i] && nd[i+1])
+            mul_nl_nr(p, d[i], nd[i], d[i+1], nd[i+1]);
+    rshift_extract(dr, ndr, p, ndp, lo);
+    fw_from_digits(r, (nbits_r + 63)/64, dr, ndr);
+    ws_pop(buf, nbuf);
+}
+
+static void
+bm_solve(int n0, int len, const uint64_t *e, const uint64_t *f, int *L, uint64_t *m, int nwm)
+//
+// As bm_steps, but recursive for long windows, and e and f are left unchanged.
+// Only the bits of e and f below len are used.
+//
+{
+    const int nwl = (len + 63)/64;
+    if(len <= bm_recursive_limit) {
+        uint64_t *t = ws_push_words(2*nwl);
+        memcpy(t, e, nwl*sizeof(uint64_t));
+        memcpy(t + nwl, f, nwl*sizeof(uint64_t));
+        bm_steps(n0, len, t, t + nwl, L, m, nwm);
+        ws_pop_words(t, 2*nwl);
+        return;
+    }
+
+    // First half, in whole words so that its windows are the leading words of e and f
+    const int h = GF2X_MAX(len/2/64, 1)*64;
+    const int nw1 = h/64 + 1;
+    uint64_t *m1 = ws_push_words(4*nw1);
+    bm_solve(n0, h, e, f, L, m1, nw1);
+
+    // Windows of the second half, M1*(e, f) from position h
+    const int nwr = (len - h + 63)/64;
+    uint64_t *e2 = ws_push_words(2*nwr);
+    uint64_t *f2 = e2 + nwr;
+    bm_mul2(e2, h, len - h, m1, e, m1 + nw1, f, nw1, nwl);
+    bm_mul2(f2, h, len - h, m1 + 2*nw1, e, m1 + 3*nw1, f, nw1, nwl);
+
+    const int nw2 = (len - h)/64 + 1;
+    uint64_t *m2 = ws_push_words(4*nw2);
+    bm_solve(n0 + h, len - h, e2, f2, L, m2, nw2);
+
+    // M = M2*M1
+    for(int i=0; i<2; i++)
+        for(int j=0; j<2; j++)
+            bm_mul2(m + (2*i+j)*nwm, 0, 64*nwm,
+                    m2 + 2*i*nw2, m1 + j*nw1, m2 + (2*i+1)*nw2, m1 + (2+j)*nw1, nw2, nw1);
+
+    ws_pop_words(m2, 4*nw2);
+    ws_pop_words(e2, 2*nwr);
+    ws_pop_words(m1, 4*nw1);
+}
+
+static int
+berlekamp_massey(uint64_t *c, const uint64_t *s, int nbits)
+//
+// Store the connection polynomial of the shortest LFSR generating the nbits bits s
+// in c, with nbits/64+1 words, and return its length L
+//
+{
+    const int nws = (nbits + 63)/64;
+    const int nwm = nbits/64 + 1;
+    uint64_t *f = ws_push_words(nws);
+    uint64_t *m = ws_push_words(4*nwm);
+
+    // C = 1 and B = x, with C*S = S and B*S = x*S
+    memcpy(f, s, nws*sizeof(uint64_t));
+    bm_shl1(f, nws);
+    int L = 0;
+    bm_solve(0, nbits, s, f, &L, m, nwm);
+
+    // C = m11*1 + m12*x
+    memcpy(c, m, nwm*sizeof(uint64_t));
+    bm_shl1(m + nwm, nwm);
+    for(int i=0; i<nwm; i++)
+        c[i] ^= m[nwm + i];
+
+    ws_pop_words(m, 4*nwm);
+    ws_pop_words(f, nws);
+    return L;
+}
+
+static PyObject *
+pygf2x_berlekamp_massey(PyObject *self, PyObject *args)
+//
+// berlekamp_massey(bits, nbits=8*len(bits)): (L, C) for the shortest LFSR generating
+// the sequence, where bit i of the sequence is bit i%8 of byte i//8 of the buffer
+//
+{
+    (void)self;
+    Py_buffer buf;
+    Py_ssize_t nbits = -1;
+    if(!PyArg_ParseTuple(args, "y*|n", &buf, &nbits))
+        return NULL;
+    if(nbits == -1)
+        nbits = 8*buf.len;
+    if(nbits < 0 || nbits > 8*buf.len) {
+        PyBuffer_Release(&buf);
+        PyErr_SetString(PyExc_ValueError, "Number of bits is out of range");
+        return NULL;
+    }
+    if(nbits > PYGF2X_MAX_DIGITS*PyLong_SHIFT) {
+        PyBuffer_Release(&buf);
+        PyErr_SetString(PyExc_ValueError, "Sequence is too long");
+        return NULL;
+    }
+
+    const int nws = ((int)nbits + 63)/64;
+    const int nwc = (int)nbits/64 + 1;
+    uint64_t *s = calloc(nws + nwc, sizeof(uint64_t));
+    if(s == NULL) {
+        PyBuffer_Release(&buf);
+        return PyErr_NoMemory();
+    }
+    uint64_t *c = s + nws;
+    const unsigned char *bytes = buf.buf;
+    for(int i=0; i<((int)nbits + 7)/8; i++)
+        s[i/8] |= (uint64_t)bytes[i] << (8*(i%8));
+    if(nbits%64)
+        s[nws-1] &= ((uint64_t)1 << (nbits%64)) - 1;
+    PyBuffer_Release(&buf);
+
+    const int L = berlekamp_massey(c, s, (int)nbits);
+    PyObject *r = Py_BuildValue("iN", L, fw_to_pylong(c, nwc));
+    free(s);
+    return r;
+}
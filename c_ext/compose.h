@@ -0,0 +1,138 @@
+/* -*- mode: c; c-basic-offset: 4; -*- */
+/*******************************************************************************
+ *
+ * Copyright (c) 2021 Oskar Enoksson. All rights reserved.
+ * Licensed under the MIT license. See LICENSE file in the project root for details.
+ *
+ * Description:
+ * Modular composition f(g) mod h (Brent-Kung)
+ *
+ * With f of degree < k*m, split into m blocks of k coefficients
+ *
+ *   f = F_0 + F_1 y^k + ... + F_(m-1) y^(k(m-1)),   deg F_j < k
+ *
+ * f(g) = sum F_j(g) (g^k)^j. With the baby steps g^0 .. g^(k-1) mod h in a table,
+ * each F_j(g) is a sum of table entries selected by the bits of F_j, which is a
+ * product of an m x k and a k x n matrix over GF(2). The giant steps are then
+ * Horner's scheme in g^k. For k = m = sqrt(deg f), that is 2*sqrt(deg f)
+ * multiplications mod h instead of deg f.
+ *
+ * The matrix product is done a group of baby steps at a time (the method of Four
+ * Russians): all 2^t sums of t baby steps are tabulated, and each F_j picks one
+ * by its t bits, so one xor of an element per t coefficients.
+ *
+ * All multiplications go through the Field of h, with its cached reduction.
+ *
+ *******************************************************************************/
+
+#define COMPOSE_MAX_GROUP 8   // Max number of baby steps tabulated together
+
+static inline unsigned
+compose_bits(const digit *f, int ndigs_f, int64_t pos, int nb)
+//
+// The nb <= 8 bits of f from bit pos, zero above the end of f
+//
+{
+    const int64_t i = pos/PyLong_SHIFT;
+    const int s = (int)(pos%PyLong_SHIFT);
+    uint32_t w = i < ndigs_f ? f[i] >> s : 0;
+    if(i+1 < ndigs_f)
+        w |= (uint32_t)f[i+1] << (PyLong_SHIFT - s);
+    return w & ((1u << nb) - 1);
+}
+
+static void
+compose_field(const FieldObject *F, uint64_t *r, const digit *f, int nbits_f, const uint64_t *g)
+//
+// r = f(g) mod h, where h is the modulus of F and g is an element of F
+//
+{
+    const int nv = F->nv;
+    const int ndigs_f = (nbits_f + (PyLong_SHIFT-1))/PyLong_SHIFT;
+    int k = 1;
+    while((int64_t)k*k < nbits_f)
+        k++;
+    const int m = (nbits_f + k-1)/k;
+    int t = 1;
+    while(t < COMPOSE_MAX_GROUP && t < k && (2 << t) <= m)
+        t++;
+
+    const int nbuf = (k + m + (1 << t) + 1)*nv;
+    uint64_t * restrict const buf = ws_push_words(nbuf);
+    uint64_t * restrict const B = buf;             // Baby steps g^i, i<k
+    uint64_t * restrict const A = B + k*nv;        // F_j(g), j<m
+    uint64_t * restrict const T = A + m*nv;        // Sums of a group of baby steps
+    uint64_t * restrict const G = T + (nv << t);   // Giant step g^k
+    field_set_one(F, B);
+    for(int i=1; i<=k; i++)
+        field_mul(F, i < k ? B + i*nv : G, B + (i-1)*nv, g);
+
+    // A = the m x k coefficient matrix times B, t columns at a time
+    memset(A, 0, m*nv*sizeof(uint64_t));
+    for(int i0=0; i0<k; i0+=t) {
+        const int tg = GF2X_MIN(t, k - i0);
+        memset(T, 0, nv*sizeof(uint64_t));
+        for(int i=0; i<tg; i++) {
+            const uint64_t *b = B + (i0 + i)*nv;
+            for(int s=0; s<(1 << i); s++)
+                for(int w=0; w<nv; w++)
+                    T[((1 << i) + s)*nv + w] = T[s*nv + w] ^ b[w];
+        }
+        for(int j=0; j<m; j++) {
+            const unsigned s = compose_bits(f, ndigs_f, (int64_t)j*k + i0, tg);
+            if(s == 0)
+                continue;
+            for(int w=0; w<nv; w++)
+                A[j*nv + w] ^= T[s*nv + w];
+        }
+    }
+
+    // Horner's scheme in g^k
+    memcpy(r, A + (m-1)*nv, nv*sizeof(uint64_t));
+    for(int j=m-2; j>=0; j--) {
+        field_mul(F, r, r, G);
+        for(int w=0; w<nv; w++)
+            r[w] ^= A[j*nv + w];
+    }
+    ws_pop_words(buf, nbuf);
+}
+
+static PyObject *
+pygf2x_compose_mod(PyObject *self, PyObject *args)
+//
+// compose_mod(f, g, h): f(g) mod h, where h is an integer or a Field
+//
+{
+    (void)self;
+    PyObject *f, *g, *modulus;
+    if(!PyArg_ParseTuple(args, "O!OO", &PyLong_Type, &f, &g, &modulus))
+        return NULL;
+    if(((PyVarObject *)f)->ob_size < 0) {
+        PyErr_SetString(PyExc_ValueError, "Polynomial must be non-negative");
+        return NULL;
+    }
+    if(((PyVarObject *)f)->ob_size > PYGF2X_MAX_DIGITS) {
+        PyErr_SetString(PyExc_ValueError, "Polynomial is out of range");
+        return NULL;
+    }
+    FieldObject *F = jump_field(modulus);
+    if(F == NULL)
+        return NULL;
+    PyObject *r = NULL;
+    FieldElementObject *x = field_coerce(F, g);
+    if(x) {
+        FieldElementObject *p = field_element_alloc(F);
+        if(p) {
+            const int nbits_f = (int)_PyLong_NumBits(f);
+            if(nbits_f > 0)
+                compose_field(F, p->v, ((PyLongObject *)f)->ob_digit, nbits_f, x->v);
+            r = field_element_to_long(p);
+            Py_DECREF(p);
+        }
+        Py_DECREF(x);
+    } else if(! PyErr_Occurred()) {
+        PyErr_SetString(PyExc_TypeError, "Argument must be an integer or a field element");
+    }
+    Py_DECREF(F);
+    return r;
+}
@@ -0,0 +1,531 @@
+/* -*- mode: c; c-basic-offset: 4; -*- */
+/*******************************************************************************
+ *
+ * Copyright (c) 2021 Oskar Enoksson. All rights reserved.
+ * Licensed under the MIT license. See LICENSE file in the project root for details.
+ *
+ * Description:
+ * CRC engine for arbitrary generator polynomials of width 1..64
+ *
+ * The parameters follow the Rocksoft model (poly, width, reflect_in, reflect_out,
+ * init, xorout). Internally the register is kept low-aligned and bit-reversed when
+ * reflect_in is set, or left-aligned in 64 bits otherwise, so that both variants
+ * can use 64-bit slicing-by-8 tables regardless of width.
+ *
+ * On targets with a 64x64 bit carry-less multiply instruction, long buffers are
+ * first folded 4x128 bits at a time (as in Intels "Fast CRC Computation Using
+ * PCLMULQDQ Instruction" whitepaper) and only the last folded block and the tail
+ * are fed through the tables.
+ *
+ *******************************************************************************/
+
+#if defined(PYGF2X_USE_SSE_CLMUL) || defined(PYGF2X_USE_ARMV8_CRYPTO)
+#define PYGF2X_CRC_FOLD
+#endif
+
+// Buffers shorter than this are not folded
+#define CRC_FOLD_LIMIT 128
+
+typedef struct {
+    PyObject_HEAD
+    int width;
+    bool reflect_in;
+    bool reflect_out;
+    uint64_t poly;       // Generator polynomial without the x^width term
+    uint64_t init;
+    uint64_t xorout;
+    uint64_t reg_init;   // init in internal register form
+    uint64_t reg;        // Current register, in internal form
+    uint64_t k[4];       // Folding constants x^128, x^192, x^512, x^576 mod poly, in internal bit order
+    uint64_t table[8][256];
+} CRCObject;
+
+static inline uint64_t
+crc_rev64(uint64_t v)
+// Reverse the bit order of a 64-bit word
+{
+    v = ((v >> 1) & 0x5555555555555555ull) | ((v & 0x5555555555555555ull) << 1);
+    v = ((v >> 2) & 0x3333333333333333ull) | ((v & 0x3333333333333333ull) << 2);
+    v = ((v >> 4) & 0x0f0f0f0f0f0f0f0full) | ((v & 0x0f0f0f0f0f0f0f0full) << 4);
+    v = ((v >> 8) & 0x00ff00ff00ff00ffull) | ((v & 0x00ff00ff00ff00ffull) << 8);
+    v = ((v >> 16) & 0x0000ffff0000ffffull) | ((v & 0x0000ffff0000ffffull) << 16);
+    return (v >> 32) | (v << 32);
+}
+
+static inline uint64_t
+crc_rev(uint64_t v, int width)
+// Reverse the bit order of a width-bit word
+{
+    return crc_rev64(v) >> (64 - width);
+}
+
+static inline uint64_t
+crc_load_le64(const uint8_t *p)
+{
+    return (uint64_t)p[0] | ((uint64_t)p[1] << 8) | ((uint64_t)p[2] << 16) | ((uint64_t)p[3] << 24) |
+        ((uint64_t)p[4] << 32) | ((uint64_t)p[5] << 40) | ((uint64_t)p[6] << 48) | ((uint64_t)p[7] << 56);
+}
+
+static inline uint64_t
+crc_load_be64(const uint8_t *p)
+{
+    return ((uint64_t)p[0] << 56) | ((uint64_t)p[1] << 48) | ((uint64_t)p[2] << 40) | ((uint64_t)p[3] << 32) |
+        ((uint64_t)p[4] << 24) | ((uint64_t)p[5] << 16) | ((uint64_t)p[6] << 8) | (uint64_t)p[7];
+}
+
+static inline void
+crc_store_le64(uint8_t *p, uint64_t v)
+{
+    for(int i=0; i<8; i++, v>>=8)
+        p[i] = (uint8_t)v;
+}
+
+static inline void
+crc_store_be64(uint8_t *p, uint64_t v)
+{
+    for(int i=7; i>=0; i--, v>>=8)
+        p[i] = (uint8_t)v;
+}
+
+static uint64_t
+crc_mulmod(const CRCObject *c, uint64_t a, uint64_t b)
+//
+// Multiply two polynomials of degree < width modulo the generator polynomial
+// All values in normal (non-reflected, right-aligned) bit order
+//
+{
+    const int w = c->width;
+    uint64_t h;
+    uint64_t l = mul_64_64(a, b, &h);
+    // Reduce the (2*width-1)-bit product bit by bit from the top
+    for(int ib=2*w-2; ib>=w; ib--) {
+        uint64_t bit = ib >= 64 ? (h >> (ib-64)) & 1 : (l >> ib) & 1;
+        if(bit) {
+            // Subtract (x^w + poly) << (ib-w)
+            int s = ib - w;
+            if(ib >= 64)
+                h ^= (uint64_t)1 << (ib-64);
+            else
+                l ^= (uint64_t)1 << ib;
+            l ^= c->poly << s;
+            if(s)
+                h ^= c->poly >> (64-s);
+        }
+    }
+    return w == 64 ? l : l & (((uint64_t)1 << w) - 1);
+}
+
+static uint64_t
+crc_xpow(const CRCObject *c, uint64_t n)
+//
+// Compute x^n mod poly, by binary powering, in normal bit order
+//
+{
+    const int w = c->width;
+    const uint64_t mask = w == 64 ? ~(uint64_t)0 : (((uint64_t)1 << w) - 1);
+    uint64_t v = 1;
+    for(int ib=63; ib>=0; ib--) {
+        v = crc_mulmod(c, v, v);
+        if((n >> ib) & 1) {
+            // v *= x
+            uint64_t top = (v >> (w-1)) & 1;
+            v = (v << 1) & mask;
+            if(top)
+                v ^= c->poly;
+        }
+    }
+    return v;
+}
+
+static void
+crc_init_tables(CRCObject *c)
+{
+    const int w = c->width;
+    if(c->reflect_in) {
+        const uint64_t rpoly = crc_rev(c->poly, w);
+        for(int i=0; i<256; i++) {
+            uint64_t v = i;
+            for(int j=0; j<8; j++)
+                v = (v >> 1) ^ ((v & 1) ? rpoly : 0);
+            c->table[0][i] = v;
+        }
+        for(int t=1; t<8; t++)
+            for(int i=0; i<256; i++) {
+                uint64_t v = c->table[t-1][i];
+                c->table[t][i] = (v >> 8) ^ c->table[0][v & 0xff];
+            }
+    } else {
+        const uint64_t lpoly = c->poly << (64 - w);
+        for(int i=0; i<256; i++) {
+            uint64_t v = (uint64_t)i << 56;
+            for(int j=0; j<8; j++)
+                v = (v << 1) ^ ((v >> 63) ? lpoly : 0);
+            c->table[0][i] = v;
+        }
+        for(int t=1; t<8; t++)
+            for(int i=0; i<256; i++) {
+                uint64_t v = c->table[t-1][i];
+                c->table[t][i] = (v << 8) ^ c->table[0][v >> 56];
+            }
+    }
+
+    // Folding constants x^128, x^192, x^512, x^576 mod poly, bit-reversed for reflected input
+    static const int kexp[4] = {128, 192, 512, 576};
+    for(int i=0; i<4; i++) {
+        uint64_t k = crc_xpow(c, kexp[i]);
+        c->k[i] = c->reflect_in ? crc_rev64(k) : k;
+    }
+}
+
+static inline uint64_t
+crc_to_normal(const CRCObject *c, uint64_t reg)
+// Convert register from internal to normal bit order
+{
+    return c->reflect_in ? crc_rev(reg, c->width) : reg >> (64 - c->width);
+}
+
+static inline uint64_t
+crc_from_normal(const CRCObject *c, uint64_t v)
+// Convert register from normal to internal bit order
+{
+    return c->reflect_in ? crc_rev(v, c->width) : v << (64 - c->width);
+}
+
+static inline uint64_t
+crc_output(const CRCObject *c, uint64_t normal)
+// Final CRC value from a register in normal bit order
+{
+    return (c->reflect_out ? crc_rev(normal, c->width) : normal) ^ c->xorout;
+}
+
+static inline uint64_t
+crc_input(const CRCObject *c, uint64_t crc)
+// Register in normal bit order from a final CRC value
+{
+    crc ^= c->xorout;
+    return c->reflect_out ? crc_rev(crc, c->width) : crc;
+}
+
+static uint64_t
+crc_slice8(const CRCObject *c, uint64_t reg, const uint8_t *p, size_t n)
+//
+// Update register with n bytes, using slicing-by-8 tables
+//
+{
+    const uint64_t (*t)[256] = c->table;
+    if(c->reflect_in) {
+        for(; n >= 8; n-=8, p+=8) {
+            uint64_t s = reg ^ crc_load_le64(p);
+            reg = t[7][s & 0xff] ^ t[6][(s >> 8) & 0xff] ^ t[5][(s >> 16) & 0xff] ^ t[4][(s >> 24) & 0xff] ^
+                t[3][(s >> 32) & 0xff] ^ t[2][(s >> 40) & 0xff] ^ t[1][(s >> 48) & 0xff] ^ t[0][s >> 56];
+        }
+        for(; n; n--, p++)
+            reg = (reg >> 8) ^ t[0][(reg ^ *p) & 0xff];
+    } else {
+        for(; n >= 8; n-=8, p+=8) {
+            uint64_t s = reg ^ crc_load_be64(p);
+            reg = t[7][s >> 56] ^ t[6][(s >> 48) & 0xff] ^ t[5][(s >> 40) & 0xff] ^ t[4][(s >> 32) & 0xff] ^
+                t[3][(s >> 24) & 0xff] ^ t[2][(s >> 16) & 0xff] ^ t[1][(s >> 8) & 0xff] ^ t[0][s & 0xff];
+        }
+        for(; n; n--, p++)
+            reg = (reg << 8) ^ t[0][(reg >> 56) ^ *p];
+    }
+    return reg;
+}
+
+#ifdef PYGF2X_CRC_FOLD
+//
+// Folding, 128-bit blocks
+//
+// A block is held as two 64-bit words a1 (most significant coefficients) and a0 in normal order.
+// Folding the block over 128+64*j bits forward means a1*x^192 + a0*x^128, which is congruent
+// modulo poly to clmul(a1,k192) ^ clmul(a0,k128), a 128-bit value.
+//
+// In reflected order the words are bit-reversed, and since
+//   rev64(a)*rev64(b) = rev127(a*b)
+// the product needs one extra left shift to become rev128(a*b).
+//
+
+static inline void
+crc_fold_normal(uint64_t *a1, uint64_t *a0, uint64_t k_hi, uint64_t k_lo)
+{
+    uint64_t h1, h0;
+    uint64_t l1 = mul_64_64(*a1, k_hi, &h1);
+    uint64_t l0 = mul_64_64(*a0, k_lo, &h0);
+    *a1 = h1 ^ h0;
+    *a0 = l1 ^ l0;
+}
+
+static inline void
+crc_fold_reflected(uint64_t *a0, uint64_t *a1, uint64_t k_hi, uint64_t k_lo)
+{
+    uint64_t h0, h1;
+    uint64_t l0 = mul_64_64(*a0, k_hi, &h0);
+    uint64_t l1 = mul_64_64(*a1, k_lo, &h1);
+    uint64_t l = l0 ^ l1, h = h0 ^ h1;
+    *a0 = l << 1;
+    *a1 = (h << 1) | (l >> 63);
+}
+
+static uint64_t
+crc_fold(const CRCObject *c, uint64_t reg, const uint8_t *p, size_t n)
+//
+// Update register with n >= 64 bytes, folding 4 lanes of 128 bits
+//
+{
+    DBG_ASSERT(n >= 64);
+    uint64_t a[8];
+    uint8_t buf[64];
+    if(c->reflect_in) {
+        for(int i=0; i<8; i++)
+            a[i] = crc_load_le64(p+8*i);
+        a[0] ^= reg;
+        for(p+=64, n-=64; n >= 64; p+=64, n-=64) {
+            for(int i=0; i<8; i+=2) {
+                crc_fold_reflected(&a[i], &a[i+1], c->k[3], c->k[2]);
+                a[i]   ^= crc_load_le64(p+8*i);
+                a[i+1] ^= crc_load_le64(p+8*i+8);
+            }
+        }
+        // Merge the 4 lanes into the last one
+        for(int i=0; i<6; i+=2) {
+            crc_fold_reflected(&a[i], &a[i+1], c->k[1], c->k[0]);
+            a[i+2] ^= a[i];
+            a[i+3] ^= a[i+1];
+        }
+        crc_store_le64(buf, a[6]);
+        crc_store_le64(buf+8, a[7]);
+    } else {
+        for(int i=0; i<8; i++)
+            a[i] = crc_load_be64(p+8*i);
+        a[0] ^= reg;
+        for(p+=64, n-=64; n >= 64; p+=64, n-=64) {
+            for(int i=0; i<8; i+=2) {
+                crc_fold_normal(&a[i], &a[i+1], c->k[3], c->k[2]);
+                a[i]   ^= crc_load_be64(p+8*i);
+                a[i+1] ^= crc_load_be64(p+8*i+8);
+            }
+        }
+        for(int i=0; i<6; i+=2) {
+            crc_fold_normal(&a[i], &a[i+1], c->k[1], c->k[0]);
+            a[i+2] ^= a[i];
+            a[i+3] ^= a[i+1];
+        }
+        crc_store_be64(buf, a[6]);
+        crc_store_be64(buf+8, a[7]);
+    }
+    // The folded block is congruent to everything seen so far, feed it through the tables
+    // from a zero register, followed by the tail
+    reg = crc_slice8(c, 0, buf, 16);
+    return crc_slice8(c, reg, p, n);
+}
+#endif
+
+static uint64_t
+crc_update(const CRCObject *c, uint64_t reg, const uint8_t *p, size_t n)
+{
+#ifdef PYGF2X_CRC_FOLD
+    if(n >= CRC_FOLD_LIMIT)
+        return crc_fold(c, reg, p, n);
+#endif
+    return crc_slice8(c, reg, p, n);
+}
+
+static int
+crc_get_uint(PyObject *obj, int width, const char *name, uint64_t *value)
+// Convert a non-negative Python integer of at most width bits
+{
+    if(! PyLong_Check(obj)) {
+        PyErr_Format(PyExc_TypeError, "%s must be integer", name);
+        return -1;
+    }
+    if(((PyVarObject *)obj)->ob_size < 0 || _PyLong_NumBits(obj) > (size_t)width) {
+        PyErr_Format(PyExc_ValueError, "%s must be a non-negative integer of at most width bits", name);
+        return -1;
+    }
+    *value = PyLong_AsUnsignedLongLongMask(obj);
+    return 0;
+}
+
+static PyObject *
+crc_new(PyTypeObject *type, PyObject *args, PyObject *kwds)
+//
+// CRC(poly, width, reflect_in=False, reflect_out=False, init=0, xorout=0)
+//
+{
+    static char *kwlist[] = {"poly", "width", "reflect_in", "reflect_out", "init", "xorout", NULL};
+    PyObject *poly_obj, *init_obj = NULL, *xorout_obj = NULL;
+    int width, reflect_in = 0, reflect_out = 0;
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "Oi|ppOO", kwlist,
+                                     &poly_obj, &width, &reflect_in, &reflect_out, &init_obj, &xorout_obj)) {
+        return NULL;
+    }
+    if(width < 1 || width > 64) {
+        PyErr_SetString(PyExc_ValueError, "CRC width must be 1..64");
+        return NULL;
+    }
+
+    // The generator polynomial may be given with or without its leading x^width term
+    uint64_t poly, init = 0, xorout = 0;
+    if(! PyLong_Check(poly_obj) || ((PyVarObject *)poly_obj)->ob_size < 0) {
+        PyErr_SetString(PyExc_TypeError, "poly must be a non-negative integer");
+        return NULL;
+    }
+    if(_PyLong_NumBits(poly_obj) > (size_t)width+1) {
+        PyErr_SetString(PyExc_ValueError, "poly is out of range for width");
+        return NULL;
+    }
+    poly = PyLong_AsUnsignedLongLongMask(poly_obj);
+    if(width < 64)
+        poly &= ((uint64_t)1 << width) - 1;
+    if((init_obj && crc_get_uint(init_obj, width, "init", &init)) ||
+       (xorout_obj && crc_get_uint(xorout_obj, width, "xorout", &xorout)))
+        return NULL;
+
+    CRCObject *c = (CRCObject *)type->tp_alloc(type, 0);
+    if(c == NULL)
+        return NULL;
+    c->width = width;
+    c->reflect_in = reflect_in;
+    c->reflect_out = reflect_out;
+    c->poly = poly;
+    c->init = init;
+    c->xorout = xorout;
+    crc_init_tables(c);
+    c->reg_init = crc_from_normal(c, init);
+    c->reg = c->reg_init;
+
+    return (PyObject *)c;
+}
+
+static void
+crc_dealloc(CRCObject *self)
+{
+    Py_TYPE(self)->tp_free((PyObject *)self);
+}
+
+static PyObject *
+crc_update_method(CRCObject *self, PyObject *args)
+//
+// Feed a bytes-like object through the CRC, return the updated CRC value
+//
+{
+    Py_buffer buf;
+    if (!PyArg_ParseTuple(args, "y*", &buf))
+        return NULL;
+
+    self->reg = crc_update(self, self->reg, buf.buf, buf.len);
+    PyBuffer_Release(&buf);
+
+    return PyLong_FromUnsignedLongLong(crc_output(self, crc_to_normal(self, self->reg)));
+}
+
+static PyObject *
+crc_reset_method(CRCObject *self, PyObject *noargs)
+{
+    (void)noargs;
+    self->reg = self->reg_init;
+
+    Py_INCREF(Py_None);
+    return Py_None;
+}
+
+static PyObject *
+crc_combine_method(CRCObject *self, PyObject *args)
+//
+// Return the CRC of the concatenation A+B, given crc1=CRC(A), crc2=CRC(B) and len2=len(B)
+//
+// In normal bit order, with registers reg_X (before reflect_out and xorout):
+//   reg_AB = reg_A*x^(8*len2) + B*x^w
+//   reg_B  = init*x^(8*len2) + B*x^w
+// so reg_AB = reg_B + (reg_A + init)*x^(8*len2) mod poly
+//
+{
+    PyObject *crc1_obj, *crc2_obj, *len2_obj;
+    if (!PyArg_ParseTuple(args, "OOO", &crc1_obj, &crc2_obj, &len2_obj))
+        return NULL;
+
+    uint64_t crc1, crc2, len2;
+    if(crc_get_uint(crc1_obj, self->width, "crc1", &crc1) ||
+       crc_get_uint(crc2_obj, self->width, "crc2", &crc2) ||
+       crc_get_uint(len2_obj, 64, "len2", &len2))
+        return NULL;
+    if(len2 > (~(uint64_t)0 >> 3)) {
+        PyErr_SetString(PyExc_OverflowError, "len2 is out of range");
+        return NULL;
+    }
+
+    uint64_t reg_a = crc_input(self, crc1);
+    uint64_t reg_b = crc_input(self, crc2);
+    uint64_t shift = crc_xpow(self, 8*len2);
+    uint64_t reg_ab = reg_b ^ crc_mulmod(self, reg_a ^ self->init, shift);
+
+    return PyLong_FromUnsignedLongLong(crc_output(self, reg_ab));
+}
+
+static PyObject *
+crc_get_value(CRCObject *self, void *closure)
+{
+    (void)closure;
+    return PyLong_FromUnsignedLongLong(crc_output(self, crc_to_normal(self, self->reg)));
+}
+
+static PyObject *
+crc_get_width(CRCObject *self, void *closure)
+{
+    (void)closure;
+    return PyLong_FromLong(self->width);
+}
+
+static PyObject *
+crc_get_poly(CRCObject *self, void *closure)
+{
+    (void)closure;
+    return PyLong_FromUnsignedLongLong(self->poly);
+}
+
+static PyMethodDef crc_methods[] =
+    {
+        {
+            "update",
+            (PyCFunction)crc_update_method,
+            METH_VARARGS,
+            "Feed a bytes-like object through the CRC, return the updated CRC value"
+        },
+        {
+            "reset",
+            (PyCFunction)crc_reset_method,
+            METH_NOARGS,
+            "Restart the CRC from the initial value"
+        },
+        {
+            "combine",
+            (PyCFunction)crc_combine_method,
+            METH_VARARGS,
+            "combine(crc1, crc2, len2): CRC of the concatenation of two buffers, given their CRCs and the length of the second"
+        },
+        {NULL, NULL, 0, NULL}
+    };
+
+static PyGetSetDef crc_getset[] =
+    {
+        {"value", (getter)crc_get_value, NULL, "Current CRC value", NULL},
+        {"width", (getter)crc_get_width, NULL, "CRC width in bits", NULL},
+        {"poly", (getter)crc_get_poly, NULL, "Generator polynomial, without the x^width term", NULL},
+        {NULL, NULL, NULL, NULL, NULL}
+    };
+
+static PyTypeObject CRCType =
+    {
+        PyVarObject_HEAD_INIT(NULL, 0)
+        .tp_name = "pygf2x.CRC",
+        .tp_basicsize = sizeof(CRCObject),
+        .tp_itemsize = 0,
+        .tp_dealloc = (destructor)crc_dealloc,
+        .tp_flags = Py_TPFLAGS_DEFAULT,
+        .tp_doc = "CRC(poly, width, reflect_in=False, reflect_out=False, init=0, xorout=0)\n"
+                  "CRC engine for an arbitrary generator polynomial of width 1..64 (Rocksoft model)",
+        .tp_methods = crc_methods,
+        .tp_getset = crc_getset,
+        .tp_new = crc_new,
+    };
@@ -12,6 +12,7 @@ static void
 //
 // A very simple bitwise Euclidean division implementation
 // For comparison, or for for very small numerator/denominator
+// The quotient is not stored if q_digits is NULL
 //
 div_bitwise(digit * restrict q_digits,
             digit * restrict r_digits,
@@ -26,7 +27,8 @@ div_bitwise(digit * restrict q_digits,
             int ib_q  = ib_r - nbits_d +1;
             int id_q  = ib_q/PyLong_SHIFT;       // Digit position
             int ibd_q = ib_q%PyLong_SHIFT;       // Bit position in digit
-            q_digits[id_q] |= (1<<ibd_q);
+            if(q_digits)
+                q_digits[id_q] |= (1<<ibd_q);
             for(int ib_d  = nbits_d-1; ib_d >= 0 ; ib_d--) {
                 int id_d  = ib_d/PyLong_SHIFT;   // Digit position
                 int ibd_d = ib_d%PyLong_SHIFT;   // Bit position in digit
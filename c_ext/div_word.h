@@ -0,0 +1,189 @@
+/* -*- mode: c; c-basic-offset: 4; -*- */
+/*******************************************************************************
+ *
+ * Copyright (c) 2021 Oskar Enoksson. All rights reserved.
+ * Licensed under the MIT license. See LICENSE file in the project root for details.
+ *
+ * Description:
+ * Division of unlimited polynomials over GF(2) by denominators of at most 64 bits
+ *
+ * The remainder by a denominator d = x^n + p of degree n <= 63 fits in one 64-bit
+ * word r. The numerator is fed into r from the most significant end, a chunk of bits
+ * at a time, and each chunk gives the quotient bits at the same positions. Starting
+ * from r = 0 and feeding all of u keeps the chunks aligned to whole digits or words.
+ *
+ * With a 64x64 bit carry-less multiply instruction, a whole 64-bit word w is fed at a
+ * time by Barrett reduction. With mu = x^(n+64)/d = x^64 + mu_l and the leading 64
+ * bits a of r*x^64 + w, the quotient and new remainder are
+ *
+ *   q  = (a*mu) >> 64 = a + (a*mu_l >> 64)
+ *   r' = (w + q*p) mod x^n
+ *
+ * Otherwise s bits are fed at a time, as in a table driven CRC, with s dividing the
+ * digit size. The leading s bits h of r*x^s + chunk give both the quotient bits
+ * Q[h] = (h*x^n)/d and what to cancel from the remainder T[h] = (h*x^n)%d:
+ *
+ *   r' = (r*x^s + chunk + T[h]) mod x^n
+ *
+ * Both tables are linear in h, so they are built from their s single bit entries.
+ *
+ *******************************************************************************/
+
+#define DIV_WORD_MAX_BITS 64        // Largest denominator in bits
+
+static inline uint64_t
+div_word_get(const digit *d, int lo, int t)
+//
+// Return bits lo .. lo+t-1 of d, where 1 <= t <= 64
+//
+{
+    int id = lo/PyLong_SHIFT;
+    int off = lo%PyLong_SHIFT;
+    uint64_t v = 0;
+    for(int got=0; got<t; got+=PyLong_SHIFT-off, off=0, id++)
+        v |= (uint64_t)(d[id] >> off) << got;
+    return t < 64 ? v & (((uint64_t)1 << t) - 1) : v;
+}
+
+static inline void
+div_word_put(digit *d, int lo, uint64_t v, int t)
+//
+// d |= v << lo, where v has at most t bits, 1 <= t <= 64
+//
+{
+    int id = lo/PyLong_SHIFT;
+    int off = lo%PyLong_SHIFT;
+    for(int put=0; put<t; put+=PyLong_SHIFT-off, off=0, id++)
+        d[id] |= (digit)(v >> put << off) & PyLong_MASK;
+}
+
+#ifdef PYGF2X_HAVE_MUL_128
+
+static uint64_t
+div_word_feed(digit * restrict q_digits, const digit *u_digits,
+              int nbits_u, uint64_t d, int n)
+//
+// Feed u into the remainder one word at a time, return the remainder
+//
+{
+    const uint64_t mask = ((uint64_t)1 << n) - 1;
+    const uint64_t p = d & mask;
+    const int nbits_q = nbits_u - n;
+
+    // mu_l, the 64 bits of x^(n+64)/d below x^64, by bitwise long division
+    uint64_t mu = 1;
+    uint64_t t = p;
+    for(int i=0; i<64; i++) {
+        const uint64_t top = (t >> (n-1)) & 1;
+        mu = (mu << 1) | top;
+        t = ((t << 1) ^ (top ? d : 0)) & mask;
+    }
+
+    uint64_t r = 0;
+    for(int lo = (nbits_u-1)/64*64; lo >= 0; lo -= 64) {
+        const uint64_t w = div_word_get(u_digits, lo, GF2X_MIN(64, nbits_u - lo));
+        const uint64_t a = (r << (64 - n)) | (w >> n);
+        uint64_t h;
+        mul_64_64(a, mu, &h);
+        const uint64_t q = a ^ h;
+        r = (w ^ mul_64_64(q, p, &h)) & mask;
+        if(q && lo < nbits_q && q_digits)
+            div_word_put(q_digits, lo, q, GF2X_MIN(64, nbits_q - lo));
+    }
+    return r;
+}
+
+#else
+
+static inline uint64_t
+div_word_feed_table(digit * restrict q_digits, const digit *u_digits,
+                    int nbits_u, uint64_t d, int n, const int s)
+//
+// Feed u into the remainder s bits at a time, return the remainder
+// Inlined with s constant
+//
+{
+    const uint64_t mask = ((uint64_t)1 << n) - 1;
+    const digit smask = ((digit)1 << s) - 1;
+
+    // Tables, starting with the single bit entries x^(n+i) = Q*d + T
+    digit Q[1 << 10];
+    uint64_t T[1 << 10];
+    Q[0] = 0;
+    T[0] = 0;
+    {
+        digit q = 1;
+        uint64_t t = d & mask;
+        for(int i=0; i<s; i++) {
+            Q[1 << i] = q;
+            T[1 << i] = t;
+            const uint64_t top = (t >> (n-1)) & 1;
+            q = (q << 1) | (digit)top;
+            t = ((t << 1) ^ (top ? d : 0)) & mask;
+        }
+    }
+    for(int h=3; h<(1 << s); h++) {
+        const int low = h & -h;
+        if(h != low) {
+            Q[h] = Q[h ^ low] ^ Q[low];
+            T[h] = T[h ^ low] ^ T[low];
+        }
+    }
+
+    const int ndigs_u = (nbits_u + (PyLong_SHIFT-1))/PyLong_SHIFT;
+    const int ndigs_q = (nbits_u - n + (PyLong_SHIFT-1))/PyLong_SHIFT;
+    uint64_t r = 0;
+    for(int id=ndigs_u-1; id>=0; id--) {
+        const digit u = u_digits[id];
+        digit q = 0;
+        for(int ib=PyLong_SHIFT-s; ib>=0; ib-=s) {
+            const digit c = (u >> ib) & smask;
+            const unsigned h = n >= s ? (unsigned)(r >> (n - s)) : (unsigned)((r << (s - n)) | (c >> n));
+            q = (q << s) | Q[h];
+            r = ((r << s) ^ c ^ T[h]) & mask;
+        }
+        if(id < ndigs_q && q_digits)
+            q_digits[id] = q;
+    }
+    return r;
+}
+
+static uint64_t
+div_word_feed(digit * restrict q_digits, const digit *u_digits,
+              int nbits_u, uint64_t d, int n)
+//
+// Feed u into the remainder, with larger tables for longer numerators
+//
+{
+#if (PyLong_SHIFT == 30)
+    if(nbits_u >= 16384)
+        return div_word_feed_table(q_digits, u_digits, nbits_u, d, n, 10);
+    return div_word_feed_table(q_digits, u_digits, nbits_u, d, n, 6);
+#elif (PyLong_SHIFT == 15)
+    return div_word_feed_table(q_digits, u_digits, nbits_u, d, n, 5);
+#else
+#error
+#endif
+}
+
+#endif // PYGF2X_HAVE_MUL_128
+
+static void
+div_word(digit * restrict q_digits,
+         digit * restrict r_digits,
+         const digit * restrict d_digits,
+         int nbits_u, int nbits_d)
+//
+// Euclidean division of u by d, where 2 <= nbits_d <= min(nbits_u, DIV_WORD_MAX_BITS)
+// Same conventions as divmod_digits: r_digits holds u on entry and q_digits is zeroed,
+// or NULL if the quotient is not wanted
+//
+{
+    const int n = nbits_d - 1;
+    const uint64_t d = div_word_get(d_digits, 0, nbits_d);
+    const uint64_t r = div_word_feed(q_digits, r_digits, nbits_u, d, n);
+
+    const int ndigs_r = (nbits_u + (PyLong_SHIFT-1))/PyLong_SHIFT;
+    memset(r_digits, 0, ndigs_r*sizeof(digit));
+    div_word_put(r_digits, 0, r, n);
+}
@@ -0,0 +1,146 @@
+/* -*- mode: c; c-basic-offset: 4; -*- */
+/*******************************************************************************
+ *
+ * Copyright (c) 2021 Oskar Enoksson. All rights reserved.
+ * Licensed under the MIT license. See LICENSE file in the project root for details.
+ *
+ * Description:
+ * Exact division over GF(2), from the low end
+ *
+ * If d divides a, then with d = x^t d' and d' odd, also x^t divides a, and
+ * q = (a >> t)/d' has nq = |a| - |d| + 1 bits. Those are the low bits of
+ *
+ *   q = (a >> t) * d'^-1   (mod x^nq)
+ *
+ * where d'^-1 is the x-adic inverse (rinverse). Only the low nq bits of a and d take
+ * part, and there is no remainder to compute.
+ *
+ * The high bits of q are as easily found from the high end: with q = q1 x^s + q0
+ * and |q0| <= s, q0*d is shorter than x^s d, so q1 is the quotient of a >> s by d.
+ * So the low s bits are done by the inverse from the low end and the rest by the
+ * quotient-only division (divmod_digits without the remainder), each of about half
+ * the length. To keep the inverse from the low end no longer than the one of the
+ * division, s is at most |d|, and short quotients are done from the low end only.
+ *
+ *******************************************************************************/
+
+#define DIVEXACT_SPLIT_BITS 1024    // Quotient bits up to which only the low end is used
+
+static void
+divexact_digits(digit * restrict q_digits, int nbits_q,
+                const digit *a_digits, int ndigs_a, const digit *d_digits, int ndigs_d, int t)
+//
+// q = (a >> t)/(d >> t) mod x^nbits_q, where d >> t is odd and q has room for nbits_q bits
+//
+{
+    const int ndigs_q = (nbits_q + (PyLong_SHIFT-1))/PyLong_SHIFT;
+    const int nbuf = 3*ndigs_q;
+    digit * restrict const a = ws_push(nbuf);
+    digit * restrict const d = a + ndigs_q;
+    digit * restrict const e = d + ndigs_q;
+    rshift_extract(a, ndigs_q, a_digits, ndigs_a, t);
+    rshift_extract(d, ndigs_q, d_digits, ndigs_d, t);
+    rinverse(e, ndigs_q, nbits_q, d, ndigs_q);
+    memset(q_digits, 0, ndigs_q*sizeof(digit));
+    mullo(q_digits, a, ndigs_q, e, ndigs_q, ndigs_q);
+    if(nbits_q % PyLong_SHIFT)
+        q_digits[ndigs_q-1] &= ((digit)1 << (nbits_q % PyLong_SHIFT)) - 1;
+    ws_pop(a, nbuf);
+}
+
+static void
+divexact_split(digit * restrict q_digits, int nbits_q,
+               const digit *a_digits, int nbits_a, const digit *d_digits, int nbits_d, int t)
+//
+// q = a/d, where d divides a, q has nbits_q bits and d has t trailing zeros.
+// q is zeroed on entry.
+//
+{
+    const int ndigs_a = (nbits_a + (PyLong_SHIFT-1))/PyLong_SHIFT;
+    const int ndigs_d = (nbits_d + (PyLong_SHIFT-1))/PyLong_SHIFT;
+    // Short denominators are divided by from the high end in linear time (div_word)
+    const int s = nbits_d <= DIV_WORD_MAX_BITS ? 0 :
+        nbits_q <= DIVEXACT_SPLIT_BITS ? nbits_q : GF2X_MIN(nbits_q/2, nbits_d);
+    if(s > 0)
+        divexact_digits(q_digits, s, a_digits, ndigs_a, d_digits, ndigs_d, t);
+    if(s == nbits_q)
+        return;
+
+    // q1 = (a >> s)/d, of at least one bit, added at bit s of q
+    const int nbits_u = nbits_a - s;
+    const int ndigs_u = (nbits_u + (PyLong_SHIFT-1))/PyLong_SHIFT;
+    const int ndigs_q1 = s ? (nbits_q - s + (PyLong_SHIFT-1))/PyLong_SHIFT : 0;
+    const int nbuf = ndigs_u + ndigs_q1;
+    digit * restrict const u = ws_push(nbuf);
+    digit * restrict const q1 = s ? u + ndigs_u : q_digits;
+    if(s)
+        rshift_extract(u, ndigs_u, a_digits, ndigs_a, s);
+    else
+        memcpy(u, a_digits, ndigs_u*sizeof(digit));
+    memset(q1, 0, ndigs_q1*sizeof(digit));
+    divmod_digits(q1, u, d_digits, nbits_u, nbits_d, DIVMOD_Q);
+    const int nd_shift = s/PyLong_SHIFT;
+    const int nb_shift = s%PyLong_SHIFT;
+    const int ndigs_q = (nbits_q + (PyLong_SHIFT-1))/PyLong_SHIFT;
+    for(int i=0; i<ndigs_q1; i++) {
+        q_digits[nd_shift+i] |= (q1[i] << nb_shift) & PyLong_MASK;
+        if(nb_shift && nd_shift+i+1 < ndigs_q)
+            q_digits[nd_shift+i+1] |= q1[i] >> (PyLong_SHIFT - nb_shift);
+    }
+    ws_pop(u, nbuf);
+}
+
+static PyObject *
+pygf2x_divexact(PyObject *self, PyObject *args)
+//
+// divexact(a, d): the quotient a/d, where d is known to divide a. The result is
+// undefined if it does not, but a ValueError is raised when that is seen without
+// extra work: if a is shorter than d, or has fewer trailing zeros.
+//
+{
+    (void)self;
+    PyLongObject *a, *d;
+    if(!PyArg_ParseTuple(args, "O!O!", &PyLong_Type, &a, &PyLong_Type, &d))
+        return NULL;
+    if(((PyVarObject *)a)->ob_size < 0 || ((PyVarObject *)d)->ob_size < 0) {
+        PyErr_SetString(PyExc_ValueError, "Both arguments must be non-negative");
+        return NULL;
+    }
+    if(((PyVarObject *)a)->ob_size > PYGF2X_MAX_DIGITS || ((PyVarObject *)d)->ob_size > PYGF2X_MAX_DIGITS) {
+        PyErr_SetString(PyExc_ValueError, "Numerator or denominator out of range");
+        return NULL;
+    }
+    const int ndigs_a = ((PyVarObject *)a)->ob_size;
+    const int ndigs_d = ((PyVarObject *)d)->ob_size;
+    if(ndigs_d == 0) {
+        PyErr_SetString(PyExc_ZeroDivisionError, "Denominator is zero");
+        return NULL;
+    }
+    if(ndigs_a == 0)
+        return PyLong_FromLong(0);
+
+    // Trailing zeros of d, which must be trailing zeros of a too
+    int t = 0;
+    while(d->ob_digit[t/PyLong_SHIFT] == 0)
+        t += PyLong_SHIFT;
+    while(((d->ob_digit[t/PyLong_SHIFT] >> (t%PyLong_SHIFT)) & 1) == 0)
+        t++;
+    const int nbits_q = nbits(a) - nbits(d) + 1;
+    bool exact = nbits_q > 0;
+    for(int i=0; exact && i<=t/PyLong_SHIFT; i++) {
+        const int nb = GF2X_MIN(PyLong_SHIFT, t - i*PyLong_SHIFT);
+        exact = (a->ob_digit[i] & (((digit)1 << nb) - 1)) == 0;
+    }
+    if(! exact) {
+        PyErr_SetString(PyExc_ValueError, "Division is not exact");
+        return NULL;
+    }
+
+    const int ndigs_q = (nbits_q + (PyLong_SHIFT-1))/PyLong_SHIFT;
+    PyLongObject *q = pylong_new(ndigs_q);
+    if(q == NULL)
+        return NULL;
+    memset(q->ob_digit, 0, ndigs_q*sizeof(digit));
+    divexact_split(q->ob_digit, nbits_q, a->ob_digit, nbits(a), d->ob_digit, nbits(d), t);
+    return pylong_trim(q, ndigs_q);
+}
@@ -0,0 +1,1051 @@
+/* -*- mode: c; c-basic-offset: 4; -*- */
+/*******************************************************************************
+ *
+ * Copyright (c) 2021 Oskar Enoksson. All rights reserved.
+ * Licensed under the MIT license. See LICENSE file in the project root for details.
+ *
+ * Description:
+ * Finite field GF(2^n) = GF(2)[x]/f, with elements bound to a cached modulus context
+ *
+ * A Field object holds everything that depends only on the modulus f: its inverse
+ * for Barrett reduction, or the term list if f is sparse enough to reduce by shifts,
+ * and the trace vector. Elements of fields of degree up to 576 are stored in 1, 2, 4
+ * or 9 64-bit words and use the fixed-width kernels, larger fields are stored as
+ * Python digits and use the general multiplication.
+ *
+ *******************************************************************************/
+
+#define FIELD_MAX_WORDS 9   // 576 bits, enough for the largest standard binary field (571)
+#define FIELD_MAX_SPARSE 4  // Max number of terms below x^n for reduction by shifts
+
+typedef struct {
+    PyObject_HEAD
+    PyObject *modulus;      // Python integer
+    int n;                  // Degree of the modulus
+    int nw;                 // Number of words of fixed-width elements, or 0
+    int nv;                 // Number of 64-bit words used to store an element
+    int nsparse;            // Number of terms of f below x^n if f is reduced by shifts, else 0
+    int sparse[FIELD_MAX_SPARSE];
+    uint64_t f[FIELD_MAX_WORDS+1];  // Modulus, when nw>0
+    uint64_t e[FIELD_MAX_WORDS];    // Inverse of modulus with n bits, when nw>0
+    gf2x_modulus mod;       // Reduction context, when nw==0
+    uint64_t *trace;        // Tr(x^i) for 0<=i<n as bit vector, computed on first use
+} FieldObject;
+
+typedef struct {
+    PyObject_VAR_HEAD
+    FieldObject *field;
+    uint64_t v[1];          // nv words, holding 64-bit words if nw>0 or else digits
+} FieldElementObject;
+
+static PyTypeObject FieldType;
+static PyTypeObject FieldElementType;
+
+#define FieldElement_Check(op) PyObject_TypeCheck(op, &FieldElementType)
+
+//
+// Arithmetic on fixed-width elements
+//
+
+static inline void
+field_reduce_fw(const FieldObject *F, uint64_t * restrict r, uint64_t * restrict c, int nw)
+//
+// r = c mod f, where c has 2*nw words and is overwritten
+//
+{
+    uint64_t t[FIELD_MAX_WORDS] = {0};  // Zeroed since gcc cannot tell that nw words are set before use
+    if(F->nsparse) {
+        // Fold the part above x^n back onto the low terms of f until nothing is left
+        for(;;) {
+            uint64_t nz = 0;
+            fw_rshift(t, c, 2*nw, F->n, nw);
+            for(int i=0; i<nw; i++)
+                nz |= t[i];
+            if(!nz)
+                break;
+            fw_truncate(c, 2*nw, F->n);
+            for(int k=0; k<F->nsparse; k++)
+                fw_xor_lshift(c, t, nw, F->sparse[k]);
+        }
+        memcpy(r, c, nw*sizeof(uint64_t));
+    } else {
+        // Barrett, see modulus.h
+        uint64_t te[2*FIELD_MAX_WORDS];
+        uint64_t q[FIELD_MAX_WORDS];
+        uint64_t qf[FIELD_MAX_WORDS];
+        fw_rshift(t, c, 2*nw, F->n, nw);
+        fw_mul(te, t, F->e, nw);
+        fw_rshift(q, te, 2*nw, F->n-1, nw);
+        fw_mullo(qf, q, F->f, nw);
+        for(int i=0; i<nw; i++)
+            r[i] = c[i] ^ qf[i];
+        fw_truncate(r, nw, F->n);
+    }
+}
+
+static inline void
+field_mul_fw(const FieldObject *F, uint64_t *r, const uint64_t *a, const uint64_t *b, int nw)
+{
+    uint64_t p[2*FIELD_MAX_WORDS];
+    fw_mul(p, a, b, nw);
+    field_reduce_fw(F, r, p, nw);
+}
+
+static inline void
+field_sqr_fw(const FieldObject *F, uint64_t *r, const uint64_t *a, int nw)
+{
+    uint64_t p[2*FIELD_MAX_WORDS];
+    fw_sqr(p, a, nw);
+    field_reduce_fw(F, r, p, nw);
+}
+
+//
+// Arithmetic on elements stored as digits
+//
+
+static int
+field_ndigs(const digit *a, int nd)
+// Number of digits without leading zeros
+{
+    while(nd > 0 && a[nd-1] == 0)
+        nd--;
+    return nd;
+}
+
+static void
+field_reduce_big(const FieldObject *F, digit * restrict r, const digit *c, int ndigs_c)
+//
+// r = c mod f, where c has at most 2n bits, by shifts if f is sparse and else by Barrett
+//
+{
+    if(! F->nsparse) {
+        modulus_reduce(&F->mod, r, c, ndigs_c);
+        return;
+    }
+    const int n = F->n;
+    const int nd = F->mod.ndigs_r;
+    const int nt = 2*nd + 1;
+    digit * restrict t = ws_push(nt + nd);
+    digit * restrict h = t + nt;
+    memcpy(t, c, ndigs_c*sizeof(digit));
+    memset(t + ndigs_c, 0, (nt - ndigs_c)*sizeof(digit));
+
+    // Fold the part above x^n back onto the low terms of f until nothing is left
+    for(;;) {
+        rshift_extract(h, nd, t, nt, n);
+        const int nh = field_ndigs(h, nd);
+        if(nh == 0)
+            break;
+        memset(t + n/PyLong_SHIFT + 1, 0, (nt - n/PyLong_SHIFT - 1)*sizeof(digit));
+        t[n/PyLong_SHIFT] &= ((digit)1 << (n%PyLong_SHIFT)) - 1;
+        for(int k=0; k<F->nsparse; k++) {
+            const int ds = F->sparse[k]/PyLong_SHIFT;
+            const int bs = F->sparse[k]%PyLong_SHIFT;
+            for(int i=0; i<nh; i++) {
+                t[i+ds] ^= (digit)(h[i] << bs) & PyLong_MASK;
+                if(bs)
+                    t[i+ds+1] ^= h[i] >> (PyLong_SHIFT - bs);
+            }
+        }
+    }
+    memcpy(r, t, nd*sizeof(digit));
+    ws_pop(t, nt + nd);
+}
+
+static void
+field_mul_big(const FieldObject *F, digit *r, const digit *a, const digit *b)
+{
+    const int nd = F->mod.ndigs_r;
+    const int na = field_ndigs(a, nd);
+    const int nb = field_ndigs(b, nd);
+    if(na == 0 || nb == 0) {
+        memset(r, 0, nd*sizeof(digit));
+        return;
+    }
+    digit * restrict p = ws_push(na+nb);
+    memset(p, 0, (na+nb)*sizeof(digit));
+    mul_nl_nr(p, a, na, b, nb);
+    field_reduce_big(F, r, p, na+nb);
+    ws_pop(p, na+nb);
+}
+
+static void
+field_sqr_big(const FieldObject *F, digit *r, const digit *a)
+{
+    const int nd = F->mod.ndigs_r;
+    const int na = field_ndigs(a, nd);
+    if(na == 0) {
+        memset(r, 0, nd*sizeof(digit));
+        return;
+    }
+    digit * restrict p = ws_push(2*na);
+    square_n(p, a, na);
+    field_reduce_big(F, r, p, 2*na);
+    ws_pop(p, 2*na);
+}
+
+//
+// Dispatch to the kernels of the field width. r may alias a or b.
+//
+
+static void
+field_mul(const FieldObject *F, uint64_t *r, const uint64_t *a, const uint64_t *b)
+{
+    switch(F->nw) {
+    case 1: field_mul_fw(F, r, a, b, 1); break;
+    case 2: field_mul_fw(F, r, a, b, 2); break;
+    case 4: field_mul_fw(F, r, a, b, 4); break;
+    case FIELD_MAX_WORDS: field_mul_fw(F, r, a, b, FIELD_MAX_WORDS); break;
+    default: field_mul_big(F, (digit *)r, (const digit *)a, (const digit *)b);
+    }
+}
+
+static void
+field_sqr(const FieldObject *F, uint64_t *r, const uint64_t *a)
+{
+    switch(F->nw) {
+    case 1: field_sqr_fw(F, r, a, 1); break;
+    case 2: field_sqr_fw(F, r, a, 2); break;
+    case 4: field_sqr_fw(F, r, a, 4); break;
+    case FIELD_MAX_WORDS: field_sqr_fw(F, r, a, FIELD_MAX_WORDS); break;
+    default: field_sqr_big(F, (digit *)r, (const digit *)a);
+    }
+}
+
+static void
+field_mulx(const FieldObject *F, uint64_t *a)
+//
+// a = x*a, by a shift and adding f if the shifted out bit x^n is set
+//
+{
+    const int n = F->n;
+    if(F->nw) {
+        const uint64_t top = (a[(n-1)/64] >> ((n-1)%64)) & 1;
+        uint64_t carry = 0;
+        for(int i=0; i<F->nw; i++) {
+            const uint64_t t = a[i];
+            a[i] = (t << 1) | carry;
+            carry = t >> 63;
+        }
+        if(top)
+            for(int i=0; i<F->nw; i++)
+                a[i] ^= F->f[i];
+    } else {
+        digit *d = (digit *)a;
+        const int nd = F->mod.ndigs_r;
+        const digit top = (d[(n-1)/PyLong_SHIFT] >> ((n-1)%PyLong_SHIFT)) & 1;
+        digit carry = 0;
+        for(int i=0; i<nd; i++) {
+            const digit t = d[i];
+            d[i] = ((t << 1) | carry) & PyLong_MASK;
+            carry = t >> (PyLong_SHIFT-1);
+        }
+        if(top)
+            for(int i=0; i<nd; i++)
+                d[i] ^= F->mod.f[i];
+    }
+}
+
+static bool
+field_is_zero(const FieldObject *F, const uint64_t *a)
+// Only the digits in use are looked at if the elements are stored as digits
+{
+    if(F->nw == 0)
+        return field_ndigs((const digit *)a, F->mod.ndigs_r) == 0;
+    for(int i=0; i<F->nv; i++)
+        if(a[i])
+            return false;
+    return true;
+}
+
+static void
+field_set_one(const FieldObject *F, uint64_t *a)
+{
+    memset(a, 0, F->nv*sizeof(uint64_t));
+    if(F->nw)
+        a[0] = 1;
+    else
+        ((digit *)a)[0] = 1;
+}
+
+static bool
+field_is_one(const FieldObject *F, const uint64_t *a)
+{
+    uint64_t one[FIELD_MAX_WORDS];
+    if(F->nw) {
+        field_set_one(F, one);
+        return memcmp(a, one, F->nv*sizeof(uint64_t)) == 0;
+    }
+    const digit *d = (const digit *)a;
+    return d[0] == 1 && field_ndigs(d, F->mod.ndigs_r) == 1;
+}
+
+static bool
+field_equal(const FieldObject *F, const uint64_t *a, const uint64_t *b)
+//
+// a == b, comparing only the digits in use if the elements are stored as digits,
+// since the kernels leave the padding of the last word alone
+//
+{
+    if(F->nw)
+        return memcmp(a, b, F->nv*sizeof(uint64_t)) == 0;
+    return memcmp(a, b, F->mod.ndigs_r*sizeof(digit)) == 0;
+}
+
+static bool
+field_is_x(const FieldObject *F, const uint64_t *a)
+{
+    if(F->nw)
+        return a[0] == 2 && fw_nbits(a, F->nw) == 2;
+    const digit *d = (const digit *)a;
+    return d[0] == 2 && field_ndigs(d, F->mod.ndigs_r) == 1;
+}
+
+static void
+field_pow_digits(const FieldObject *F, uint64_t *r, const uint64_t *a,
+                 const digit *k, int nbits_k, uint64_t *tmp)
+//
+// r = a^k, left-to-right binary powering, where k has nbits_k>0 bits
+// tmp is an nv-word work area, r must not alias a
+//
+{
+    memcpy(r, a, F->nv*sizeof(uint64_t));
+    for(int i=nbits_k-2; i>=0; i--) {
+        field_sqr(F, tmp, r);
+        if((k[i/PyLong_SHIFT] >> (i%PyLong_SHIFT)) & 1)
+            field_mul(F, r, tmp, a);
+        else
+            memcpy(r, tmp, F->nv*sizeof(uint64_t));
+    }
+}
+
+static void
+field_xpow(const FieldObject *F, uint64_t *r, const digit *k, int nbits_k)
+//
+// r = x^k, left-to-right binary powering where multiplying by the base is field_mulx.
+// The leading bits of k are taken as they are, for as long as x^k needs no reduction.
+//
+{
+    int v = 0;
+    int i = nbits_k-1;
+    for(; i>=0; i--) {
+        const int b = (k[i/PyLong_SHIFT] >> (i%PyLong_SHIFT)) & 1;
+        if(2*v + b >= F->n)
+            break;
+        v = 2*v + b;
+    }
+    memset(r, 0, F->nv*sizeof(uint64_t));
+    if(F->nw)
+        r[v/64] = (uint64_t)1 << (v%64);
+    else
+        ((digit *)r)[v/PyLong_SHIFT] = (digit)1 << (v%PyLong_SHIFT);
+    for(; i>=0; i--) {
+        field_sqr(F, r, r);
+        if((k[i/PyLong_SHIFT] >> (i%PyLong_SHIFT)) & 1)
+            field_mulx(F, r);
+    }
+}
+
+static int
+field_inverse(const FieldObject *F, uint64_t *r, const uint64_t *a)
+//
+// r = a^-1 by Itoh-Tsujii: a^-1 = a^(2^n-2) = (a^(2^(n-1)-1))^2, where
+// b_k = a^(2^k-1) is built along the binary expansion of n-1 using
+//   b_2k = b_k^(2^k) * b_k
+//   b_k+1 = b_k^2 * a
+// which takes n-1 squarings but only about log2(n) multiplications.
+// Return -1 if a is not invertible, which may happen for a reducible modulus,
+// or with MemoryError set if out of memory
+//
+{
+    if(field_is_zero(F, a))
+        return -1;
+    const size_t size = F->nv*sizeof(uint64_t);
+    uint64_t * restrict b = malloc(size);
+    uint64_t * restrict t = malloc(size);
+    if(!b || !t) {
+        free(b);
+        free(t);
+        PyErr_NoMemory();
+        return -1;
+    }
+    const int m = F->n - 1;
+
+    memcpy(b, a, size);
+    if(m == 0) {
+        field_set_one(F, b);
+    } else {
+        int k = 1;
+        int top = 0;
+        while((m >> (top+1)) > 0)
+            top++;
+        for(int i=top-1; i>=0; i--) {
+            memcpy(t, b, size);
+            for(int j=0; j<k; j++)
+                field_sqr(F, t, t);
+            field_mul(F, b, t, b);
+            k *= 2;
+            if((m >> i) & 1) {
+                field_sqr(F, b, b);
+                field_mul(F, b, b, a);
+                k++;
+            }
+        }
+        DBG_ASSERT(k == m);
+    }
+    field_sqr(F, b, b);
+
+    // Verify, since the result is only an inverse if the modulus is irreducible
+    field_mul(F, t, b, a);
+    int ok = field_is_one(F, t);
+    if(ok)
+        memcpy(r, b, size);
+    free(b);
+    free(t);
+    return ok ? 0 : -1;
+}
+
+static int
+field_compute_trace(FieldObject *F)
+//
+// Compute Tr(x^i) for 0<=i<n, by Newton's identities for the power sums of the roots of f:
+//   p_0 = n
+//   p_k = sum_{j=1}^{k-1} f_(n-j) p_(k-j) + k f_(n-k)
+// The sum is evaluated one word at a time, by keeping the coefficients f_(n-1), f_(n-2),...
+// in c and the power sums in reverse order in rp, so that both are consecutive bits.
+//
+{
+    const int n = F->n;
+    const int nt = (n + 63)/64;
+    uint64_t *c = calloc(nt, sizeof(uint64_t));
+    uint64_t *rp = calloc(nt, sizeof(uint64_t));
+    uint64_t *tr = calloc(nt, sizeof(uint64_t));
+    if(!c || !rp || !tr) {
+        free(c);
+        free(rp);
+        free(tr);
+        PyErr_NoMemory();
+        return -1;
+    }
+
+    // Get f as words
+    uint64_t *f = F->f;
+    uint64_t *fbig = NULL;
+    if(F->nw == 0) {
+        fbig = malloc((nt+1)*sizeof(uint64_t));
+        if(fbig == NULL) {
+            free(c);
+            free(rp);
+            free(tr);
+            PyErr_NoMemory();
+            return -1;
+        }
+        fw_from_digits(fbig, nt+1, F->mod.f, F->mod.ndigs_f);
+        f = fbig;
+    }
+#define BIT(w, i) (((w)[(i)/64] >> ((i)%64)) & 1)
+#define SETBIT(w, i) ((w)[(i)/64] |= (uint64_t)1 << ((i)%64))
+    for(int i=0; i<n; i++)
+        if(BIT(f, n-1-i))
+            SETBIT(c, i);
+    free(fbig);
+
+    if(n & 1)
+        SETBIT(rp, n-1);
+    for(int k=1; k<n; k++) {
+        // sum_{i=0}^{k-2} c[i]*rp[n-k+i]
+        uint64_t acc = (k & 1) ? BIT(c, k-1) : 0;
+        for(int i=0; i<k-1; i+=64) {
+            uint64_t w;
+            fw_rshift(&w, rp, nt, n-k+i, 1);
+            if(k-1-i < 64)
+                w &= ((uint64_t)1 << (k-1-i)) - 1;
+            acc ^= c[i/64] & w;
+        }
+        if(popcount_64(acc) & 1)
+            SETBIT(rp, n-1-k);
+    }
+    for(int i=0; i<n; i++)
+        if(BIT(rp, n-1-i))
+            SETBIT(tr, i);
+#undef BIT
+#undef SETBIT
+
+    free(c);
+    free(rp);
+    F->trace = tr;
+    return 0;
+}
+
+static int
+field_trace(FieldObject *F, const uint64_t *a)
+// Return Tr(a), or -1 on error
+{
+    if(!F->trace && field_compute_trace(F))
+        return -1;
+    const int nt = (F->n + 63)/64;
+    const uint64_t *w = a;
+    uint64_t *wbig = NULL;
+    if(F->nw == 0) {
+        wbig = malloc(nt*sizeof(uint64_t));
+        if(wbig == NULL) {
+            PyErr_NoMemory();
+            return -1;
+        }
+        fw_from_digits(wbig, nt, (const digit *)a, F->mod.ndigs_r);
+        w = wbig;
+    }
+    uint64_t acc = 0;
+    for(int i=0; i<nt; i++)
+        acc ^= w[i] & F->trace[i];
+    free(wbig);
+    return popcount_64(acc) & 1;
+}
+
+//
+// Python objects
+//
+
+static FieldElementObject *
+field_element_alloc(FieldObject *F)
+// New element of F, with value zero
+{
+    FieldElementObject *r = (FieldElementObject *)FieldElementType.tp_alloc(&FieldElementType, F->nv);
+    if(r == NULL)
+        return NULL;
+    Py_INCREF(F);
+    r->field = F;
+    return r;
+}
+
+static FieldElementObject *
+field_element_from_long(FieldObject *F, PyObject *o)
+//
+// New element of F from a Python integer, reduced modulo f
+//
+{
+    if(((PyVarObject *)o)->ob_size < 0) {
+        PyErr_SetString(PyExc_ValueError, "Field element must be non-negative");
+        return NULL;
+    }
+    if(_PyLong_NumBits(o) > (size_t)2*F->n) {
+        PyErr_SetString(PyExc_ValueError, "Integer is out of range for field");
+        return NULL;
+    }
+    FieldElementObject *r = field_element_alloc(F);
+    if(r == NULL)
+        return NULL;
+    const digit *d = ((PyLongObject *)o)->ob_digit;
+    const int nd = ((PyVarObject *)o)->ob_size;
+    if(F->nw) {
+        uint64_t c[2*FIELD_MAX_WORDS];
+        fw_from_digits(c, 2*F->nw, d, nd);
+        field_reduce_fw(F, r->v, c, F->nw);
+    } else {
+        field_reduce_big(F, (digit *)r->v, d, nd);
+    }
+    return r;
+}
+
+static PyObject *
+field_element_to_long(FieldElementObject *a)
+{
+    FieldObject *F = a->field;
+    if(F->nw)
+        return (PyObject *)fw_to_pylong(a->v, F->nw);
+    const int nd = field_ndigs((const digit *)a->v, F->mod.ndigs_r);
+    PyLongObject *p = pylong_new(nd);
+    if(p)
+        memcpy(p->ob_digit, a->v, nd*sizeof(digit));
+    return (PyObject *)p;
+}
+
+static bool
+field_same(FieldObject *F, FieldObject *G)
+{
+    return F == G || (F->n == G->n && PyObject_RichCompareBool(F->modulus, G->modulus, Py_EQ) == 1);
+}
+
+static FieldElementObject *
+field_coerce(FieldObject *F, PyObject *o)
+//
+// Return o as a new reference to an element of F.
+// Return NULL without exception set if o is of an unsupported type.
+//
+{
+    if(FieldElement_Check(o)) {
+        if(! field_same(F, ((FieldElementObject *)o)->field)) {
+            PyErr_SetString(PyExc_ValueError, "Operands belong to different fields");
+            return NULL;
+        }
+        Py_INCREF(o);
+        return (FieldElementObject *)o;
+    }
+    if(PyLong_Check(o))
+        return field_element_from_long(F, o);
+    return NULL;
+}
+
+static PyObject *
+field_new(PyTypeObject *type, PyObject *args, PyObject *kwds)
+//
+// Field(modulus)
+//
+{
+    static char *kwlist[] = {"modulus", NULL};
+    PyObject *modulus;
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "O", kwlist, &modulus))
+        return NULL;
+    if(! PyLong_Check(modulus)) {
+        PyErr_SetString(PyExc_TypeError, "Field modulus must be integer");
+        return NULL;
+    }
+    if(((PyVarObject *)modulus)->ob_size < 0 || _PyLong_NumBits(modulus) < 2) {
+        PyErr_SetString(PyExc_ValueError, "Field modulus must have degree >= 1");
+        return NULL;
+    }
+    if(((PyVarObject *)modulus)->ob_size > PYGF2X_MAX_DIGITS/2) {
+        PyErr_SetString(PyExc_ValueError, "Field modulus is out of range");
+        return NULL;
+    }
+
+    FieldObject *F = (FieldObject *)type->tp_alloc(type, 0);
+    if(F == NULL)
+        return NULL;
+    const digit *d = ((PyLongObject *)modulus)->ob_digit;
+    const int nd = ((PyVarObject *)modulus)->ob_size;
+    const int n = _PyLong_NumBits(modulus) - 1;
+    Py_INCREF(modulus);
+    F->modulus = modulus;
+    F->n = n;
+    F->nw = n <= 64 ? 1 : n <= 128 ? 2 : n <= 256 ? 4 : n <= 64*FIELD_MAX_WORDS ? FIELD_MAX_WORDS : 0;
+
+    // Reduce by shifts if f = x^n + (a few terms of degree <= n/2)
+    int weight = 0;
+    int sparse[FIELD_MAX_SPARSE];
+    for(int i=0; i<n && weight<=FIELD_MAX_SPARSE; i++) {
+        if(d[i/PyLong_SHIFT] == 0)
+            i += PyLong_SHIFT-1 - i%PyLong_SHIFT;
+        else if((d[i/PyLong_SHIFT] >> (i%PyLong_SHIFT)) & 1) {
+            if(weight < FIELD_MAX_SPARSE)
+                sparse[weight] = i;
+            weight++;
+        }
+    }
+    if(weight > 0 && weight <= FIELD_MAX_SPARSE && sparse[weight-1] <= n/2) {
+        F->nsparse = weight;
+        memcpy(F->sparse, sparse, weight*sizeof(int));
+    }
+
+    if(F->nw) {
+        F->nv = F->nw;
+        fw_from_digits(F->f, F->nw+1, d, nd);
+        if(! F->nsparse) {
+            const int ndigs_e = (n + (PyLong_SHIFT-1))/PyLong_SHIFT;
+            digit e[(64*FIELD_MAX_WORDS + PyLong_SHIFT-1)/PyLong_SHIFT] = {0};
+            inverse(e, ndigs_e, n, d, nd, n+1);
+            fw_from_digits(F->e, F->nw, e, ndigs_e);
+        }
+    } else {
+        if(modulus_init(&F->mod, d, n+1)) {
+            Py_DECREF(F);
+            return NULL;
+        }
+        F->nv = (F->mod.ndigs_r*sizeof(digit) + sizeof(uint64_t)-1)/sizeof(uint64_t);
+    }
+    return (PyObject *)F;
+}
+
+static void
+field_dealloc(FieldObject *self)
+{
+    if(self->nw == 0)
+        modulus_free(&self->mod);
+    free(self->trace);
+    Py_XDECREF(self->modulus);
+    Py_TYPE(self)->tp_free((PyObject *)self);
+}
+
+static PyObject *
+field_call(FieldObject *self, PyObject *args, PyObject *kwds)
+//
+// F(value): element of F from an integer, reduced modulo f
+//
+{
+    static char *kwlist[] = {"value", NULL};
+    PyObject *value;
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "O", kwlist, &value))
+        return NULL;
+    FieldElementObject *r = field_coerce(self, value);
+    if(r == NULL && !PyErr_Occurred())
+        PyErr_SetString(PyExc_TypeError, "Field element must be created from an integer");
+    return (PyObject *)r;
+}
+
+static PyObject *
+field_repr(FieldObject *self)
+{
+    PyObject *hex = PyNumber_ToBase(self->modulus, 16);
+    if(hex == NULL)
+        return NULL;
+    PyObject *r = PyUnicode_FromFormat("Field(%U)", hex);
+    Py_DECREF(hex);
+    return r;
+}
+
+static PyObject *
+field_get_modulus(FieldObject *self, void *closure)
+{
+    (void)closure;
+    Py_INCREF(self->modulus);
+    return self->modulus;
+}
+
+static PyObject *
+field_get_degree(FieldObject *self, void *closure)
+{
+    (void)closure;
+    return PyLong_FromLong(self->n);
+}
+
+static void
+field_element_dealloc(FieldElementObject *self)
+{
+    Py_XDECREF(self->field);
+    Py_TYPE(self)->tp_free((PyObject *)self);
+}
+
+enum {FIELD_ADD, FIELD_MUL, FIELD_DIV};
+
+static PyObject *
+field_binary_op(PyObject *a, PyObject *b, int op)
+{
+    FieldObject *F = FieldElement_Check(a) ? ((FieldElementObject *)a)->field : ((FieldElementObject *)b)->field;
+    FieldElementObject *ea = field_coerce(F, a);
+    FieldElementObject *eb = ea ? field_coerce(F, b) : NULL;
+    if(eb == NULL) {
+        Py_XDECREF(ea);
+        if(PyErr_Occurred())
+            return NULL;
+        Py_RETURN_NOTIMPLEMENTED;
+    }
+
+    FieldElementObject *r = field_element_alloc(F);
+    if(r != NULL) {
+        switch(op) {
+        case FIELD_ADD:
+            for(int i=0; i<F->nv; i++)
+                r->v[i] = ea->v[i] ^ eb->v[i];
+            break;
+        case FIELD_MUL:
+            field_mul(F, r->v, ea->v, eb->v);
+            break;
+        case FIELD_DIV:
+            if(field_is_zero(F, eb->v)) {
+                PyErr_SetString(PyExc_ZeroDivisionError, "Division by zero field element");
+                Py_CLEAR(r);
+            } else if(field_inverse(F, r->v, eb->v)) {
+                if(!PyErr_Occurred())
+                    PyErr_SetString(PyExc_ValueError, "Divisor is not invertible, modulus is not irreducible");
+                Py_CLEAR(r);
+            } else {
+                field_mul(F, r->v, ea->v, r->v);
+            }
+            break;
+        }
+    }
+    Py_DECREF(ea);
+    Py_DECREF(eb);
+    return (PyObject *)r;
+}
+
+static PyObject *
+field_element_add(PyObject *a, PyObject *b)
+{
+    return field_binary_op(a, b, FIELD_ADD);
+}
+
+static PyObject *
+field_element_mul(PyObject *a, PyObject *b)
+{
+    return field_binary_op(a, b, FIELD_MUL);
+}
+
+static PyObject *
+field_element_div(PyObject *a, PyObject *b)
+{
+    return field_binary_op(a, b, FIELD_DIV);
+}
+
+static PyObject *
+field_element_pow(PyObject *a, PyObject *k, PyObject *mod)
+{
+    if(! FieldElement_Check(a) || ! PyLong_Check(k))
+        Py_RETURN_NOTIMPLEMENTED;
+    if(mod != Py_None) {
+        PyErr_SetString(PyExc_TypeError, "pow() with modulus is not supported for field elements");
+        return NULL;
+    }
+    FieldElementObject *ea = (FieldElementObject *)a;
+    FieldObject *F = ea->field;
+    const bool zero = field_is_zero(F, ea->v);
+    const Py_ssize_t size_k = ((PyVarObject *)k)->ob_size;
+    if(size_k == 0 && zero) {
+        PyErr_SetString(PyExc_ValueError, "0^0 is undefined");
+        return NULL;
+    }
+    if(size_k < 0 && zero) {
+        PyErr_SetString(PyExc_ZeroDivisionError, "Negative power of zero field element");
+        return NULL;
+    }
+
+    FieldElementObject *r = field_element_alloc(F);
+    if(r == NULL)
+        return NULL;
+    if(size_k == 0) {
+        field_set_one(F, r->v);
+        return (PyObject *)r;
+    }
+    const size_t size = F->nv*sizeof(uint64_t);
+    uint64_t *base = malloc(size);
+    uint64_t *tmp = calloc(F->nv, sizeof(uint64_t));  // Copied whole into r by field_pow_digits
+    if(!base || !tmp) {
+        PyErr_NoMemory();
+        Py_CLEAR(r);
+    } else if(size_k > 0) {
+        memcpy(base, ea->v, size);
+    } else if(field_inverse(F, base, ea->v)) {
+        if(!PyErr_Occurred())
+            PyErr_SetString(PyExc_ValueError, "Element is not invertible, modulus is not irreducible");
+        Py_CLEAR(r);
+    }
+    if(r) {
+        // Python digits of |k|
+        const digit *dk = ((PyLongObject *)k)->ob_digit;
+        if(size_k > 0 && field_is_x(F, base))
+            field_xpow(F, r->v, dk, _PyLong_NumBits(k));
+        else
+            field_pow_digits(F, r->v, base, dk, _PyLong_NumBits(k), tmp);
+    }
+    free(base);
+    free(tmp);
+    return (PyObject *)r;
+}
+
+static PyObject *
+field_element_pos(PyObject *a)
+{
+    Py_INCREF(a);
+    return a;
+}
+
+static int
+field_element_bool(FieldElementObject *a)
+{
+    return ! field_is_zero(a->field, a->v);
+}
+
+static PyObject *
+field_element_int(FieldElementObject *a)
+{
+    return field_element_to_long(a);
+}
+
+static PyObject *
+field_element_richcompare(FieldElementObject *a, PyObject *b, int op)
+{
+    if(op != Py_EQ && op != Py_NE)
+        Py_RETURN_NOTIMPLEMENTED;
+    if(FieldElement_Check(b)) {
+        FieldElementObject *eb = (FieldElementObject *)b;
+        bool eq = field_same(a->field, eb->field) && field_equal(a->field, a->v, eb->v);
+        if(eq == (op == Py_EQ))
+            Py_RETURN_TRUE;
+        Py_RETURN_FALSE;
+    }
+    if(PyLong_Check(b)) {
+        PyObject *ia = field_element_to_long(a);
+        if(ia == NULL)
+            return NULL;
+        PyObject *r = PyObject_RichCompare(ia, b, op);
+        Py_DECREF(ia);
+        return r;
+    }
+    Py_RETURN_NOTIMPLEMENTED;
+}
+
+static Py_hash_t
+field_element_hash(FieldElementObject *a)
+// Same hash as the integer value, since elements compare equal to it
+{
+    PyObject *ia = field_element_to_long(a);
+    if(ia == NULL)
+        return -1;
+    Py_hash_t h = PyObject_Hash(ia);
+    Py_DECREF(ia);
+    return h;
+}
+
+static PyObject *
+field_element_repr(FieldElementObject *a)
+{
+    PyObject *ia = field_element_to_long(a);
+    if(ia == NULL)
+        return NULL;
+    PyObject *hex = PyNumber_ToBase(ia, 16);
+    Py_DECREF(ia);
+    if(hex == NULL)
+        return NULL;
+    PyObject *r = PyUnicode_FromFormat("%R(%U)", a->field, hex);
+    Py_DECREF(hex);
+    return r;
+}
+
+static PyObject *
+field_element_inverse(FieldElementObject *self, PyObject *noargs)
+{
+    (void)noargs;
+    FieldObject *F = self->field;
+    if(field_is_zero(F, self->v)) {
+        PyErr_SetString(PyExc_ZeroDivisionError, "Inverse of zero field element is undefined");
+        return NULL;
+    }
+    FieldElementObject *r = field_element_alloc(F);
+    if(r && field_inverse(F, r->v, self->v)) {
+        if(!PyErr_Occurred())
+            PyErr_SetString(PyExc_ValueError, "Element is not invertible, modulus is not irreducible");
+        Py_CLEAR(r);
+    }
+    return (PyObject *)r;
+}
+
+static PyObject *
+field_element_sqrt(FieldElementObject *self, PyObject *noargs)
+//
+// sqrt(a) = a^(2^(n-1)), since a^(2^n) = a
+//
+{
+    (void)noargs;
+    FieldObject *F = self->field;
+    FieldElementObject *r = field_element_alloc(F);
+    if(r == NULL)
+        return NULL;
+    memcpy(r->v, self->v, F->nv*sizeof(uint64_t));
+    for(int i=1; i<F->n; i++)
+        field_sqr(F, r->v, r->v);
+
+    // Verify, since squaring is only a bijection if the modulus is square-free
+    uint64_t *t = malloc(F->nv*sizeof(uint64_t));
+    if(t == NULL) {
+        Py_DECREF(r);
+        return PyErr_NoMemory();
+    }
+    field_sqr(F, t, r->v);
+    if(!field_equal(F, t, self->v)) {
+        PyErr_SetString(PyExc_ValueError, "Element has no square root, modulus is not irreducible");
+        Py_CLEAR(r);
+    }
+    free(t);
+    return (PyObject *)r;
+}
+
+static PyObject *
+field_element_trace(FieldElementObject *self, PyObject *noargs)
+{
+    (void)noargs;
+    int t = field_trace(self->field, self->v);
+    if(t < 0)
+        return NULL;
+    return PyLong_FromLong(t);
+}
+
+static PyObject *
+field_element_get_field(FieldElementObject *self, void *closure)
+{
+    (void)closure;
+    Py_INCREF(self->field);
+    return (PyObject *)self->field;
+}
+
+static PyGetSetDef field_getset[] =
+    {
+        {"modulus", (getter)field_get_modulus, NULL, "Modulus polynomial", NULL},
+        {"degree", (getter)field_get_degree, NULL, "Degree n of the modulus, the field has 2^n elements", NULL},
+        {NULL, NULL, NULL, NULL, NULL}
+    };
+
+static PyTypeObject FieldType =
+    {
+        PyVarObject_HEAD_INIT(NULL, 0)
+        .tp_name = "pygf2x.Field",
+        .tp_basicsize = sizeof(FieldObject),
+        .tp_itemsize = 0,
+        .tp_dealloc = (destructor)field_dealloc,
+        .tp_repr = (reprfunc)field_repr,
+        .tp_call = (ternaryfunc)field_call,
+        .tp_flags = Py_TPFLAGS_DEFAULT,
+        .tp_doc = "Field(modulus)\n"
+                  "Finite field GF(2^n) with the given irreducible modulus polynomial of degree n.\n"
+                  "Calling the field with an integer returns the corresponding element.",
+        .tp_getset = field_getset,
+        .tp_new = field_new,
+    };
+
+static PyMethodDef field_element_methods[] =
+    {
+        {
+            "inverse",
+            (PyCFunction)field_element_inverse,
+            METH_NOARGS,
+            "Multiplicative inverse"
+        },
+        {
+            "sqrt",
+            (PyCFunction)field_element_sqrt,
+            METH_NOARGS,
+            "Square root"
+        },
+        {
+            "trace",
+            (PyCFunction)field_element_trace,
+            METH_NOARGS,
+            "Absolute trace, 0 or 1"
+        },
+        {NULL, NULL, 0, NULL}
+    };
+
+static PyGetSetDef field_element_getset[] =
+    {
+        {"field", (getter)field_element_get_field, NULL, "The field of the element", NULL},
+        {NULL, NULL, NULL, NULL, NULL}
+    };
+
+static PyNumberMethods field_element_as_number =
+    {
+        .nb_add = field_element_add,
+        .nb_subtract = field_element_add,
+        .nb_multiply = field_element_mul,
+        .nb_power = field_element_pow,
+        .nb_negative = field_element_pos,
+        .nb_positive = field_element_pos,
+        .nb_bool = (inquiry)field_element_bool,
+        .nb_int = (unaryfunc)field_element_int,
+        .nb_true_divide = field_element_div,
+    };
+
+static PyTypeObject FieldElementType =
+    {
+        PyVarObject_HEAD_INIT(NULL, 0)
+        .tp_name = "pygf2x.FieldElement",
+        .tp_basicsize = offsetof(FieldElementObject, v),
+        .tp_itemsize = sizeof(uint64_t),
+        .tp_dealloc = (destructor)field_element_dealloc,
+        .tp_repr = (reprfunc)field_element_repr,
+        .tp_as_number = &field_element_as_number,
+        .tp_hash = (hashfunc)field_element_hash,
+        .tp_flags = Py_TPFLAGS_DEFAULT,
+        .tp_doc = "Element of a pygf2x.Field, created by calling the field with an integer",
+        .tp_richcompare = (richcmpfunc)field_element_richcompare,
+        .tp_methods = field_element_methods,
+        .tp_getset = field_element_getset,
+    };
@@ -0,0 +1,415 @@
+/* -*- mode: c; c-basic-offset: 4; -*- */
+/*******************************************************************************
+ *
+ * Copyright (c) 2021 Oskar Enoksson. All rights reserved.
+ * Licensed under the MIT license. See LICENSE file in the project root for details.
+ *
+ * Description:
+ * Fixed-width kernels for polynomials over GF(2) stored in arrays of 64-bit words
+ *
+ * The functions taking a word count nw are inline, so that when they are called
+ * with a constant nw the compiler produces straight-line code for that width.
+ *
+ *******************************************************************************/
+
+static inline int
+popcount_64(uint64_t v)
+// Number of non-zero bits
+{
+#ifdef __GNUC__
+    return __builtin_popcountll(v);
+#else
+    v = v - ((v >> 1) & 0x5555555555555555ull);
+    v = (v & 0x3333333333333333ull) + ((v >> 2) & 0x3333333333333333ull);
+    v = (v + (v >> 4)) & 0x0f0f0f0f0f0f0f0full;
+    return (int)((v * 0x0101010101010101ull) >> 56);
+#endif
+}
+
+static inline int
+nbits_64(uint64_t v)
+// 1-based index of the most significant non-zero bit, or 0 if v is zero
+{
+#ifdef __GNUC__
+    return v ? 64 - __builtin_clzll(v) : 0;
+#else
+    int n = 0;
+    for(; v; v >>= 1)
+        n++;
+    return n;
+#endif
+}
+
+static inline uint64_t
+sqr_64(uint64_t f, uint64_t *h)
+// Square a 64-bit polynomial over GF(2)
+// Return the lower 64 bits of the 127-bit square, store the upper 63 bits in *h
+{
+#if defined(PYGF2X_USE_SSE_CLMUL) || defined(PYGF2X_USE_ARMV8_CRYPTO)
+    return mul_64_64(f, f, h);
+#else
+    // Spread the bits using the 8-bit square table
+    uint64_t l = 0;
+    uint64_t u = 0;
+    for(int i=3; i>=0; i--) {
+        l = (l << 16) | sqr_8[(f >> (8*i)) & 0xff];
+        u = (u << 16) | sqr_8[(f >> (8*i+32)) & 0xff];
+    }
+    *h = u;
+    return l;
+#endif
+}
+
+static inline void
+fw_mul_2(uint64_t * restrict p, const uint64_t *a, const uint64_t *b)
+//
+// 128x128-bit product using Karatsubas formula (3 multiplications)
+// p has 4 words
+//
+{
+#ifdef PYGF2X_HAVE_MUL_128
+    // Keep the partial products in vector registers
+    mul_128_128(p, a, b);
+#else
+    uint64_t h0, h1, h2;
+    uint64_t l0 = mul_64_64(a[0], b[0], &h0);
+    uint64_t l2 = mul_64_64(a[1], b[1], &h2);
+    uint64_t l1 = mul_64_64(a[0] ^ a[1], b[0] ^ b[1], &h1);
+    l1 ^= l0 ^ l2;
+    h1 ^= h0 ^ h2;
+    p[0] = l0;
+    p[1] = h0 ^ l1;
+    p[2] = l2 ^ h1;
+    p[3] = h2;
+#endif
+}
+
+static inline void
+fw_mul_4(uint64_t * restrict p, const uint64_t *a, const uint64_t *b)
+//
+// 256x256-bit product using Karatsubas formula on 128-bit halves (9 multiplications)
+// p has 8 words
+//
+{
+    uint64_t z1[4];
+    const uint64_t a01[2] = {a[0] ^ a[2], a[1] ^ a[3]};
+    const uint64_t b01[2] = {b[0] ^ b[2], b[1] ^ b[3]};
+    fw_mul_2(p, a, b);
+    fw_mul_2(p+4, a+2, b+2);
+    fw_mul_2(z1, a01, b01);
+    for(int i=0; i<4; i++)
+        z1[i] ^= p[i] ^ p[4+i];
+    for(int i=0; i<4; i++)
+        p[2+i] ^= z1[i];
+}
+
+static inline void
+fw_mul_8(uint64_t * restrict p, const uint64_t *a, const uint64_t *b)
+//
+// 512x512-bit product using Karatsubas formula on 256-bit halves (27 multiplications)
+// p has 16 words
+//
+{
+    uint64_t z1[8];
+    uint64_t a01[4], b01[4];
+    for(int i=0; i<4; i++) {
+        a01[i] = a[i] ^ a[4+i];
+        b01[i] = b[i] ^ b[4+i];
+    }
+    fw_mul_4(p, a, b);
+    fw_mul_4(p+8, a+4, b+4);
+    fw_mul_4(z1, a01, b01);
+    for(int i=0; i<8; i++)
+        z1[i] ^= p[i] ^ p[8+i];
+    for(int i=0; i<8; i++)
+        p[4+i] ^= z1[i];
+}
+
+static inline void
+fw_mul(uint64_t * restrict p, const uint64_t *a, const uint64_t *b, int nw)
+//
+// p = a*b where a and b have nw words and p has 2*nw words
+//
+{
+    if(nw == 1) {
+        p[0] = mul_64_64(a[0], b[0], &p[1]);
+    } else if(nw == 2) {
+        fw_mul_2(p, a, b);
+    } else if(nw == 4) {
+        fw_mul_4(p, a, b);
+    } else if(nw == 8) {
+        fw_mul_8(p, a, b);
+    } else if(nw == 9) {
+        // 512-bit Karatsuba on the lower 8 words, plus the products with the 9th words
+        uint64_t h;
+        fw_mul_8(p, a, b);
+        p[16] = 0;
+        p[17] = 0;
+        for(int i=0; i<8; i++) {
+            p[8+i] ^= mul_64_64(a[8], b[i], &h);
+            p[9+i] ^= h;
+            p[8+i] ^= mul_64_64(a[i], b[8], &h);
+            p[9+i] ^= h;
+        }
+        p[16] ^= mul_64_64(a[8], b[8], &h);
+        p[17] ^= h;
+    } else {
+        // Schoolbook
+        for(int i=0; i<2*nw; i++)
+            p[i] = 0;
+        for(int i=0; i<nw; i++)
+            for(int j=0; j<nw; j++) {
+                uint64_t h;
+                p[i+j] ^= mul_64_64(a[i], b[j], &h);
+                p[i+j+1] ^= h;
+            }
+    }
+}
+
+static inline void
+fw_mullo(uint64_t * restrict p, const uint64_t *a, const uint64_t *b, int nw)
+//
+// p = a*b mod x^(64*nw), that is the lower nw words of the product
+//
+{
+    for(int i=0; i<nw; i++)
+        p[i] = 0;
+    for(int i=0; i<nw; i++)
+        for(int j=0; i+j<nw; j++) {
+            uint64_t h;
+            p[i+j] ^= mul_64_64(a[i], b[j], &h);
+            if(i+j+1 < nw)
+                p[i+j+1] ^= h;
+        }
+}
+
+static inline void
+fw_sqr(uint64_t * restrict p, const uint64_t *a, int nw)
+//
+// p = a^2 where a has nw words and p has 2*nw words
+//
+{
+    for(int i=0; i<nw; i++)
+        p[2*i] = sqr_64(a[i], &p[2*i+1]);
+}
+
+static inline void
+fw_rshift(uint64_t * restrict r, const uint64_t *a, int na, int nb, int nw)
+//
+// r = a >> nb, where a has na words and r is truncated to nw words
+//
+{
+    const int ws = nb/64;
+    const int bs = nb%64;
+    for(int i=0; i<nw; i++) {
+        uint64_t lo = i+ws < na ? a[i+ws] : 0;
+        uint64_t hi = i+ws+1 < na ? a[i+ws+1] : 0;
+        r[i] = bs ? (lo >> bs) | (hi << (64-bs)) : lo;
+    }
+}
+
+static inline void
+fw_xor_lshift(uint64_t * restrict r, const uint64_t *a, int na, int nb)
+//
+// r ^= a << nb, where a has na words, and r must be long enough to hold the result
+//
+{
+    const int ws = nb/64;
+    const int bs = nb%64;
+    for(int i=0; i<na; i++) {
+        r[i+ws] ^= a[i] << bs;
+        if(bs)
+            r[i+ws+1] ^= a[i] >> (64-bs);
+    }
+}
+
+static inline void
+fw_truncate(uint64_t *r, int nw, int nbits)
+//
+// Clear all bits from nbits and up, in an nw-word array
+//
+{
+    for(int i=nbits/64; i<nw; i++)
+        r[i] = (i == nbits/64 && nbits%64) ? r[i] & (((uint64_t)1 << (nbits%64)) - 1) : 0;
+}
+
+static inline void
+fw_from_digits(uint64_t *w, int nw, const digit *d, int nd)
+//
+// Pack nd Python digits into nw 64-bit words, truncating or zero-filling
+//
+{
+    uint64_t acc = 0;
+    int nacc = 0;
+    int iw = 0;
+    for(int i=0; i<nd && iw<nw; i++) {
+        acc |= (uint64_t)d[i] << nacc;
+        nacc += PyLong_SHIFT;
+        if(nacc >= 64) {
+            w[iw++] = acc;
+            nacc -= 64;
+            acc = nacc ? (uint64_t)d[i] >> (PyLong_SHIFT - nacc) : 0;
+        }
+    }
+    if(iw < nw)
+        w[iw++] = acc;
+    for(; iw<nw; iw++)
+        w[iw] = 0;
+}
+
+static inline void
+fw_to_digits(digit *d, int nd, const uint64_t *w, int nw)
+//
+// Unpack nw 64-bit words into nd Python digits, truncating or zero-filling
+//
+{
+    uint64_t acc = 0;
+    int nacc = 0;
+    int iw = 0;
+    for(int i=0; i<nd; i++) {
+        if(nacc >= PyLong_SHIFT) {
+            d[i] = (digit)(acc & PyLong_MASK);
+            acc >>= PyLong_SHIFT;
+            nacc -= PyLong_SHIFT;
+        } else {
+            uint64_t next = iw < nw ? w[iw++] : 0;
+            d[i] = (digit)((acc | (next << nacc)) & PyLong_MASK);
+            acc = next >> (PyLong_SHIFT - nacc);
+            nacc += 64 - PyLong_SHIFT;
+        }
+    }
+}
+
+static inline int
+fw_nbits(const uint64_t *w, int nw)
+// return 1-based index of the most significant non-zero bit, or 0 if all bits are zero
+{
+    for(int i=nw-1; i>=0; i--)
+        if(w[i])
+            return 64*i + nbits_64(w[i]);
+    return 0;
+}
+
+static PyLongObject *
+fw_to_pylong(const uint64_t *w, int nw)
+//
+// Create a new Python integer from nw 64-bit words
+//
+{
+    int ndigs = (fw_nbits(w, nw) + (PyLong_SHIFT-1))/PyLong_SHIFT;
+    PyLongObject *p = pylong_new(ndigs);
+    if(p)
+        fw_to_digits(p->ob_digit, ndigs, w, nw);
+    return p;
+}
+
+//
+// Entry points for small Python integers, called from the top of pygf2x_mul and
+// pygf2x_divmod. Operands are packed into 1, 2, 4 or 8 words, so that each width
+// gets its own straight-line kernel.
+//
+
+#define FW_MAX_DIGITS (512/PyLong_SHIFT)      // Operands of fw_mul_pylong
+#define FW_DIV_MAX_DIGITS (128/PyLong_SHIFT)  // Operands of fw_divmod_pylong
+#define FW_DIGITS(nw) ((64*(nw) + PyLong_SHIFT-1)/PyLong_SHIFT)  // Digits spanning nw words
+
+static inline int
+fw_digits_nbits(const digit *d, int nd)
+// Bit length of a normalized digit array
+{
+    return nd ? (nd-1)*PyLong_SHIFT + nbits_64(d[nd-1]) : 0;
+}
+
+static inline void
+fw_load(uint64_t *w, int nw, const digit *d, int nd)
+//
+// Pack nd<=FW_DIGITS(nw) digits into nw words.
+// The digits are first copied to a zero-padded buffer, so that the packing is done for
+// a fixed number of digits, which becomes straight-line code when nw is constant.
+//
+{
+    digit pad[FW_DIGITS(8)];
+    for(int i=0; i<FW_DIGITS(nw); i++)
+        pad[i] = i < nd ? d[i] : 0;
+    fw_from_digits(w, nw, pad, FW_DIGITS(nw));
+}
+
+static inline PyLongObject *
+fw_store(const uint64_t *w, int nw)
+//
+// Create a new Python integer from nw<=16 words, unpacking a fixed number of digits
+//
+{
+    digit pad[FW_DIGITS(16)];
+    fw_to_digits(pad, FW_DIGITS(nw), w, nw);
+    int ndigs = (fw_nbits(w, nw) + (PyLong_SHIFT-1))/PyLong_SHIFT;
+    PyLongObject *p = pylong_new(ndigs);
+    if(p)
+        for(int i=0; i<ndigs; i++)
+            p->ob_digit[i] = pad[i];
+    return p;
+}
+
+#define FW_DISPATCH(nbits, KERNEL)              \
+    if((nbits) <= 64) { KERNEL(1); }            \
+    else if((nbits) <= 128) { KERNEL(2); }      \
+    else if((nbits) <= 256) { KERNEL(4); }      \
+    else { KERNEL(8); }
+
+static PyLongObject *
+fw_mul_pylong(const digit *l, int ndigs_l, const digit *r, int ndigs_r)
+//
+// Product of two integers of at most FW_MAX_DIGITS digits
+//
+{
+    uint64_t a[8], b[8], p[16];
+#define FW_MUL_KERNEL(nw)                       \
+    fw_load(a, nw, l, ndigs_l);                 \
+    fw_load(b, nw, r, ndigs_r);                 \
+    fw_mul(p, a, b, nw);                        \
+    return fw_store(p, 2*nw);
+    FW_DISPATCH(GF2X_MAX(fw_digits_nbits(l, ndigs_l), fw_digits_nbits(r, ndigs_r)), FW_MUL_KERNEL)
+#undef FW_MUL_KERNEL
+}
+
+static inline void
+fw_divmod_2(uint64_t * restrict q, uint64_t * restrict r, const uint64_t *d)
+//
+// q, r = divmod(r, d), for r and d of at most 128 bits and d non-zero.
+// Schoolbook division, one step per non-zero quotient bit.
+//
+{
+    const int nbits_d = fw_nbits(d, 2);
+    q[0] = q[1] = 0;
+    for(int nbits_r = fw_nbits(r, 2); nbits_r >= nbits_d; nbits_r = fw_nbits(r, 2)) {
+        const int s = nbits_r - nbits_d;
+        q[s/64] |= (uint64_t)1 << (s%64);
+        if(s >= 64) {
+            r[1] ^= d[0] << (s-64);
+        } else if(s > 0) {
+            r[0] ^= d[0] << s;
+            r[1] ^= (d[1] << s) | (d[0] >> (64-s));
+        } else {
+            r[0] ^= d[0];
+            r[1] ^= d[1];
+        }
+    }
+}
+
+static PyObject *
+fw_divmod_pylong(const digit *u, int ndigs_u, const digit *d, int ndigs_d, int want)
+//
+// Quotient and remainder of integers of at most FW_DIV_MAX_DIGITS digits, d non-zero.
+// Return the quotient or the remainder alone if only one of them is wanted.
+//
+{
+    uint64_t q[2], r[2], dw[2];
+    fw_load(r, 2, u, ndigs_u);
+    fw_load(dw, 2, d, ndigs_d);
+    fw_divmod_2(q, r, dw);
+    if(want == DIVMOD_Q)
+        return (PyObject *)fw_store(q, 2);
+    if(want == DIVMOD_R)
+        return (PyObject *)fw_store(r, 2);
+    return Py_BuildValue("NN", fw_store(q, 2), fw_store(r, 2));
+}
@@ -8,10 +8,12 @@
  * Generic functions for polynomials over GF(2)
  *
  *******************************************************************************/
+#define PYGF2X_BACKEND "generic"
 #define ATOM 5
 #define mul_ATOM_15 mul_5_15
 #define mul_ATOM_30 mul_5_30
 #define KARATSUBA_LIMIT 4
+#define TOOM_LIMIT 12
 
 static inline uint32_t
 mul_5_15(uint8_t l, uint16_t r)
@@ -169,6 +171,45 @@ mul_30_30(uint32_t l, uint32_t r)
     return ((((uint64_t)z2 << 15) ^ (uint64_t)z1 ) << 15) ^ (uint64_t)z0;
 }
 
+static inline uint64_t
+mul_32_32(uint32_t l, uint32_t r)
+// Multiply two unsigned 32-bit polynomials over GF(2) (stored in uint32_t)
+// Return as a 63-bit polynomial (stored in uint64_t)
+{
+    // Use a 4-bit window over r, with the 16 multiples of l tabulated on the fly
+    uint64_t u[16];
+    u[0] = 0;
+    u[1] = l;
+    for(int i=2; i<16; i+=2) {
+        u[i] = u[i>>1] << 1;
+        u[i+1] = u[i] ^ l;
+    }
+    uint64_t p = 0;
+    for(int i=28; i>=0; i-=4)
+        p = (p << 4) ^ u[(r >> i) & 0xf];
+
+    return p;
+}
+
+static inline uint64_t
+mul_64_64(uint64_t l, uint64_t r, uint64_t *h)
+// Multiply two unsigned 64-bit polynomials over GF(2) (stored in uint64_t)
+// Return the lower 64 bits of the 127-bit product, store the upper 63 bits in *h
+{
+    // Use Karatsubas formula and mul_32_32
+    uint32_t ll = (uint32_t)l;
+    uint32_t lh = (uint32_t)(l >> 32);
+    uint32_t rl = (uint32_t)r;
+    uint32_t rh = (uint32_t)(r >> 32);
+
+    uint64_t z0 = mul_32_32(ll,rl);
+    uint64_t z2 = mul_32_32(lh,rh);
+    uint64_t z1 = mul_32_32(ll ^ lh, rl ^ rh) ^z2 ^z0;
+
+    *h = z2 ^ (z1 >> 32);
+    return z0 ^ (z1 << 32);
+}
+
 
 static inline uint32_t
 sqr_15(uint16_t f)
@@ -186,8 +227,12 @@ square_n(digit * restrict result, const digit *fdigits, int ndigs_f)
 // in order to make the algorithm simpler and faster
 //
 {
-    int idp=0;
-    for(int id=0; id<ndigs_f; id++) {
+    int id=0;
+#ifdef PYGF2X_SQUARE_SIMD
+    id = square_simd(result, fdigits, ndigs_f);
+#endif
+    int idp=2*id;
+    for(; id<ndigs_f; id++) {
         digit ic = fdigits[id];
 #if (PyLong_SHIFT == 15)
         digit pd0 = sqr_8[ic&0xff];
@@ -12,7 +12,9 @@
 #include <immintrin.h>
 
 #define PYGF2X_USE_SSE_CLMUL
+#define PYGF2X_BACKEND "intel_clmul"
 #define KARATSUBA_LIMIT 16
+#define TOOM_LIMIT 128
 
 #define ATOM 8
 #define mul_ATOM_15(a,b) mul_8_15(a,b)
@@ -89,6 +91,36 @@ mul_30_30(uint32_t l, uint32_t r)
     return pi[0];
 }
 
+static inline uint64_t
+mul_64_64(uint64_t l, uint64_t r, uint64_t *h)
+// Multiply two unsigned 64-bit polynomials over GF(2) (stored in uint64_t)
+// Return the lower 64 bits of the 127-bit product, store the upper 63 bits in *h
+{
+    __m128i li = _mm_cvtsi64_si128(l);
+    __m128i ri = _mm_cvtsi64_si128(r);
+    __m128i pi = _mm_clmulepi64_si128(li,ri,0);
+    *h = pi[1];
+    return pi[0];
+}
+
+#define PYGF2X_HAVE_MUL_128
+static inline void
+mul_128_128(uint64_t * restrict p, const uint64_t *a, const uint64_t *b)
+// Multiply two 128-bit polynomials over GF(2), stored in two words each
+// Store the 255-bit product in p[0..3]
+{
+    __m128i ai = _mm_loadu_si128((const __m128i *)a);
+    __m128i bi = _mm_loadu_si128((const __m128i *)b);
+    __m128i lo = _mm_clmulepi64_si128(ai, bi, 0x00);
+    __m128i hi = _mm_clmulepi64_si128(ai, bi, 0x11);
+    // Karatsuba: (a0+a1)(b0+b1) + a0b0 + a1b1
+    __m128i mi = _mm_clmulepi64_si128(_mm_xor_si128(ai, _mm_srli_si128(ai, 8)),
+                                      _mm_xor_si128(bi, _mm_srli_si128(bi, 8)), 0x00);
+    mi = _mm_xor_si128(mi, _mm_xor_si128(lo, hi));
+    _mm_storeu_si128((__m128i *)p, _mm_xor_si128(lo, _mm_slli_si128(mi, 8)));
+    _mm_storeu_si128((__m128i *)(p+2), _mm_xor_si128(hi, _mm_srli_si128(mi, 8)));
+}
+
 static inline uint32_t
 sqr_15(uint16_t f)
 {
@@ -105,8 +137,11 @@ square_n(digit * restrict result, const digit *fdigits, int ndigs_f)
 // p += f^2
 //
 {
-    int idp=0;
     int id=0;
+#ifdef PYGF2X_SQUARE_SIMD
+    id = square_simd(result, fdigits, ndigs_f);
+#endif
+    int idp=2*id;
     // Loop 2 at a time, taking advantage of the 64x64 bit multiplication instruction
     for(; id<ndigs_f-1; id+=2) {
         digit ic0 = fdigits[id];
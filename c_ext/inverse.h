@@ -27,8 +27,8 @@ static const uint8_t inv_8[1<<7] = {
 };
 
 static void
-inverse(digit *restrict e_digits, int ndigs_e, int nbits_e,
-        const digit * restrict d_digits, int ndigs_d, int nbits_d)
+inverse_newton(digit *restrict e_digits, int ndigs_e, int nbits_e,
+               const digit * restrict d_digits, int ndigs_d, int nbits_d)
 //
 // Compute GF2[x] inverse e to d such that
 // e*d == (1 << (nbits_e + nbits_d -2)) + r
@@ -51,7 +51,7 @@ inverse(digit *restrict e_digits, int ndigs_e, int nbits_e,
     // digit has most significant bit =1
     // Also truncate it, or fill it with zero, from the right, so that it has ndigs_e digits.
     digit d_static[STATIC_LIMIT];
-    digit * restrict const d = use_heap ? malloc(ndigs_e*sizeof(digit)) : d_static;
+    digit * restrict const d = use_heap ? ws_push(ndigs_e) : d_static;
     memset(d,0,ndigs_e*sizeof(digit));
     {
         const int shift = (PyLong_SHIFT-1) - (nbits_d + (PyLong_SHIFT-1))%PyLong_SHIFT;
@@ -153,8 +153,8 @@ inverse(digit *restrict e_digits, int ndigs_e, int nbits_e,
     const int x2len = (ndigs_e&1)+ndigs_e;
     digit x2_static[(STATIC_LIMIT&1)+STATIC_LIMIT];
     digit etmp_static[((STATIC_LIMIT&1)+STATIC_LIMIT)<<1];
-    digit * restrict const x2 = use_heap ? malloc(x2len*sizeof(digit)) : x2_static;
-    digit * restrict const etmp = use_heap ? malloc((x2len<<1)*sizeof(digit)) : etmp_static;
+    digit * restrict const x2 = use_heap ? ws_push(x2len) : x2_static;
+    digit * restrict const etmp = use_heap ? ws_push(x2len<<1) : etmp_static;
     
     for(ncorrect=1; ncorrect<ndigs_e; ) {
         DBG_PRINTF("ncorrect=%d\n",ncorrect);
@@ -177,8 +177,9 @@ inverse(digit *restrict e_digits, int ndigs_e, int nbits_e,
         // multiplication below is based on the knowledge
         // that nx2 is an even number, that the most significant bit is zero, and
         // that every second bit in x2 is zero because x2 is a square.
+        // Only the ncorrect_new+1 most significant digits are used.
         //
-        mul_nl_nr(etmp, &d[ndigs_e-ncorrect_new], ncorrect_new, x2, nx2);
+        mulhi(&etmp[nn-ncorrect_new-1], &d[ndigs_e-ncorrect_new], ncorrect_new, x2, nx2, ncorrect_new+1);
         // The 2 highest bits of etmp is now 0
         DBG_PRINTF_DIGITS("etmp=", etmp, nn);
 
@@ -198,9 +199,9 @@ inverse(digit *restrict e_digits, int ndigs_e, int nbits_e,
     DBG_ASSERT(ncorrect == ndigs_e);
 
     if(use_heap) {
-        free(etmp);
-        free(x2);
-        free(d);
+        ws_pop(etmp, x2len<<1);
+        ws_pop(x2, x2len);
+        ws_pop(d, ndigs_e);
     }
 
     // Shift e_digits from left-aligned to properly right-aligned
@@ -212,3 +213,85 @@ inverse(digit *restrict e_digits, int ndigs_e, int nbits_e,
 
     return;
 }
+
+static void
+inverse(digit *restrict e_digits, int ndigs_e, int nbits_e,
+        const digit * restrict d_digits, int ndigs_d, int nbits_d)
+//
+// Same as inverse_newton, counted in the stats
+//
+{
+    STATS_BEGIN();
+    stats_size(STATS_INVERSE, nbits_e);
+    inverse_newton(e_digits, ndigs_e, nbits_e, d_digits, ndigs_d, nbits_d);
+    STATS_END(STATS_INVERSE);
+}
+
+//
+// Inverse table for odd 8-bit d, indexed by d>>1. Table lists rinv(d) where
+// rinv(d)*d = 1 + (r << 8)
+//
+static const uint8_t rinv_8[1<<7] = {
+    0x01,0xff,0x55,0xdb,0x49,0x97,0x9d,0x33,0x11,0xaf,0x45,0x8b,0x59,0xc7,0x8d,0x63,
+    0x21,0x5f,0x75,0x7b,0x69,0x37,0xbd,0x93,0x31,0x0f,0x65,0x2b,0x79,0x67,0xad,0xc3,
+    0x41,0xbf,0x15,0x9b,0x09,0xd7,0xdd,0x73,0x51,0xef,0x05,0xcb,0x19,0x87,0xcd,0x23,
+    0x61,0x1f,0x35,0x3b,0x29,0x77,0xfd,0xd3,0x71,0x4f,0x25,0x6b,0x39,0x27,0xed,0x83,
+    0x81,0x7f,0xd5,0x5b,0xc9,0x17,0x1d,0xb3,0x91,0x2f,0xc5,0x0b,0xd9,0x47,0x0d,0xe3,
+    0xa1,0xdf,0xf5,0xfb,0xe9,0xb7,0x3d,0x13,0xb1,0x8f,0xe5,0xab,0xf9,0xe7,0x2d,0x43,
+    0xc1,0x3f,0x95,0x1b,0x89,0x57,0x5d,0xf3,0xd1,0x6f,0x85,0x4b,0x99,0x07,0x4d,0xa3,
+    0xe1,0x9f,0xb5,0xbb,0xa9,0xf7,0x7d,0x53,0xf1,0xcf,0xa5,0xeb,0xb9,0xa7,0x6d,0x03
+};
+
+static void
+rinverse(digit * restrict e_digits, int ndigs_e, int nbits_e,
+         const digit * restrict d_digits, int ndigs_d)
+//
+// Compute the x-adic inverse e of d, which must be odd, such that
+// e*d == 1 + (r << nbits_e)
+// i.e. e = d^-1 mod x^nbits_e. The Newton step for it is
+// e' = e^2*d mod x^2k, where e is correct to k bits, and the square is free
+// while the product is a short one.
+//
+{
+    DBG_ASSERT(d_digits[0] & 1);
+    DBG_ASSERT(ndigs_e == (nbits_e + (PyLong_SHIFT-1))/PyLong_SHIFT);
+
+    // Table and Newton steps within one word, 8 -> 16 -> 32 -> 64 bits
+    const uint64_t dw = div_word_get(d_digits, 0, GF2X_MIN(64, ndigs_d*PyLong_SHIFT));
+    uint64_t ew = rinv_8[(dw & 0xff) >> 1];
+    for(int k=8; k<GF2X_MIN(64, nbits_e); k*=2) {
+        uint64_t h;
+        const uint64_t e2 = mul_64_64(ew, ew, &h);
+        ew = mul_64_64(e2, dw, &h);
+        if(k < 32)
+            ew &= ((uint64_t)1 << 2*k) - 1;
+    }
+    memset(e_digits, 0, ndigs_e*sizeof(digit));
+    int ncorrect = GF2X_MIN(64/PyLong_SHIFT, ndigs_e);
+    for(int i=0; i<ncorrect; i++)
+        e_digits[i] = (digit)(ew >> (i*PyLong_SHIFT)) & PyLong_MASK;
+
+    // Newton steps on whole digits, with precisions halved down from ndigs_e so that
+    // the last step is not much more than needed, as in inverse_newton
+    int nsteps = 0;
+    int steps[32];
+    for(int n=ndigs_e; n>ncorrect; n=(n+1)/2)
+        steps[nsteps++] = n;
+
+    const int nbuf = 2*ndigs_e + ndigs_e;
+    digit * restrict const buf = ws_push(nbuf);
+    digit * restrict const x2 = buf;
+    digit * restrict const etmp = x2 + 2*ndigs_e;
+    while(nsteps > 0) {
+        const int ncorrect_new = steps[--nsteps];
+        square_n(x2, e_digits, ncorrect);
+        memset(etmp, 0, ncorrect_new*sizeof(digit));
+        mullo(etmp, x2, 2*ncorrect, d_digits, ndigs_d, ncorrect_new);
+        memcpy(&e_digits[ncorrect], &etmp[ncorrect], (ncorrect_new - ncorrect)*sizeof(digit));
+        ncorrect = ncorrect_new;
+    }
+    ws_pop(buf, nbuf);
+
+    if(nbits_e % PyLong_SHIFT)
+        e_digits[ndigs_e-1] &= ((digit)1 << (nbits_e % PyLong_SHIFT)) - 1;
+}
@@ -0,0 +1,94 @@
+/* -*- mode: c; c-basic-offset: 4; -*- */
+/*******************************************************************************
+ *
+ * Copyright (c) 2021 Oskar Enoksson. All rights reserved.
+ * Licensed under the MIT license. See LICENSE file in the project root for details.
+ *
+ * Description:
+ * Jump-ahead of linear recurrences with characteristic polynomial f
+ *
+ * The state of a Galois LFSR with characteristic polynomial f is a residue s mod f,
+ * and one step is s*x mod f. N steps are s*x^N mod f, so the jump polynomial
+ * x^N mod f is computed once, by squarings and shifts (field_xpow), and each
+ * stream is then advanced by one multiplication. The modulus may be given as a
+ * Field, to reuse its reduction context between calls.
+ *
+ *******************************************************************************/
+
+static FieldObject *
+jump_field(PyObject *modulus)
+//
+// New reference to the Field of the modulus, given as integer or Field
+//
+{
+    if(PyObject_TypeCheck(modulus, &FieldType)) {
+        Py_INCREF(modulus);
+        return (FieldObject *)modulus;
+    }
+    if(! PyLong_Check(modulus)) {
+        PyErr_SetString(PyExc_TypeError, "Modulus must be an integer or a Field");
+        return NULL;
+    }
+    return (FieldObject *)PyObject_CallFunctionObjArgs((PyObject *)&FieldType, modulus, NULL);
+}
+
+static PyObject *
+pygf2x_xpow_mod(PyObject *self, PyObject *args)
+//
+// xpow_mod(N, f): x^N mod f, where f is an integer or a Field
+//
+{
+    (void)self;
+    PyObject *N, *modulus;
+    if(!PyArg_ParseTuple(args, "O!O", &PyLong_Type, &N, &modulus))
+        return NULL;
+    if(((PyVarObject *)N)->ob_size < 0) {
+        PyErr_SetString(PyExc_ValueError, "Exponent must be non-negative");
+        return NULL;
+    }
+    FieldObject *F = jump_field(modulus);
+    if(F == NULL)
+        return NULL;
+    PyObject *r = NULL;
+    FieldElementObject *e = field_element_alloc(F);
+    if(e) {
+        field_xpow(F, e->v, ((PyLongObject *)N)->ob_digit, _PyLong_NumBits(N));
+        r = field_element_to_long(e);
+        Py_DECREF(e);
+    }
+    Py_DECREF(F);
+    return r;
+}
+
+static PyObject *
+pygf2x_apply_jump(PyObject *self, PyObject *args)
+//
+// apply_jump(state, jump_poly, f): state*jump_poly mod f, i.e. the Galois LFSR state
+// advanced by N steps when jump_poly = xpow_mod(N, f)
+//
+{
+    (void)self;
+    PyObject *state, *jump, *modulus;
+    if(!PyArg_ParseTuple(args, "OOO", &state, &jump, &modulus))
+        return NULL;
+    FieldObject *F = jump_field(modulus);
+    if(F == NULL)
+        return NULL;
+    PyObject *r = NULL;
+    FieldElementObject *s = field_coerce(F, state);
+    FieldElementObject *j = s ? field_coerce(F, jump) : NULL;
+    if(j) {
+        FieldElementObject *p = field_element_alloc(F);
+        if(p) {
+            field_mul(F, p->v, s->v, j->v);
+            r = field_element_to_long(p);
+            Py_DECREF(p);
+        }
+    } else if(! PyErr_Occurred()) {
+        PyErr_SetString(PyExc_TypeError, "State and jump polynomial must be integers or field elements");
+    }
+    Py_XDECREF(s);
+    Py_XDECREF(j);
+    Py_DECREF(F);
+    return r;
+}
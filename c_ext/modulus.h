@@ -0,0 +1,124 @@
+/* -*- mode: c; c-basic-offset: 4; -*- */
+/*******************************************************************************
+ *
+ * Copyright (c) 2021 Oskar Enoksson. All rights reserved.
+ * Licensed under the MIT license. See LICENSE file in the project root for details.
+ *
+ * Description:
+ * Reduction modulo a fixed polynomial over GF(2), using a precomputed inverse
+ *
+ * With n = degree of f and e = inverse(f) with n bits, i.e. e*f = x^(2n-1) + r,
+ * any c with at most 2n bits is reduced as (Barrett)
+ *   q = ((c >> n) * e) >> (n-1)
+ *   c mod f = (c + q*f) mod x^n
+ * which costs two multiplications of n-bit operands and no division.
+ *
+ *******************************************************************************/
+
+typedef struct {
+    int nbits_f;  // Bit length of the modulus f, i.e. its degree + 1
+    int ndigs_f;
+    int ndigs_r;  // Number of digits of a reduced residue, nbits_f-1 bits
+    digit *f;     // Modulus
+    digit *e;     // Inverse of f with nbits_f-1 bits
+} gf2x_modulus;
+
+static void
+rshift_extract(digit * restrict dst, int ndst, const digit * restrict src, int nsrc, int nb_shift)
+//
+// dst = src >> nb_shift, where dst is truncated to ndst digits
+//
+{
+    const int nd_shift = nb_shift/PyLong_SHIFT;
+    nb_shift = nb_shift%PyLong_SHIFT;
+    for(int i=0; i<ndst; i++) {
+        digit lo = i+nd_shift < nsrc ? src[i+nd_shift] : 0;
+        digit hi = i+nd_shift+1 < nsrc ? src[i+nd_shift+1] : 0;
+        dst[i] = (lo >> nb_shift) | ((hi << (PyLong_SHIFT - nb_shift)) & PyLong_MASK);
+    }
+}
+
+static int
+modulus_init(gf2x_modulus *m, const digit *f, int nbits_f)
+//
+// Prepare reduction modulo f, which has nbits_f>=2 bits
+// Return 0 on success or -1 with MemoryError set
+//
+{
+    DBG_ASSERT(nbits_f >= 2);
+    m->nbits_f = nbits_f;
+    m->ndigs_f = (nbits_f + (PyLong_SHIFT-1))/PyLong_SHIFT;
+    m->ndigs_r = (nbits_f - 1 + (PyLong_SHIFT-1))/PyLong_SHIFT;
+    m->f = malloc(m->ndigs_f*sizeof(digit));
+    m->e = calloc(m->ndigs_r, sizeof(digit));
+    if(!m->f || !m->e) {
+        free(m->f);
+        free(m->e);
+        m->f = m->e = NULL;
+        PyErr_NoMemory();
+        return -1;
+    }
+    memcpy(m->f, f, m->ndigs_f*sizeof(digit));
+    inverse(m->e, m->ndigs_r, nbits_f-1, m->f, m->ndigs_f, nbits_f);
+    return 0;
+}
+
+static void
+modulus_free(gf2x_modulus *m)
+{
+    free(m->f);
+    free(m->e);
+    m->f = m->e = NULL;
+}
+
+static void
+modulus_reduce(const gf2x_modulus *m, digit * restrict r, const digit * restrict c, int ndigs_c)
+//
+// r = c mod f, where c has at most 2*(nbits_f-1) bits and r has ndigs_r digits
+//
+{
+    const int n = m->nbits_f - 1;
+    const int nd = m->ndigs_r;
+    DBG_ASSERT(ndigs_c <= 2*nd);
+
+    const int nbuf = 5*nd + m->ndigs_f;
+    digit buf_static[STATIC_LIMIT*4];
+    const bool use_heap = (size_t)nbuf > sizeof(buf_static)/sizeof(digit);
+    digit * restrict const buf = use_heap ? ws_push(nbuf) : buf_static;
+    digit * restrict const t = buf;          // c >> n
+    digit * restrict const te = t + nd;      // t*e
+    digit * restrict const q = te + 2*nd;    // Quotient
+    digit * restrict const qf = q + nd;      // q*f
+
+    rshift_extract(t, nd, c, ndigs_c, n);
+    int nt = nd;
+    while(nt > 0 && t[nt-1] == 0)
+        nt--;
+    if(nt == 0) {
+        // Already reduced
+        for(int i=0; i<nd; i++)
+            r[i] = i < ndigs_c ? c[i] : 0;
+        if(use_heap)
+            ws_pop(buf, nbuf);
+        return;
+    }
+
+    memset(te, 0, 2*nd*sizeof(digit));
+    mul_nl_nr(te, t, nt, m->e, nd);
+    rshift_extract(q, nd, te, 2*nd, n-1);
+    int nq = nd;
+    while(nq > 0 && q[nq-1] == 0)
+        nq--;
+    DBG_ASSERT(nq > 0);
+
+    memset(qf, 0, (nq + m->ndigs_f)*sizeof(digit));
+    mul_sparse_or_dense(qf, q, nq, m->f, m->ndigs_f);
+    for(int i=0; i<nd; i++)
+        r[i] = (i < ndigs_c ? c[i] : 0) ^ qf[i];
+    if(n % PyLong_SHIFT)
+        r[nd-1] &= ((digit)1 << (n % PyLong_SHIFT)) - 1;
+    DBG_ASSERT(((r[nd-1] >> ((n-1) % PyLong_SHIFT)) >> 1) == 0);
+
+    if(use_heap)
+        ws_pop(buf, nbuf);
+}
@@ -8,6 +8,217 @@
  * Implementation of multiplication on unlimited polynomials over GF(2)
  *
  *******************************************************************************/
+static void mul_nl_nr(digit * restrict p,
+                      const digit * restrict const l0, int nl,
+                      const digit * restrict const r0, int nr);
+
+//
+// Toom-(4,2) for unbalanced factors
+//
+// With r split in halves of h digits and a block of 4h digits of l in quarters, and
+// y = x^(h*PyLong_SHIFT),
+//
+//   l(y) = L0 + L1 y + L2 y^2 + L3 y^3,   r(y) = R0 + R1 y
+//
+// the product c(y) = C0 + ... + C4 y^4 is interpolated from its values at the points
+// 0, 1, x, x+1 and infinity, which are five products of h digits instead of the six of
+// two Karatsuba products of 2h digits. Over GF(2)[x] the points x and x+1 cost only
+// shifts to evaluate, and the interpolation divides exactly by x and x+1 (Bodrato).
+// The values of r at the points are computed once and shared by all blocks of l, and
+// a Multiplier keeps them with its fixed factor.
+//
+
+static inline void
+toom_xor_lshift(digit * restrict r, const digit *a, int n, int s)
+//
+// r ^= a << s, where a has n digits, r has n+1 and 0 <= s < PyLong_SHIFT
+//
+{
+    digit c = 0;
+    for(int i=0; i<n; i++) {
+        r[i] ^= ((a[i] << s) & PyLong_MASK) | c;
+        c = s ? a[i] >> (PyLong_SHIFT - s) : 0;
+    }
+    r[n] ^= c;
+}
+
+static inline void
+toom_rshift1(digit *a, int n)
+//
+// a = a/x, where a has n digits and is divisible by x
+//
+{
+    for(int i=0; i<n-1; i++)
+        a[i] = (a[i] >> 1) | ((a[i+1] & 1) << (PyLong_SHIFT-1));
+    a[n-1] >>= 1;
+}
+
+static inline void
+toom_div_x1(digit *a, int n)
+//
+// a = a/(x+1), where a has n digits and is divisible by x+1. Bit i of the quotient
+// is the sum of bits 0..i of a.
+//
+{
+    digit c = 0;
+    for(int i=0; i<n; i++) {
+        uint32_t v = a[i];
+        v ^= v << 1;
+        v ^= v << 2;
+        v ^= v << 4;
+        v ^= v << 8;
+        v ^= v << 16;
+        v = (v & PyLong_MASK) ^ c;
+        a[i] = (digit)v;
+        c = (v >> (PyLong_SHIFT-1)) ? PyLong_MASK : 0;
+    }
+}
+
+// Digits of the values of a factor of n digits at the points 1, x and x+1
+#define TOOM_NVALUES(n) (3*(((n) + 1) >> 1) + 2)
+
+static void
+toom_values(digit * restrict v, const digit *r, int nr)
+//
+// The values r(1), r(x), r(x+1) of r split in halves, in TOOM_NVALUES(nr) digits at v
+//
+{
+    const int h = (nr + 1) >> 1;
+    const int nr1 = nr - h;
+    const digit *r1 = r + h;
+    digit * restrict const r01 = v;
+    digit * restrict const rx = r01 + h;
+    digit * restrict const rx1 = rx + h+1;
+    for(int i=0; i<h; i++) {
+        r01[i] = r[i] ^ (i < nr1 ? r1[i] : 0);
+        rx[i] = r[i];
+        rx1[i] = r01[i];
+    }
+    rx[h] = rx1[h] = 0;
+    toom_xor_lshift(rx, r1, nr1, 1);
+    toom_xor_lshift(rx1, r1, nr1, 1);
+}
+
+static int
+mul_toom42_values(digit * restrict p, const digit *l, int nl, const digit *r, int nr, const digit *v)
+//
+// p ^= l*r for the blocks of 4h digits of l, where h = ceil(nr/2) and nl >= 4h, and
+// v holds the values of r by toom_values. Return the number of digits of l done, a
+// multiple of 4h.
+//
+{
+    const int h = (nr + 1) >> 1;
+    const int nr1 = nr - h;
+    const int nblocks = nl/(4*h);
+    const int ne = h+1;        // Digits of a value at x or x+1
+    const int nw = 2*ne;       // Digits of a product of values
+    const digit *r1 = r + h;
+    const digit *r01 = v;      // r(1), r(x), r(x+1)
+    const digit *rx = r01 + h;
+    const digit *rx1 = rx + ne;
+
+    const int nbuf = h + 2*ne + 5*nw;
+    digit * const buf = ws_push(nbuf);
+    digit * restrict const l01 = buf;           // l(1), l(x), l(x+1) of a block
+    digit * restrict const lx = l01 + h;
+    digit * restrict const lx1 = lx + ne;
+    digit * restrict const w0 = lx1 + ne;       // The products at the points 0, 1, x, x+1, infinity
+    digit * restrict const w1 = w0 + nw;
+    digit * restrict const wx = w1 + nw;
+    digit * restrict const wx1 = wx + nw;
+    digit * restrict const winf = wx1 + nw;
+
+    for(int ib=0; ib<nblocks; ib++) {
+        const digit *L0 = l + 4*h*ib;
+        const digit *L1 = L0 + h;
+        const digit *L2 = L1 + h;
+        const digit *L3 = L2 + h;
+        digit * restrict const pb = p + 4*h*ib;
+
+        // l(x) = L0 + L1 x + L2 x^2 + L3 x^3
+        // l(x+1) = l(1) + (L1+L3) x + (L2+L3) x^2 + L3 x^3
+        uint64_t cx = 0, cx1 = 0;
+        for(int i=0; i<h; i++) {
+            const uint64_t a1 = L1[i], a2 = L2[i], a3 = L3[i];
+            const digit s = L0[i] ^ L1[i] ^ L2[i] ^ L3[i];
+            const uint64_t vx = L0[i] ^ (a1 << 1) ^ (a2 << 2) ^ (a3 << 3) ^ cx;
+            const uint64_t vx1 = s ^ ((a1 ^ a3) << 1) ^ ((a2 ^ a3) << 2) ^ (a3 << 3) ^ cx1;
+            l01[i] = s;
+            lx[i] = vx & PyLong_MASK;
+            lx1[i] = vx1 & PyLong_MASK;
+            cx = vx >> PyLong_SHIFT;
+            cx1 = vx1 >> PyLong_SHIFT;
+        }
+        lx[h] = (digit)cx;
+        lx1[h] = (digit)cx1;
+
+        memset(w0, 0, 5*nw*sizeof(digit));
+        mul_nl_nr(w0, L0, h, r, h);
+        mul_nl_nr(w1, l01, h, r01, h);
+        mul_nl_nr(wx, lx, ne, rx, ne);
+        mul_nl_nr(wx1, lx1, ne, rx1, ne);
+        mul_nl_nr(winf, L3, h, r1, nr1);
+
+        // With C0 = w0 and C4 = winf known, remove them from the other values:
+        //   w1 = C1 + C2 + C3
+        //   wx = (C1 + C2 x + C3 x^2) x
+        //   wx1 = (C1 + C2 (x+1) + C3 (x+1)^2) (x+1)
+        for(int i=0; i<2*h; i++) {
+            w1[i] ^= w0[i] ^ winf[i];
+            wx[i] ^= w0[i];
+            wx1[i] ^= w0[i] ^ winf[i];
+        }
+        toom_xor_lshift(wx, winf, 2*h, 4);
+        toom_xor_lshift(wx1, winf, 2*h, 4);
+
+        // wx = (wx/x + w1)/(x+1) = C2 + C3 (x+1)
+        // wx1 = (wx1/(x+1) + w1)/x = C2 + C3 x
+        toom_rshift1(wx, nw);
+        toom_div_x1(wx1, nw);
+        for(int i=0; i<nw; i++) {
+            wx[i] ^= w1[i];
+            wx1[i] ^= w1[i];
+        }
+        toom_div_x1(wx, nw);
+        toom_rshift1(wx1, nw);
+
+        // C3 = wx + wx1, C2 = wx1 + C3 x, C1 = w1 + C2 + C3
+        for(int i=0; i<nw; i++)
+            wx[i] ^= wx1[i];
+        toom_xor_lshift(wx1, wx, nw-1, 1);
+        for(int i=0; i<nw; i++)
+            w1[i] ^= wx[i] ^ wx1[i];
+
+        // p += C0 + C1 y + C2 y^2 + C3 y^3 + C4 y^4, each Ci of 2h digits
+        for(int i=0; i<2*h; i++) {
+            pb[i] ^= w0[i];
+            pb[h+i] ^= w1[i];
+            pb[2*h+i] ^= wx1[i];
+            pb[3*h+i] ^= wx[i];
+        }
+        for(int i=0; i<h+nr1; i++)
+            pb[4*h+i] ^= winf[i];
+        DBG_ASSERT(w1[2*h] == 0 && w1[2*h+1] == 0 && wx[2*h] == 0 && wx[2*h+1] == 0);
+    }
+    ws_pop(buf, nbuf);
+    return 4*h*nblocks;
+}
+
+static int
+mul_toom42(digit * restrict p, const digit *l, int nl, const digit *r, int nr)
+//
+// p ^= l*r for the blocks of 4h digits of l, where h = ceil(nr/2) and nl >= 4h.
+// Return the number of digits of l done, a multiple of 4h.
+//
+{
+    const int nv = TOOM_NVALUES(nr);
+    digit * const v = ws_push(nv);
+    toom_values(v, r, nr);
+    const int nt = mul_toom42_values(p, l, nl, r, nr, v);
+    ws_pop(v, nv);
+    return nt;
+}
+
 static void mul_nl_nr(digit * restrict p,
                       const digit * restrict const l0, int nl,
                       const digit * restrict const r0, int nr)
@@ -18,7 +229,24 @@ static void mul_nl_nr(digit * restrict p,
 #ifdef DEBUG_PYGF2X
     static int depth = 0;
 #endif
-    if(nl == 1) {
+    STATS_BEGIN();
+    if(pygf2x_stats.enabled) {
+        if(pygf2x_stats.mul_depth == 0)
+            stats_size(STATS_MUL_NL_NR, (uint64_t)GF2X_MAX(nl, nr)*PyLong_SHIFT);
+        pygf2x_stats.mul_depth_calls[GF2X_MIN(pygf2x_stats.mul_depth, STATS_NBUCKETS-1)]++;
+        pygf2x_stats.mul_depth++;
+    }
+    if(l0 == r0 && nl == nr) {
+        // Squaring is linear, p += l^2
+        digit bufs[STATIC_LIMIT*8];
+        const bool use_heap = (size_t)(2*nl) > sizeof(bufs)/sizeof(digit);
+        digit * const sq = use_heap ? ws_push(2*nl) : bufs;
+        square_n(sq, l0, nl);
+        for(int i=0; i<2*nl; i++)
+            p[i] ^= sq[i];
+        if(use_heap)
+            ws_pop(sq, 2*nl);
+    } else if(nl == 1) {
         // Stop recursing
         DBG_PRINTF("%-2d:[0,%d],[0,%d]\n",depth,nl,nr);
         if(l0[0] < (1 << ATOM))
@@ -40,30 +268,36 @@ static void mul_nl_nr(digit * restrict p,
 #endif
         else
             mul_digit_nr(p, r0[0], l0, nl);
-    } else if(nr < KARATSUBA_LIMIT && nl < KARATSUBA_LIMIT) {
+    } else if(nr < karatsuba_limit && nl < karatsuba_limit) {
         // Perform standard multiplication
         mul_nl_nr_IMPL(p, l0, nl, r0, nr);
-    } else if(nl > 2*nr) {
-        // Divide l to form more equal sized pieces
-        int nc = nl/nr; // Number of chunks
+    } else if(nl >= 2*nr) {
+        // Toom-(4,2) on blocks of l, then divide the rest of l to form more equal sized pieces
+        const bool toom = toom_limit > 0 && nr >= toom_limit && nl >= 4*((nr+1) >> 1);
+        const int nt = toom ? mul_toom42(p, l0, nl, r0, nr) : 0;  // Digits of l done
+        const int nc = nl > nt ? GF2X_MAX((nl-nt)/nr, 1) : 0; // Number of chunks
         for(int ic=0; ic<nc; ic++) {
-            int icu = (ic+1)*nl/nc;
-            int icl = ic*nl/nc;
+            int icu = nt + (ic+1)*(nl-nt)/nc;
+            int icl = nt + ic*(nl-nt)/nc;
             mul_nl_nr(p+icl, l0+icl, icu-icl, r0, nr);
         }
-    } else if(nr > 2*nl) {
-        // Divide r to form more equal sized pieces
-        int nc = nr/nl; // Number of chunks
+    } else if(nr >= 2*nl) {
+        // Toom-(4,2) on blocks of r, then divide the rest of r to form more equal sized pieces
+        const bool toom = toom_limit > 0 && nl >= toom_limit && nr >= 4*((nl+1) >> 1);
+        const int nt = toom ? mul_toom42(p, r0, nr, l0, nl) : 0;  // Digits of r done
+        const int nc = nr > nt ? GF2X_MAX((nr-nt)/nl, 1) : 0; // Number of chunks
         for(int ic=0; ic<nc; ic++) {
-            int icu = (ic+1)*nr/nc;
-            int icl = ic*nr/nc;
+            int icu = nt + (ic+1)*(nr-nt)/nc;
+            int icl = nt + ic*(nr-nt)/nc;
             mul_nl_nr(p+icl, l0, nl, r0+icl, icu-icl);
         }
     } else if(nl>1 && nr>1) {
         // Use Karatsuba
-        // The choice of m is not obvious
-        // Below 
-        const int m = (GF2X_MIN(nl,nr) + (abs(nl-nr)&1)) >>1;
+        // Equal factors are split in halves. Unequal ones are split at half the longer,
+        // so that l0*r0 and l01*r01 are balanced and only the short l1*r1 is not. Splitting
+        // at half the shorter instead leaves l1 up to three times longer than r1.
+        const int m = nl == nr ? nl >> 1 :
+            GF2X_MIN((GF2X_MAX(nl,nr) + 1) >> 1, GF2X_MIN(nl,nr) - 1);
         const int nl1 = nl-m;
         const int nr1 = nr-m;
         const digit * restrict l1 = l0+m;
@@ -80,7 +314,7 @@ static void mul_nl_nr(digit * restrict p,
         const int nbuf = nl01+nr01+nz0+nz1+nz2;
         digit bufs[STATIC_LIMIT*8];
         const bool use_heap = (size_t)nbuf > sizeof(bufs)/sizeof(digit);
-        digit * const buf0 = use_heap ? malloc(nbuf*sizeof(digit)) : bufs;
+        digit * const buf0 = use_heap ? ws_push(nbuf) : bufs;
         digit * buf = buf0;
         
         digit * restrict const r01 = buf; buf += nr01;   // r01 = r0^r1
@@ -152,6 +386,9 @@ static void mul_nl_nr(digit * restrict p,
 
         DBG_ASSERT(buf-buf0 == nbuf);
         if(use_heap)
-            free(buf0);
+            ws_pop(buf0, nbuf);
+    }
+    if(pygf2x_stats.enabled && --pygf2x_stats.mul_depth == 0) {
+        STATS_END(STATS_MUL_NL_NR);
     }
 }
@@ -0,0 +1,199 @@
+/* -*- mode: c; c-basic-offset: 4; -*- */
+/*******************************************************************************
+ *
+ * Copyright (c) 2021 Oskar Enoksson. All rights reserved.
+ * Licensed under the MIT license. See LICENSE file in the project root for details.
+ *
+ * Description:
+ * Short products: the low or the high digits of a product over GF(2)
+ *
+ * With a = a0 + x^k a1 and b = b0 + x^k b1, where n/2 <= k < n digits,
+ *
+ *   a*b mod x^n = a0*b0 + x^k (a1*b0 + a0*b1 mod x^(n-k))   (mod x^n)
+ *
+ * so a short product of n digits is one full product of k digits and two short
+ * products of n-k digits (Mulders). With Karatsuba multiplication, k = 0.7n makes the
+ * short product cost about 0.8 of the full one.
+ *
+ * Without carries, reversing the bit order of the operands reverses the bit order of
+ * the product, so the high digits are the reversed low digits of the product of the
+ * reversed operands. That is exact and costs only linear time on top of mullo.
+ *
+ *******************************************************************************/
+
+static void
+mullo(digit * restrict p, const digit *a, int na, const digit *b, int nb, int n)
+//
+// p ^= a*b mod x^(n*PyLong_SHIFT), where p has n digits
+//
+{
+    na = GF2X_MIN(na, n);
+    nb = GF2X_MIN(nb, n);
+    while(na > 0 && a[na-1] == 0)
+        na--;
+    while(nb > 0 && b[nb-1] == 0)
+        nb--;
+    if(na == 0 || nb == 0)
+        return;
+    if(na + nb <= n) {
+        // Nothing to truncate
+        mul_nl_nr(p, a, na, b, nb);
+        return;
+    }
+    if(n < karatsuba_limit) {
+        // Full product of the truncated operands
+        digit * restrict t = ws_push(na + nb);
+        memset(t, 0, (na + nb)*sizeof(digit));
+        mul_nl_nr(t, a, na, b, nb);
+        for(int i=0; i<n; i++)
+            p[i] ^= t[i];
+        ws_pop(t, na + nb);
+        return;
+    }
+
+    const int k = GF2X_MAX((7*n + 9)/10, (n + 1)/2);
+    const int ka = GF2X_MIN(na, k);
+    const int kb = GF2X_MIN(nb, k);
+    digit * restrict t = ws_push(ka + kb);
+    memset(t, 0, (ka + kb)*sizeof(digit));
+    mul_nl_nr(t, a, ka, b, kb);
+    for(int i=0; i<GF2X_MIN(n, ka + kb); i++)
+        p[i] ^= t[i];
+    ws_pop(t, ka + kb);
+    if(na > k)
+        mullo(p + k, a + k, na - k, b, nb, n - k);
+    if(nb > k)
+        mullo(p + k, a, na, b + k, nb - k, n - k);
+}
+
+static inline digit
+rev_digit(digit d)
+// Reverse the PyLong_SHIFT bits of d
+{
+    uint32_t x = d;
+    x = ((x >> 1) & 0x55555555) | ((x & 0x55555555) << 1);
+    x = ((x >> 2) & 0x33333333) | ((x & 0x33333333) << 2);
+    x = ((x >> 4) & 0x0f0f0f0f) | ((x & 0x0f0f0f0f) << 4);
+    x = ((x >> 8) & 0x00ff00ff) | ((x & 0x00ff00ff) << 8);
+    x = (x >> 16) | (x << 16);
+    return (digit)(x >> (32 - PyLong_SHIFT));
+}
+
+static void
+mulhi(digit * restrict p, const digit *a, int na, const digit *b, int nb, int n)
+//
+// p ^= the n most significant of the na+nb digits of a*b, where p has n <= na+nb digits
+//
+{
+    DBG_ASSERT(n <= na + nb);
+    if(n <= 0)
+        return;
+    const int nbuf = na + nb + 2*n + 1;
+    digit * restrict const ra = ws_push(nbuf);
+    digit * restrict const rb = ra + na;
+    digit * restrict const c = rb + nb;
+    digit * restrict const rc = c + n;
+    for(int i=0; i<na; i++)
+        ra[i] = rev_digit(a[na-1-i]);
+    for(int i=0; i<nb; i++)
+        rb[i] = rev_digit(b[nb-1-i]);
+    memset(c, 0, n*sizeof(digit));
+    mullo(c, ra, na, rb, nb, n);
+
+    // The product has at most (na+nb)*PyLong_SHIFT-1 bits, so its reversal is one bit short
+    for(int i=0; i<n; i++)
+        rc[i] = rev_digit(c[n-1-i]);
+    rc[n] = 0;
+    for(int i=0; i<n; i++)
+        p[i] ^= (rc[i] >> 1) | ((rc[i+1] << (PyLong_SHIFT-1)) & PyLong_MASK);
+    ws_pop(ra, nbuf);
+}
+
+static int
+mullo_parse(PyObject *args, PyLongObject **a, PyLongObject **b, Py_ssize_t *n)
+//
+// Parse (a, b, n) for mullo and mulhi, return -1 with exception set on failure
+//
+{
+    if(!PyArg_ParseTuple(args, "O!O!n", &PyLong_Type, a, &PyLong_Type, b, n))
+        return -1;
+    if(((PyVarObject *)*a)->ob_size < 0 || ((PyVarObject *)*b)->ob_size < 0) {
+        PyErr_SetString(PyExc_ValueError, "Factors must be non-negative");
+        return -1;
+    }
+    if(*n < 0) {
+        PyErr_SetString(PyExc_ValueError, "Number of bits must be non-negative");
+        return -1;
+    }
+    if(((PyVarObject *)*a)->ob_size + ((PyVarObject *)*b)->ob_size > PYGF2X_MAX_DIGITS) {
+        PyErr_SetString(PyExc_OverflowError, "Result of multiplication is out of range");
+        return -1;
+    }
+    return 0;
+}
+
+static PyObject *
+pylong_trim(PyLongObject *p, int ndigs)
+// Set the size of p to ndigs digits without leading zeros
+{
+    while(ndigs > 0 && p->ob_digit[ndigs-1] == 0)
+        ndigs--;
+    ((PyVarObject *)p)->ob_size = ndigs;
+    return (PyObject *)p;
+}
+
+static PyObject *
+pygf2x_mullo(PyObject *self, PyObject *args)
+//
+// mullo(a, b, n): the n least significant bits of a*b
+//
+{
+    (void)self;
+    PyLongObject *a, *b;
+    Py_ssize_t nbits;
+    if(mullo_parse(args, &a, &b, &nbits))
+        return NULL;
+    const int na = ((PyVarObject *)a)->ob_size;
+    const int nb = ((PyVarObject *)b)->ob_size;
+    const int n = (int)GF2X_MIN((Py_ssize_t)(na + nb), (nbits + (PyLong_SHIFT-1))/PyLong_SHIFT);
+    if(na == 0 || nb == 0 || n == 0)
+        return PyLong_FromLong(0);
+    PyLongObject *p = pylong_new(n);
+    if(p == NULL)
+        return NULL;
+    memset(p->ob_digit, 0, n*sizeof(digit));
+    mullo(p->ob_digit, a->ob_digit, na, b->ob_digit, nb, n);
+    if(nbits < (Py_ssize_t)n*PyLong_SHIFT)
+        p->ob_digit[n-1] &= ((digit)1 << (nbits % PyLong_SHIFT)) - 1;
+    return pylong_trim(p, n);
+}
+
+static PyObject *
+pygf2x_mulhi(PyObject *self, PyObject *args)
+//
+// mulhi(a, b, n): a*b >> n
+//
+{
+    (void)self;
+    PyLongObject *a, *b;
+    Py_ssize_t nbits;
+    if(mullo_parse(args, &a, &b, &nbits))
+        return NULL;
+    const int na = ((PyVarObject *)a)->ob_size;
+    const int nb = ((PyVarObject *)b)->ob_size;
+    const int n = (int)GF2X_MAX(0, (Py_ssize_t)(na + nb) - nbits/PyLong_SHIFT);
+    if(na == 0 || nb == 0 || n == 0)
+        return PyLong_FromLong(0);
+    PyLongObject *p = pylong_new(n);
+    if(p == NULL)
+        return NULL;
+    memset(p->ob_digit, 0, n*sizeof(digit));
+    mulhi(p->ob_digit, a->ob_digit, na, b->ob_digit, nb, n);
+    const int shift = nbits % PyLong_SHIFT;
+    if(shift) {
+        for(int i=0; i<n-1; i++)
+            p->ob_digit[i] = (p->ob_digit[i] >> shift) | ((p->ob_digit[i+1] << (PyLong_SHIFT - shift)) & PyLong_MASK);
+        p->ob_digit[n-1] >>= shift;
+    }
+    return pylong_trim(p, n);
+}
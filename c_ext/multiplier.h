@@ -0,0 +1,271 @@
+/* -*- mode: c; c-basic-offset: 4; -*- */
+/*******************************************************************************
+ *
+ * Copyright (c) 2021 Oskar Enoksson. All rights reserved.
+ * Licensed under the MIT license. See LICENSE file in the project root for details.
+ *
+ * Description:
+ * Multiplication of many polynomials over GF(2) by the same one
+ *
+ * A Multiplier holds a fixed factor b in the form its products need. A short b,
+ * of up to MLT_MAX_BLOCKS*512 bits, is kept as 64-bit words in blocks of 1, 2, 4 or 8
+ * words, the width of the fixed-width kernels. The other factor is packed into blocks
+ * of the same width, and the product is the sum of the block products, each one
+ * straight-line kernel call. That is much faster than the digit-wise schoolbook
+ * product for the long-times-short products of encoders and scramblers. A longer b
+ * is multiplied as by mul, but with the values of b at the points of Toom-(4,2)
+ * computed once. The Hamming weight of b is counted once, and a sparse b is
+ * multiplied by shifts, as by mul, whatever its length.
+ *
+ *******************************************************************************/
+
+// Max number of 512-bit blocks of b multiplied block-wise. Without a carry-less
+// multiply the block products are table based, and Karatsuba wins at fewer blocks.
+#ifdef PYGF2X_BATCH_BITSLICE
+#define MLT_MAX_BLOCKS 8
+#else
+#define MLT_MAX_BLOCKS 32
+#endif
+
+typedef struct {
+    PyObject_HEAD
+    PyLongObject *b;        // The fixed factor
+    int nbits;              // Bit length of b
+    int weight;             // Number of non-zero bits of b
+    int nw;                 // Words per block, or 0 if b is too long for blocks
+    int nblocks;            // Number of blocks of b
+    uint64_t *w;            // b in nblocks*nw words
+    digit *toom;            // Values of b by toom_values, if b is too long for blocks
+} MultiplierObject;
+
+static PyTypeObject MultiplierType;
+
+static inline void
+mlt_mul_blocks(uint64_t * restrict r, const uint64_t *a, int na, const uint64_t *b, int nb, int nw)
+//
+// r ^= a*b, where a and b have na and nb blocks of nw words and r has na+nb blocks
+//
+{
+    uint64_t t[16];
+    for(int i=0; i<na; i++)
+        for(int j=0; j<nb; j++) {
+            fw_mul(t, a + i*nw, b + j*nw, nw);
+            uint64_t * restrict const rij = r + (i+j)*nw;
+            for(int k=0; k<2*nw; k++)
+                rij[k] ^= t[k];
+        }
+}
+
+static PyObject *
+mlt_mul_pylong(const MultiplierObject *M, PyObject *a)
+//
+// a*b as a new Python integer
+//
+{
+    if(!PyLong_Check(a)) {
+        PyErr_SetString(PyExc_TypeError, "Factors must be integers");
+        return NULL;
+    }
+    if(((PyVarObject *)a)->ob_size < 0) {
+        PyErr_SetString(PyExc_ValueError, "Factors must be non-negative");
+        return NULL;
+    }
+    if(((PyVarObject *)a)->ob_size > PYGF2X_MAX_DIGITS) {
+        PyErr_SetString(PyExc_ValueError, "Factor is out of range");
+        return NULL;
+    }
+    const int na = ((PyVarObject *)a)->ob_size;
+    const int nb = ((PyVarObject *)M->b)->ob_size;
+    if(na == 0 || nb == 0)
+        return PyLong_FromLong(0);
+    const int nbits_a = nbits((PyLongObject *)a);
+    const int nbits_p = nbits_a + M->nbits - 1;
+    const int ndigs_p = (nbits_p + (PyLong_SHIFT-1))/PyLong_SHIFT;
+    if(ndigs_p > PYGF2X_MAX_DIGITS) {
+        PyErr_SetString(PyExc_OverflowError, "Result of multiplication is out of range");
+        return NULL;
+    }
+    const digit *a_digits = ((PyLongObject *)a)->ob_digit;
+    // A sparse factor is multiplied by shifts, as by mul, before any blocks
+    const int limit = sparse_limit(GF2X_MIN(na, nb));
+    const bool sparse_b = sparse_mul_limit > 0 && M->weight <= limit;
+    const bool sparse_a = sparse_mul_limit > 0 && !sparse_b && sparse_weight(a_digits, na, limit) <= limit;
+
+    if(M->nw && !sparse_b && !sparse_a) {
+        // a in blocks of the width of b, and the product in words
+        const int nw = M->nw;
+        const int nblocks_a = (nbits_a + 64*nw-1)/(64*nw);
+        const int nbuf = (2*nblocks_a + M->nblocks)*nw;
+        uint64_t * restrict const aw = ws_push_words(nbuf);
+        uint64_t * restrict const pw = aw + nblocks_a*nw;
+        fw_from_digits(aw, nblocks_a*nw, a_digits, na);
+        memset(pw, 0, (nblocks_a + M->nblocks)*nw*sizeof(uint64_t));
+        switch(nw) {
+        case 1: mlt_mul_blocks(pw, aw, nblocks_a, M->w, M->nblocks, 1); break;
+        case 2: mlt_mul_blocks(pw, aw, nblocks_a, M->w, M->nblocks, 2); break;
+        case 4: mlt_mul_blocks(pw, aw, nblocks_a, M->w, M->nblocks, 4); break;
+        default: mlt_mul_blocks(pw, aw, nblocks_a, M->w, M->nblocks, 8);
+        }
+        PyLongObject *p = pylong_new(ndigs_p);
+        if(p)
+            fw_to_digits(p->ob_digit, ndigs_p, pw, (nblocks_a + M->nblocks)*nw);
+        ws_pop_words(aw, nbuf);
+        return (PyObject *)p;
+    }
+
+    PyLongObject *p = pylong_new(na + nb);
+    if(p == NULL)
+        return NULL;
+    memset(p->ob_digit, 0, (na + nb)*sizeof(digit));
+    if(sparse_b)
+        mul_sparse(p->ob_digit, a_digits, na, M->b->ob_digit, nb);
+    else if(sparse_a)
+        mul_sparse(p->ob_digit, M->b->ob_digit, nb, a_digits, na);
+    else {
+        // Toom-(4,2) with the kept values of b where mul_nl_nr would use it, then the rest of a
+        int nt = 0;
+        if(M->toom && toom_limit > 0 && nb >= toom_limit && na >= 2*nb && na >= 4*((nb+1) >> 1))
+            nt = mul_toom42_values(p->ob_digit, a_digits, na, M->b->ob_digit, nb, M->toom);
+        if(nt < na)
+            mul_nl_nr(p->ob_digit + nt, a_digits + nt, na - nt, M->b->ob_digit, nb);
+    }
+    return pylong_trim(p, ndigs_p);
+}
+
+static PyObject *
+mlt_new(PyTypeObject *type, PyObject *args, PyObject *kwds)
+//
+// Multiplier(b)
+//
+{
+    static char *kwlist[] = {"b", NULL};
+    PyObject *b;
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "O!", kwlist, &PyLong_Type, &b))
+        return NULL;
+    if(((PyVarObject *)b)->ob_size < 0) {
+        PyErr_SetString(PyExc_ValueError, "Factor must be non-negative");
+        return NULL;
+    }
+    if(((PyVarObject *)b)->ob_size > PYGF2X_MAX_DIGITS) {
+        PyErr_SetString(PyExc_ValueError, "Factor is out of range");
+        return NULL;
+    }
+    MultiplierObject *M = (MultiplierObject *)type->tp_alloc(type, 0);
+    if(M == NULL)
+        return NULL;
+    Py_INCREF(b);
+    M->b = (PyLongObject *)b;
+    const int nb = ((PyVarObject *)b)->ob_size;
+    M->nbits = nbits(M->b);
+    for(int i=0; i<nb; i++)
+        M->weight += popcount_64(M->b->ob_digit[i]);
+
+    if(nb > 1 && M->nbits <= MLT_MAX_BLOCKS*512) {
+        M->nw = M->nbits <= 64 ? 1 : M->nbits <= 128 ? 2 : M->nbits <= 256 ? 4 : 8;
+        M->nblocks = (M->nbits + 64*M->nw-1)/(64*M->nw);
+        M->w = malloc(M->nblocks*M->nw*sizeof(uint64_t));
+        if(M->w == NULL) {
+            Py_DECREF(M);
+            return PyErr_NoMemory();
+        }
+        fw_from_digits(M->w, M->nblocks*M->nw, M->b->ob_digit, nb);
+    } else if(nb > 1) {
+        M->toom = malloc(TOOM_NVALUES(nb)*sizeof(digit));
+        if(M->toom == NULL) {
+            Py_DECREF(M);
+            return PyErr_NoMemory();
+        }
+        toom_values(M->toom, M->b->ob_digit, nb);
+    }
+    return (PyObject *)M;
+}
+
+static void
+mlt_dealloc(MultiplierObject *self)
+{
+    free(self->w);
+    free(self->toom);
+    Py_XDECREF(self->b);
+    Py_TYPE(self)->tp_free((PyObject *)self);
+}
+
+static PyObject *
+mlt_mul(MultiplierObject *self, PyObject *a)
+{
+    STATS_BEGIN();
+    PyObject *r = mlt_mul_pylong(self, a);
+    STATS_END(STATS_MUL);
+    return r;
+}
+
+static PyObject *
+mlt_mul_many(MultiplierObject *self, PyObject *factors)
+//
+// The products with all integers of an iterable, as a list
+//
+{
+    PyObject *seq = PySequence_Fast(factors, "Argument must be an iterable of integers");
+    if(seq == NULL)
+        return NULL;
+    const Py_ssize_t n = PySequence_Fast_GET_SIZE(seq);
+    PyObject **items = PySequence_Fast_ITEMS(seq);
+    STATS_BEGIN();
+    PyObject *l = PyList_New(n);
+    for(Py_ssize_t i=0; l && i<n; i++) {
+        PyObject *p = mlt_mul_pylong(self, items[i]);
+        if(p == NULL)
+            Py_CLEAR(l);
+        else
+            PyList_SET_ITEM(l, i, p);
+    }
+    STATS_END(STATS_MUL_BATCH);
+    Py_DECREF(seq);
+    return l;
+}
+
+static PyObject *
+mlt_get_b(MultiplierObject *self, void *closure)
+{
+    (void)closure;
+    Py_INCREF(self->b);
+    return (PyObject *)self->b;
+}
+
+static PyMethodDef mlt_methods[] =
+    {
+        {
+            "mul",
+            (PyCFunction)mlt_mul,
+            METH_O,
+            "Product of an integer with the fixed factor, as polynomials over GF(2)"
+        },
+        {
+            "mul_many",
+            (PyCFunction)mlt_mul_many,
+            METH_O,
+            "Products of all integers of an iterable with the fixed factor, as a list"
+        },
+        {NULL, NULL, 0, NULL}
+    };
+
+static PyGetSetDef mlt_getset[] =
+    {
+        {"b", (getter)mlt_get_b, NULL, "The fixed factor", NULL},
+        {NULL, NULL, NULL, NULL, NULL}
+    };
+
+static PyTypeObject MultiplierType =
+    {
+        PyVarObject_HEAD_INIT(NULL, 0)
+        .tp_name = "pygf2x.Multiplier",
+        .tp_basicsize = sizeof(MultiplierObject),
+        .tp_itemsize = 0,
+        .tp_dealloc = (destructor)mlt_dealloc,
+        .tp_flags = Py_TPFLAGS_DEFAULT,
+        .tp_doc = "Multiplier(b)\n"
+                  "Multiplication of integers as polynomials over GF(2) by the fixed factor b,\n"
+                  "prepared once for many products.",
+        .tp_methods = mlt_methods,
+        .tp_getset = mlt_getset,
+        .tp_new = mlt_new,
+    };
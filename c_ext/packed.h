@@ -0,0 +1,404 @@
+/* -*- mode: c; c-basic-offset: 4; -*- */
+/*******************************************************************************
+ *
+ * Copyright (c) 2021 Oskar Enoksson. All rights reserved.
+ * Licensed under the MIT license. See LICENSE file in the project root for details.
+ *
+ * Description:
+ * Polynomials over GF(2^k) = GF(2)[x]/f, k <= 64, in packed form
+ *
+ * A polynomial a(y) = sum a_i y^i over GF(2^k) is packed into one polynomial over
+ * GF(2) by the substitution y = x^s. In Python integers s = k, i.e. the coefficients
+ * are concatenated, coefficient i in bits k*i .. k*i+k-1.
+ *
+ * For products s = 2k-1 (Kronecker substitution). Coefficient l of a*b over GF(2)[x]
+ * is then the sum of the products a_i*b_j with i+j = l. Each has at most 2k-1 bits
+ * and without carries the sum has too, so it does not spill into the neighbouring
+ * coefficients. One mul_nl_nr of the packed operands thereby forms all coefficient
+ * products, and only the reduction of each coefficient modulo f remains.
+ *
+ * The reduction is done by table lookup, one byte of the part above x^k at a time, as
+ * in a table driven CRC: with c = h*x^k + l and h_i byte i of h,
+ *
+ *   c mod f = l + sum_i T_i[h_i],  where T_i[b] = b*x^(k+8i) mod f
+ *
+ * which takes no multiplication and at most 8 lookups, in one pass over the product.
+ *
+ *******************************************************************************/
+
+#define PK_MAX_K 64          // Largest coefficient size in bits
+#define PK_SCHOOLBOOK 4      // Products with a factor of at most this many coefficients are done directly
+
+#define PK_DIGITS ((int)(sizeof(uint64_t)/sizeof(digit)))  // Scratch digits per word
+
+typedef struct {
+    int k;                   // Degree of f
+    int nt;                  // Number of tables, one per byte above x^k of a product of two coefficients
+    uint64_t mask;           // x^k - 1
+    uint64_t t[8][256];      // t[i][b] = b*x^(k+8i) mod f
+} pk_reducer;
+
+static void
+pk_reducer_init(pk_reducer *R, uint64_t f, int k)
+//
+// Reduction tables for the modulus x^k + f, where f has less than k bits
+//
+{
+    R->k = k;
+    R->nt = (k-1 + 7)/8;
+    R->mask = k == 64 ? ~(uint64_t)0 : ((uint64_t)1 << k) - 1;
+    f &= R->mask;
+    uint64_t p = f;   // x^k mod f
+    for(int i=0; i<R->nt; i++) {
+        uint64_t *t = R->t[i];
+        t[0] = 0;
+        for(int j=0; j<8; j++) {
+            t[1 << j] = p;
+            const uint64_t top = (p >> (k-1)) & 1;
+            p = ((p << 1) & R->mask) ^ (top ? f : 0);
+        }
+        for(int b=3; b<256; b++) {
+            const int low = b & -b;
+            if(b != low)
+                t[b] = t[b ^ low] ^ t[low];
+        }
+    }
+}
+
+static inline uint64_t
+pk_reduce(const pk_reducer *R, uint64_t lo, uint64_t hi)
+//
+// (hi*x^64 + lo) mod f, where the argument has at most 2k-1 bits
+//
+{
+    const int k = R->k;
+    const uint64_t h = k == 64 ? hi : (lo >> k) | (hi << (64-k));
+    uint64_t r = lo & R->mask;
+    for(int i=0; i<R->nt; i++)
+        r ^= R->t[i][(h >> 8*i) & 0xff];
+    return r;
+}
+
+static inline uint64_t
+pk_mulmod(const pk_reducer *R, uint64_t a, uint64_t b)
+// a*b mod f
+{
+    uint64_t hi;
+    const uint64_t lo = mul_64_64(a, b, &hi);
+    return pk_reduce(R, lo, hi);
+}
+
+static inline void
+pk_put(uint64_t *w, int lo, uint64_t v, int t)
+//
+// w |= v << lo, where v has at most t bits, 1 <= t <= 64
+//
+{
+    const int iw = lo/64;
+    const int ib = lo%64;
+    w[iw] |= v << ib;
+    if(ib + t > 64)
+        w[iw+1] |= v >> (64 - ib);
+}
+
+static inline uint64_t
+pk_get(const uint64_t *w, int lo, int t)
+//
+// Return bits lo .. lo+t-1 of w, where 1 <= t <= 64
+//
+{
+    const int iw = lo/64;
+    const int ib = lo%64;
+    uint64_t v = w[iw] >> ib;
+    if(ib + t > 64)
+        v |= w[iw+1] << (64 - ib);
+    return t < 64 ? v & (((uint64_t)1 << t) - 1) : v;
+}
+
+static void
+pk_mul(const pk_reducer *R, uint64_t * restrict c,
+       const uint64_t *a, int na, const uint64_t *b, int nb)
+//
+// c = a*b with na+nb-1 coefficients, where na, nb >= 1
+//
+{
+    if(GF2X_MIN(na, nb) <= PK_SCHOOLBOOK) {
+        // Sum the unreduced coefficient products, and reduce once
+        for(int j=0; j<na+nb-1; j++) {
+            uint64_t lo = 0, hi = 0;
+            for(int i=GF2X_MAX(0, j-nb+1); i<=GF2X_MIN(j, na-1); i++) {
+                uint64_t h;
+                lo ^= mul_64_64(a[i], b[j-i], &h);
+                hi ^= h;
+            }
+            c[j] = pk_reduce(R, lo, hi);
+        }
+        return;
+    }
+
+    // Pack with 2k-1 bits per coefficient into words, convert to digits and multiply
+    const int k = R->k;
+    const int s = 2*k - 1;
+    const int nwa = (na*s + 63)/64;
+    const int nwb = (nb*s + 63)/64;
+    const int nda = (na*s + (PyLong_SHIFT-1))/PyLong_SHIFT;
+    const int ndb = (nb*s + (PyLong_SHIFT-1))/PyLong_SHIFT;
+    const int ndp = nda + ndb;
+    const int nwp = (ndp*PyLong_SHIFT + 63)/64;
+    const int nbuf = (nwa + nwb + nwp)*PK_DIGITS + 2*ndp;
+    digit * restrict buf = ws_push(nbuf);
+    uint64_t *wa = (uint64_t *)buf;
+    uint64_t *wb = wa + nwa;
+    uint64_t *wp = wb + nwb;
+    digit *da = (digit *)(wp + nwp);
+    digit *db = da + nda;
+    digit *p = db + ndb;
+
+    memset(wa, 0, (nwa + nwb)*sizeof(uint64_t));
+    for(int i=0; i<na; i++)
+        pk_put(wa, i*s, a[i], k);
+    for(int i=0; i<nb; i++)
+        pk_put(wb, i*s, b[i], k);
+    fw_to_digits(da, nda, wa, nwa);
+    fw_to_digits(db, ndb, wb, nwb);
+    memset(p, 0, ndp*sizeof(digit));
+    mul_nl_nr(p, da, nda, db, ndb);
+    fw_from_digits(wp, nwp, p, ndp);
+
+    // Unpack and reduce
+    if(s <= 64) {
+        for(int j=0; j<na+nb-1; j++)
+            c[j] = pk_reduce(R, pk_get(wp, j*s, s), 0);
+    } else {
+        for(int j=0; j<na+nb-1; j++)
+            c[j] = pk_reduce(R, pk_get(wp, j*s, 64), pk_get(wp, j*s + 64, s - 64));
+    }
+    ws_pop(buf, nbuf);
+}
+
+//
+// Conversion from and to Python integers in packed form
+//
+
+static uint64_t *
+pk_unpack_pylong(PyObject *a, int k, int *ncoefs)
+//
+// Coefficients of the packed non-negative integer a, malloc'ed, or NULL with
+// exception set. The count is that of the highest non-zero coefficient and below.
+//
+{
+    const int nbits = _PyLong_NumBits(a);
+    const int nc = (nbits + (k-1))/k;
+    const int nw = (nbits + 63)/64;
+    uint64_t *c = malloc((GF2X_MAX(nc, 1) + nw)*sizeof(uint64_t));
+    if(c == NULL) {
+        PyErr_NoMemory();
+        return NULL;
+    }
+    uint64_t *w = c + nc;
+    fw_from_digits(w, nw, ((PyLongObject *)a)->ob_digit, ((PyVarObject *)a)->ob_size);
+    for(int i=0; i<nc; i++)
+        c[i] = pk_get(w, i*k, GF2X_MIN(k, nbits - i*k));
+    *ncoefs = nc;
+    return c;
+}
+
+static PyObject *
+pk_pack_pylong(const uint64_t *c, int nc, int k)
+//
+// New packed integer of the nc coefficients c, each less than 2^k
+//
+{
+    while(nc > 0 && c[nc-1] == 0)
+        nc--;
+    const int nbits = nc ? (nc-1)*k + nbits_64(c[nc-1]) : 0;
+    const int ndigs = (nbits + (PyLong_SHIFT-1))/PyLong_SHIFT;
+    const int nw = (nbits + 63)/64;
+    PyLongObject *p = pylong_new(ndigs);
+    if(p == NULL || ndigs == 0)
+        return (PyObject *)p;
+    uint64_t *w = ws_push_words(nw);
+    memset(w, 0, nw*sizeof(uint64_t));
+    for(int i=0; i<nc; i++)
+        if(c[i])
+            pk_put(w, i*k, c[i], nbits_64(c[i]));
+    fw_to_digits(p->ob_digit, ndigs, w, nw);
+    ws_pop_words(w, nw);
+    return (PyObject *)p;
+}
+
+static int
+pk_parse_k(PyObject *k_obj)
+// The coefficient size k from a Python integer, or -1 with exception set
+{
+    const long k = PyLong_AsLong(k_obj);
+    if(k == -1 && PyErr_Occurred())
+        return -1;
+    if(k < 1 || k > PK_MAX_K) {
+        PyErr_SetString(PyExc_ValueError, "Coefficient size must be between 1 and 64 bits");
+        return -1;
+    }
+    return (int)k;
+}
+
+static bool
+pk_fits(int64_t ncoefs, int k)
+// Whether the Kronecker form of ncoefs coefficients is within PYGF2X_MAX_DIGITS
+{
+    return ncoefs*(2*k-1) <= (int64_t)PYGF2X_MAX_DIGITS*PyLong_SHIFT;
+}
+
+static int
+pk_check_packed(PyObject *a, int k)
+// 0 if a is a valid packed operand, or -1 with exception set
+{
+    if(((PyVarObject *)a)->ob_size < 0) {
+        PyErr_SetString(PyExc_ValueError, "Packed polynomial must be non-negative");
+        return -1;
+    }
+    if(((PyVarObject *)a)->ob_size > PYGF2X_MAX_DIGITS ||
+       !pk_fits((_PyLong_NumBits(a) + k-1)/k, k)) {
+        PyErr_SetString(PyExc_ValueError, "Argument is too large");
+        return -1;
+    }
+    return 0;
+}
+
+static PyObject *
+pygf2x_pack(PyObject *self, PyObject *args)
+//
+// pack(coeffs, k): integer holding coefficient i in bits k*i .. k*i+k-1
+//
+{
+    (void)self;
+    PyObject *coeffs, *k_obj;
+    if(!PyArg_ParseTuple(args, "OO!", &coeffs, &PyLong_Type, &k_obj))
+        return NULL;
+    const int k = pk_parse_k(k_obj);
+    if(k < 0)
+        return NULL;
+    PyObject *seq = PySequence_Fast(coeffs, "Coefficients must be a sequence");
+    if(seq == NULL)
+        return NULL;
+    const Py_ssize_t nc = PySequence_Fast_GET_SIZE(seq);
+    if((int64_t)nc*k > (int64_t)PYGF2X_MAX_DIGITS*PyLong_SHIFT) {
+        Py_DECREF(seq);
+        PyErr_SetString(PyExc_ValueError, "Too many coefficients");
+        return NULL;
+    }
+    uint64_t *c = malloc(GF2X_MAX(nc, 1)*sizeof(uint64_t));
+    PyObject *r = NULL;
+    if(c == NULL) {
+        PyErr_NoMemory();
+    } else {
+        Py_ssize_t i;
+        for(i=0; i<nc; i++) {
+            PyObject *o = PySequence_Fast_GET_ITEM(seq, i);
+            if(!PyLong_Check(o)) {
+                PyErr_SetString(PyExc_TypeError, "Coefficients must be integers");
+                break;
+            }
+            if(((PyVarObject *)o)->ob_size < 0 || _PyLong_NumBits(o) > (size_t)k) {
+                PyErr_SetString(PyExc_ValueError, "Coefficient is out of range");
+                break;
+            }
+            c[i] = PyLong_AsUnsignedLongLong(o);
+        }
+        if(i == nc)
+            r = pk_pack_pylong(c, (int)nc, k);
+        free(c);
+    }
+    Py_DECREF(seq);
+    return r;
+}
+
+static PyObject *
+pygf2x_unpack(PyObject *self, PyObject *args)
+//
+// unpack(a, k): list of the k-bit coefficients of a, up to the highest non-zero one
+//
+{
+    (void)self;
+    PyObject *a, *k_obj;
+    if(!PyArg_ParseTuple(args, "O!O!", &PyLong_Type, &a, &PyLong_Type, &k_obj))
+        return NULL;
+    const int k = pk_parse_k(k_obj);
+    if(k < 0 || pk_check_packed(a, k))
+        return NULL;
+    int nc;
+    uint64_t *c = pk_unpack_pylong(a, k, &nc);
+    if(c == NULL)
+        return NULL;
+    PyObject *l = PyList_New(nc);
+    for(int i=0; l && i<nc; i++) {
+        PyObject *v = PyLong_FromUnsignedLongLong(c[i]);
+        if(v == NULL)
+            Py_CLEAR(l);
+        else
+            PyList_SET_ITEM(l, i, v);
+    }
+    free(c);
+    return l;
+}
+
+static PyObject *
+pygf2x_mul_packed(PyObject *self, PyObject *args)
+//
+// mul_packed(a, b, k, modulus): product of the packed polynomials a and b over GF(2^k),
+// where modulus is the integer or Field defining GF(2^k)
+//
+{
+    (void)self;
+    PyObject *a, *b, *k_obj, *modulus;
+    if(!PyArg_ParseTuple(args, "O!O!O!O", &PyLong_Type, &a, &PyLong_Type, &b, &PyLong_Type, &k_obj, &modulus))
+        return NULL;
+    const int k = pk_parse_k(k_obj);
+    if(k < 0 || pk_check_packed(a, k) || pk_check_packed(b, k))
+        return NULL;
+
+    uint64_t f;
+    if(PyObject_TypeCheck(modulus, &FieldType)) {
+        const FieldObject *F = (FieldObject *)modulus;
+        if(F->n != k) {
+            PyErr_SetString(PyExc_ValueError, "Field degree must be k");
+            return NULL;
+        }
+        f = F->f[0];
+    } else if(PyLong_Check(modulus)) {
+        if(((PyVarObject *)modulus)->ob_size < 0 || _PyLong_NumBits(modulus) != (size_t)k+1) {
+            PyErr_SetString(PyExc_ValueError, "Modulus must have degree k");
+            return NULL;
+        }
+        f = div_word_get(((PyLongObject *)modulus)->ob_digit, 0, k);
+    } else {
+        PyErr_SetString(PyExc_TypeError, "Modulus must be an integer or a Field");
+        return NULL;
+    }
+
+    int na, nb;
+    uint64_t *ca = pk_unpack_pylong(a, k, &na);
+    uint64_t *cb = ca ? pk_unpack_pylong(b, k, &nb) : NULL;
+    if(cb == NULL) {
+        free(ca);
+        return NULL;
+    }
+    PyObject *r = NULL;
+    if(na == 0 || nb == 0) {
+        r = PyLong_FromLong(0);
+    } else {
+        uint64_t *cp = malloc((na+nb-1)*sizeof(uint64_t));
+        pk_reducer *R = malloc(sizeof(pk_reducer));
+        if(cp && R) {
+            pk_reducer_init(R, f, k);
+            pk_mul(R, cp, ca, na, cb, nb);
+            r = pk_pack_pylong(cp, na+nb-1, k);
+        } else {
+            PyErr_NoMemory();
+        }
+        free(cp);
+        free(R);
+    }
+    free(ca);
+    free(cb);
+    return r;
+}
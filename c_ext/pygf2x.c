@@ -15,6 +15,7 @@
 #include <string.h>
 #include <stdio.h>
 #include <stdbool.h>
+#include <stddef.h>
 
 // Max value size
 static Py_ssize_t PYGF2X_MAX_DIGITS = (9000000/PyLong_SHIFT);
@@ -78,7 +79,24 @@ static void my_abort() {
 #define GF2X_MAX(a,b) (((a)>(b)) ? (a) : (b))
 #define GF2X_MIN(a,b) (((a)<(b)) ? (a) : (b))
 
-#define LIMIT_DIV_BITWISE 0
+#define LIMIT_DIV_BITWISE 0  // Default of div_bitwise_limit
+
+#include "stats.h"
+#include "workspace.h"
+
+static inline PyLongObject *
+pylong_new(Py_ssize_t ndigs)
+// Same as _PyLong_New, except that zero is returned as the shared small integer,
+// because CPython may read ob_digit[0] of a zero integer, which _PyLong_New leaves undefined
+{
+    if(pygf2x_stats.enabled) {
+        pygf2x_stats.pylong_calls++;
+        pygf2x_stats.pylong_bytes += offsetof(PyLongObject, ob_digit) + ndigs*sizeof(digit);
+    }
+    if(ndigs == 0)
+        return (PyLongObject *)PyLong_FromLong(0);
+    return _PyLong_New(ndigs);
+}
 
 static const uint16_t sqr_8[256];
 static const uint16_t mul_5_5[32][32];
@@ -93,6 +111,8 @@ static const uint16_t mul_5_5[32][32];
 #error
 #endif
 
+#include "square_simd.h"
+
 #if defined(__GNUC__) && defined(__PCLMUL__)
 #include "intel_clmul.h"
 #elif defined(__GNUC__) && (defined(__ARM_NEON) || defined(__ARM_NEON__)) && defined(__ARM_FEATURE_CRYPTO)
@@ -103,6 +123,23 @@ static const uint16_t mul_5_5[32][32];
 #include "generic.h"
 #endif
 
+//
+// Thresholds between algorithms, set by set_thresholds or tune at runtime.
+// The defaults are the compile-time constants of the backend.
+//
+static int karatsuba_limit = KARATSUBA_LIMIT;        // Digits below which schoolbook multiplication is used
+static int div_bitwise_limit = LIMIT_DIV_BITWISE;    // Denominator bits below which bitwise division is used
+static int div_inverse_limit = 0;                    // Max digits of the inverse per division step, 0 if unlimited
+static int bm_recursive_limit = 1024;                // Sequence bits below which Berlekamp-Massey is not recursive
+static int sparse_mul_limit = 16;                    // Max non-zero bits of a factor multiplied by shifts, 0 to disable
+static int toom_limit = TOOM_LIMIT;                  // Digits of the shorter factor from which Toom-(4,2) is used, 0 to disable
+
+// Results wanted from a division
+#define DIVMOD_Q 1
+#define DIVMOD_R 2
+
+#include "fixed_width.h"
+
 // Squares up to 255 (8-bit chunk size)
 static const uint16_t sqr_8[256] = {
     0x0000,0x0001,0x0004,0x0005,0x0010,0x0011,0x0014,0x0015,0x0040,0x0041,0x0044,0x0045,0x0050,0x0051,0x0054,0x0055,
@@ -274,33 +311,19 @@ static void mul_30_nr(digit * restrict const p,
 #endif
 
 static PyObject *
-pygf2x_sqr(PyObject *self, PyObject *args)
+sqr_pylong(PyLongObject *f)
 //
-// Square one Python integer, interpreted as polynomial over GF(2)
+// Square one non-negative Python integer, interpreted as polynomial over GF(2)
 //
 {
-    (void)self;
-
-    PyLongObject *f;
-    if (!PyArg_ParseTuple(args, "O", &f)) {
-        PyErr_SetString(PyExc_TypeError, "Failed to parse arguments");
-        return NULL;
-    }
-
-    if( ! PyLong_Check(f) ) {
-        PyErr_SetString(PyExc_TypeError, "Arguments must be integer");
-        return NULL;
-    }
-    if(((PyVarObject *)f)->ob_size < 0) {
-        PyErr_SetString(PyExc_ValueError, "Argument must be non-negative");
-        return NULL;
-    }
     if(((PyVarObject *)f)->ob_size > PYGF2X_MAX_DIGITS) {
         PyErr_SetString(PyExc_ValueError, "Factor out of range");
         return NULL;
     }
 
-    int nbits_f = nbits(f);
+    // Squaring is linear and square_n writes straight into the result, so small operands
+    // only need the bit length to be found without calling _PyLong_NumBits
+    int nbits_f = fw_digits_nbits(f->ob_digit, ((PyVarObject *)f)->ob_size);
     int nbits_p = 2*nbits_f -1;
     int ndigs_p = (nbits_p + (PyLong_SHIFT-1))/PyLong_SHIFT;
     int ndigs_f = ((PyVarObject *)f)->ob_size;
@@ -310,7 +333,7 @@ pygf2x_sqr(PyObject *self, PyObject *args)
         return NULL;
     }
     
-    PyLongObject *p = _PyLong_New(2*ndigs_f); // This may be 1 digit more than needed (ndigs_p);
+    PyLongObject *p = pylong_new(2*ndigs_f); // This may be 1 digit more than needed (ndigs_p);
     ((PyVarObject *)p)->ob_size = ndigs_p;
     
     DBG_PRINTF("Bits per digit   = %-4d\n",PyLong_SHIFT);
@@ -324,39 +347,139 @@ pygf2x_sqr(PyObject *self, PyObject *args)
     return (PyObject *)p;
 }
 
-#include "mul_nl_nr.h"
-
 static PyObject *
-pygf2x_mul(PyObject *self, PyObject *args)
+pygf2x_sqr(PyObject *self, PyObject *args)
 //
-// Multiply two Python integers, interpreted as polynomials over GF(2)
+// Square one Python integer, interpreted as polynomial over GF(2)
 //
 {
     (void)self;
 
-    PyLongObject *fl, *fr;
-    if (!PyArg_ParseTuple(args, "OO", &fl, &fr)) {
+    PyLongObject *f;
+    if (!PyArg_ParseTuple(args, "O", &f)) {
         PyErr_SetString(PyExc_TypeError, "Failed to parse arguments");
         return NULL;
     }
 
-    if( ! PyLong_Check(fl) ||
-        ! PyLong_Check(fr) ) {
-        PyErr_SetString(PyExc_TypeError, "Both arguments must be integers");
+    if( ! PyLong_Check(f) ) {
+        PyErr_SetString(PyExc_TypeError, "Arguments must be integer");
         return NULL;
     }
-    if(((PyVarObject *)fl)->ob_size < 0 ||
-       ((PyVarObject *)fr)->ob_size < 0) {
-        PyErr_SetString(PyExc_ValueError, "Both arguments must be non-negative");
+    if(((PyVarObject *)f)->ob_size < 0) {
+        PyErr_SetString(PyExc_ValueError, "Argument must be non-negative");
         return NULL;
     }
 
+    return sqr_pylong(f);
+}
+
+static void
+sqr_to_bytes(uint8_t * restrict out, size_t nbytes, const digit *f, int ndigs_f)
+//
+// Write the lowest nbytes bytes of f^2 to out, least significant byte first.
+// f is repacked into 64-bit words on the fly, and each word is squared into 16 bytes.
+//
+{
+    uint64_t acc = 0;
+    int nacc = 0;
+    size_t ib = 0;
+    for(int i=0; i<=ndigs_f && ib<nbytes; i++) {
+        uint64_t w;
+        if(i < ndigs_f) {
+            acc |= (uint64_t)f[i] << nacc;
+            nacc += PyLong_SHIFT;
+            if(nacc < 64)
+                continue;
+            w = acc;
+            nacc -= 64;
+            acc = nacc ? (uint64_t)f[i] >> (PyLong_SHIFT - nacc) : 0;
+        } else {
+            w = acc;
+        }
+        uint64_t sq[2];
+        sq[0] = sqr_64(w, &sq[1]);
+#if PY_LITTLE_ENDIAN
+        if(nbytes - ib >= sizeof(sq)) {
+            memcpy(out + ib, sq, sizeof(sq));
+            ib += sizeof(sq);
+            continue;
+        }
+#endif
+        for(int k=0; k<16 && ib<nbytes; k++)
+            out[ib++] = (uint8_t)(sq[k/8] >> 8*(k%8));
+    }
+}
+
+static PyObject *
+pygf2x_sqr_into(PyObject *self, PyObject *args)
+//
+// Square one Python integer, interpreted as polynomial over GF(2), into a writable
+// buffer as little-endian bytes, without creating a new integer.
+// Return the number of bytes written. The rest of the buffer is left untouched.
+//
+{
+    (void)self;
+
+    PyLongObject *f;
+    Py_buffer view;
+    if (!PyArg_ParseTuple(args, "Ow*", &f, &view))
+        return NULL;
+
+    PyObject *result = NULL;
+    if( ! PyLong_Check(f) ) {
+        PyErr_SetString(PyExc_TypeError, "First argument must be integer");
+    } else if(((PyVarObject *)f)->ob_size < 0) {
+        PyErr_SetString(PyExc_ValueError, "First argument must be non-negative");
+    } else if(((PyVarObject *)f)->ob_size > PYGF2X_MAX_DIGITS) {
+        PyErr_SetString(PyExc_ValueError, "Factor out of range");
+    } else {
+        const int ndigs_f = ((PyVarObject *)f)->ob_size;
+        const int nbits_f = fw_digits_nbits(f->ob_digit, ndigs_f);
+        const size_t nbytes = nbits_f ? (2*(size_t)nbits_f - 1 + 7)/8 : 0;
+        if((size_t)view.len < nbytes) {
+            PyErr_Format(PyExc_ValueError, "Buffer too small, %zu bytes needed", nbytes);
+        } else {
+            STATS_BEGIN();
+            sqr_to_bytes(view.buf, nbytes, f->ob_digit, ndigs_f);
+            STATS_END(STATS_SQR);
+            result = PyLong_FromSize_t(nbytes);
+        }
+    }
+    PyBuffer_Release(&view);
+    return result;
+}
+
+#include "mul_nl_nr.h"
+#include "mullo.h"
+#include "sparse.h"
+
+static PyObject *
+mul_pylong(PyLongObject *fl, PyLongObject *fr)
+//
+// Multiply two non-negative Python integers, interpreted as polynomials over GF(2)
+//
+{
+    if(fl == fr ||
+       (((PyVarObject *)fl)->ob_size == ((PyVarObject *)fr)->ob_size &&
+        memcmp(fl->ob_digit, fr->ob_digit, ((PyVarObject *)fl)->ob_size*sizeof(digit)) == 0)) {
+        // Equal factors, use the linear-time squaring
+        return sqr_pylong(fl);
+    }
+
     if(((PyVarObject *)fl)->ob_size == 0 ||
        ((PyVarObject *)fr)->ob_size == 0) {
-        PyLongObject *p = _PyLong_New(0);
+        PyLongObject *p = pylong_new(0);
         return (PyObject *)p;
     }
 
+    if(((PyVarObject *)fl)->ob_size <= FW_MAX_DIGITS &&
+       ((PyVarObject *)fr)->ob_size <= FW_MAX_DIGITS &&
+       2*FW_MAX_DIGITS <= PYGF2X_MAX_DIGITS) {
+        // Small operands, use fixed-width kernels
+        return (PyObject *)fw_mul_pylong(fl->ob_digit, ((PyVarObject *)fl)->ob_size,
+                                         fr->ob_digit, ((PyVarObject *)fr)->ob_size);
+    }
+
     if(((PyVarObject *)fl)->ob_size > PYGF2X_MAX_DIGITS
        ||((PyVarObject *)fr)->ob_size > PYGF2X_MAX_DIGITS
        ) {
@@ -376,9 +499,11 @@ pygf2x_mul(PyObject *self, PyObject *args)
         return NULL;
     }
 
-    const bool use_heap = (ndigs_l + ndigs_r > STATIC_LIMIT);
-    digit result_static[STATIC_LIMIT];
-    digit * restrict const result = use_heap ? malloc((ndigs_l + ndigs_r)*sizeof(digit)) : result_static;
+    // Multiply straight into the result, which may have one digit more than needed
+    PyLongObject *p = pylong_new(ndigs_l + ndigs_r);
+    if(p == NULL)
+        return NULL;
+    digit * restrict const result = p->ob_digit;
     memset(result,0,(ndigs_l + ndigs_r)*sizeof(digit));
     
     DBG_PRINTF("Bits per digit   = %-4d\n",PyLong_SHIFT);
@@ -386,19 +511,231 @@ pygf2x_mul(PyObject *self, PyObject *args)
     DBG_PRINTF("Right factor bits= %-4d\n",nbits_r);
     DBG_PRINTF("Product digits   = %-4d\n",ndigs_p);
 
-    mul_nl_nr(result, fl->ob_digit, ndigs_l, fr->ob_digit, ndigs_r);
+    mul_sparse_or_dense(result, fl->ob_digit, ndigs_l, fr->ob_digit, ndigs_r);
 
     DBG_PRINTF_DIGITS("Product          :",result,ndigs_p);
 
-    PyLongObject *p = _PyLong_New(ndigs_p);
-    memcpy(p->ob_digit, result, sizeof(digit)*ndigs_p);
-    if(use_heap)
-        free(result);
+    ((PyVarObject *)p)->ob_size = ndigs_p;
 
     return (PyObject *)p;
 }
 
+static PyObject *
+pygf2x_mul(PyObject *self, PyObject *args)
+//
+// Multiply two Python integers, interpreted as polynomials over GF(2)
+//
+{
+    (void)self;
+
+    PyLongObject *fl, *fr;
+    if (!PyArg_ParseTuple(args, "OO", &fl, &fr)) {
+        PyErr_SetString(PyExc_TypeError, "Failed to parse arguments");
+        return NULL;
+    }
+
+    if( ! PyLong_Check(fl) ||
+        ! PyLong_Check(fr) ) {
+        PyErr_SetString(PyExc_TypeError, "Both arguments must be integers");
+        return NULL;
+    }
+    if(((PyVarObject *)fl)->ob_size < 0 ||
+       ((PyVarObject *)fr)->ob_size < 0) {
+        PyErr_SetString(PyExc_ValueError, "Both arguments must be non-negative");
+        return NULL;
+    }
+
+    return mul_pylong(fl, fr);
+}
+
+#include "bitslice.h"
+
+static PyObject *
+pygf2x_mul_batch(PyObject *self, PyObject *args)
+//
+// Multiply two equally long sequences of Python integers pairwise, interpreted as
+// polynomials over GF(2), and return the list of products
+//
+{
+    (void)self;
+
+    PyObject *ol, *or;
+    if (!PyArg_ParseTuple(args, "OO", &ol, &or)) {
+        PyErr_SetString(PyExc_TypeError, "Failed to parse arguments");
+        return NULL;
+    }
+
+    PyObject *sl = PySequence_Fast(ol, "Arguments must be sequences of integers");
+    if(!sl)
+        return NULL;
+    PyObject *sr = PySequence_Fast(or, "Arguments must be sequences of integers");
+    if(!sr) {
+        Py_DECREF(sl);
+        return NULL;
+    }
+    PyObject *result = NULL;
+
+    const Py_ssize_t n = PySequence_Fast_GET_SIZE(sl);
+    if(PySequence_Fast_GET_SIZE(sr) != n) {
+        PyErr_SetString(PyExc_ValueError, "Sequences must have the same length");
+        goto done;
+    }
+    PyLongObject **fl = (PyLongObject **)PySequence_Fast_ITEMS(sl);
+    PyLongObject **fr = (PyLongObject **)PySequence_Fast_ITEMS(sr);
+    for(Py_ssize_t i=0; i<n; i++) {
+        if( ! PyLong_Check(fl[i]) ||
+            ! PyLong_Check(fr[i]) ) {
+            PyErr_SetString(PyExc_TypeError, "Sequences must contain integers");
+            goto done;
+        }
+        if(((PyVarObject *)fl[i])->ob_size < 0 ||
+           ((PyVarObject *)fr[i])->ob_size < 0) {
+            PyErr_SetString(PyExc_ValueError, "Integers must be non-negative");
+            goto done;
+        }
+    }
+
+    result = PyList_New(n);
+    if(!result)
+        goto done;
+    PyObject **p = ((PyListObject *)result)->ob_item;
+    for(Py_ssize_t i=0; i<n; ) {
+        Py_ssize_t l = 0;
+#ifdef PYGF2X_BATCH_BITSLICE
+        // Find the run of up to BS_LANES pairs that are small enough to be bit-sliced
+        while(l < BS_LANES && i+l < n &&
+              ((PyVarObject *)fl[i+l])->ob_size <= BS_MAX_DIGITS &&
+              ((PyVarObject *)fr[i+l])->ob_size <= BS_MAX_DIGITS &&
+              2*BS_MAX_DIGITS <= PYGF2X_MAX_DIGITS)
+            l++;
+        if(l >= BS_MIN_LANES) {
+            if(bs_mul_lanes(&p[i], &fl[i], &fr[i], (int)l) < 0) {
+                Py_CLEAR(result);
+                goto done;
+            }
+            i += l;
+            continue;
+        }
+#endif
+        // Multiply the short run and the pair after it one by one
+        for(Py_ssize_t end=GF2X_MIN(i+l+1, n); i<end; i++) {
+            p[i] = mul_pylong(fl[i], fr[i]);
+            if(!p[i]) {
+                Py_CLEAR(result);
+                goto done;
+            }
+        }
+    }
+
+ done:
+    Py_DECREF(sl);
+    Py_DECREF(sr);
+    return result;
+}
+
+static int
+prod_digits(digit * restrict p, PyLongObject **f, int lo, int hi, const int64_t *ndigs)
+//
+// p = the product of the factors lo..hi-1, where ndigs[j] is the sum of the digits of
+// the first j factors and p has room for ndigs[hi]-ndigs[lo] digits.
+// Return the number of digits of the product, without leading zeros.
+//
+// The factors are split where the halves are closest in length, so that each
+// multiplication is between operands of about the same size.
+//
+{
+    const int64_t half = (ndigs[lo] + ndigs[hi])/2;
+    int mid = lo + 1;
+    while(mid < hi - 1 && ndigs[mid] < half)
+        mid++;
+    if(mid > lo + 1 && half - ndigs[mid-1] < ndigs[mid] - half)
+        mid--;
+
+    // Single factors are used as they are, longer ranges are multiplied into scratch
+    const int range[2][2] = {{lo, mid}, {mid, hi}};
+    const digit *x[2];
+    int nx[2];
+    const int nbuf = (int)(ndigs[hi] - ndigs[lo]);
+    digit * restrict const buf = ws_push(nbuf);
+    digit *t = buf;
+    for(int k=0; k<2; k++) {
+        const int l = range[k][0], h = range[k][1];
+        if(h - l == 1) {
+            x[k] = f[l]->ob_digit;
+            nx[k] = ((PyVarObject *)f[l])->ob_size;
+        } else {
+            x[k] = t;
+            nx[k] = prod_digits(t, f, l, h, ndigs);
+            t += ndigs[h] - ndigs[l];
+        }
+    }
+    const int np = nx[0] + nx[1];
+    memset(p, 0, np*sizeof(digit));
+    mul_nl_nr(p, x[0], nx[0], x[1], nx[1]);
+    ws_pop(buf, nbuf);
+    return np - (p[np-1] == 0);
+}
+
+static PyObject *
+pygf2x_prod(PyObject *self, PyObject *args)
+//
+// prod(iterable): the product of all integers, interpreted as polynomials over GF(2),
+// multiplied in a tree of balanced products
+//
+{
+    (void)self;
+    PyObject *factors;
+    if(!PyArg_ParseTuple(args, "O", &factors))
+        return NULL;
+    PyObject *seq = PySequence_Fast(factors, "Argument must be an iterable of integers");
+    if(seq == NULL)
+        return NULL;
+    const Py_ssize_t n = PySequence_Fast_GET_SIZE(seq);
+    PyLongObject **f = (PyLongObject **)PySequence_Fast_ITEMS(seq);
+    int64_t *ndigs = malloc((n+1)*sizeof(int64_t));
+    if(ndigs == NULL) {
+        Py_DECREF(seq);
+        return PyErr_NoMemory();
+    }
+    PyObject *result = NULL;
+    bool zero = false;
+    int64_t nbits_p = 1;
+    ndigs[0] = 0;
+    for(Py_ssize_t j=0; j<n; j++) {
+        if(! PyLong_Check(f[j])) {
+            PyErr_SetString(PyExc_TypeError, "Factors must be integers");
+            goto done;
+        }
+        if(((PyVarObject *)f[j])->ob_size < 0) {
+            PyErr_SetString(PyExc_ValueError, "Factors must be non-negative");
+            goto done;
+        }
+        const int nd = ((PyVarObject *)f[j])->ob_size;
+        zero |= nd == 0;
+        nbits_p += nd ? nbits(f[j]) - 1 : 0;
+        ndigs[j+1] = ndigs[j] + nd;
+    }
+    if(zero) {
+        result = PyLong_FromLong(0);
+    } else if(n <= 1) {
+        result = n ? (Py_INCREF(f[0]), (PyObject *)f[0]) : PyLong_FromLong(1);
+    } else if(nbits_p > (int64_t)PYGF2X_MAX_DIGITS*PyLong_SHIFT) {
+        PyErr_SetString(PyExc_OverflowError, "Result of multiplication is out of range");
+    } else {
+        PyLongObject *p = pylong_new(ndigs[n]);
+        if(p)
+            result = pylong_trim(p, prod_digits(p->ob_digit, f, 0, (int)n, ndigs));
+    }
+
+ done:
+    free(ndigs);
+    Py_DECREF(seq);
+    return result;
+}
+
+#include "multiplier.h"
 #include "div_bitwise.h"
+#include "div_word.h"
 #include "inverse.h"
 
 static PyObject *
@@ -462,6 +799,56 @@ pygf2x_inv(PyObject *self, PyObject *args)
     return (PyObject *)e;
 }
 
+static PyObject *
+pygf2x_rinv(PyObject *self, PyObject *args)
+//
+// Inverse modulo x^nbits of one odd Python integer, interpreted as polynomial over GF(2)
+//
+{
+    (void)self;
+
+    int nbits_e;
+    PyLongObject *d;
+    if (!PyArg_ParseTuple(args, "O!i", &PyLong_Type, &d, &nbits_e))
+        return NULL;
+    if(((PyVarObject *)d)->ob_size == 0) {
+        PyErr_SetString(PyExc_ZeroDivisionError, "Inverse of zero is undefined");
+        return NULL;
+    }
+    if(((PyVarObject *)d)->ob_size < 0) {
+        PyErr_SetString(PyExc_ValueError, "Argument must be positive");
+        return NULL;
+    }
+    if((d->ob_digit[0] & 1) == 0) {
+        PyErr_SetString(PyExc_ValueError, "Argument must be odd");
+        return NULL;
+    }
+    if(((PyVarObject *)d)->ob_size > PYGF2X_MAX_DIGITS) {
+        PyErr_SetString(PyExc_ValueError, "Inverse operand is out of range");
+        return NULL;
+    }
+    if(nbits_e <= 0) {
+        PyErr_SetString(PyExc_ValueError, "Inverse bit_length must be positive");
+        return NULL;
+    }
+    if(nbits_e > (PYGF2X_MAX_DIGITS*PyLong_SHIFT)) {
+        PyErr_SetString(PyExc_OverflowError, "Requested bit_length of inverse is out of range");
+        return NULL;
+    }
+
+    const int ndigs_d = ((PyVarObject *)d)->ob_size;
+    const int ndigs_e = (nbits_e + (PyLong_SHIFT-1))/PyLong_SHIFT;
+    PyLongObject *e = pylong_new(ndigs_e);
+    if(e == NULL)
+        return NULL;
+    rinverse(e->ob_digit, ndigs_e, nbits_e, d->ob_digit, ndigs_d);
+    int nd = ndigs_e;
+    while(e->ob_digit[nd-1] == 0)
+        nd--;
+    ((PyVarObject *)e)->ob_size = nd;
+    return (PyObject *)e;
+}
+
 static void rshift(digit digits[], int ndigs, int nb_shift)
 // Shift in-place nb_shift bits to the right
 // nb_shift must be >=0
@@ -485,83 +872,47 @@ static void rshift(digit digits[], int ndigs, int nb_shift)
         digits[i] = 0;
 }
 
-static PyObject *
-pygf2x_divmod(PyObject *self, PyObject *args)
+static void
+divmod_digits(digit * restrict q_digits, digit * restrict r_digits, const digit * restrict d_digits,
+              int nbits_u, int nbits_d, int want)
 //
-// Divide two Python integers, interpreted as polynomials over GF(2)
-// Return quotient and remainder
+// Euclidean division of u with nbits_u bits by d with nbits_d>=1 bits.
+// On entry r_digits holds u, zero-extended to max(nbits_u, nbits_d-1) bits, and q_digits
+// is zeroed with room for nbits_u-nbits_d+1 bits. On return they hold quotient and remainder.
+// Without DIVMOD_Q in want, q_digits may be NULL and no quotient digits are stored.
+// Without DIVMOD_R in want, r_digits is only scratch and holds no remainder on return.
 //
 {
-    (void)self;
-
-    PyLongObject *numerator, *denominator;
-    if (!PyArg_ParseTuple(args, "OO", &numerator, &denominator)) {
-        PyErr_SetString(PyExc_TypeError, "Failed to parse arguments");
-        return NULL;
-    }
-    
-    if( ! PyLong_Check(numerator) ||
-        ! PyLong_Check(denominator) ) {
-        PyErr_SetString(PyExc_TypeError, "Both arguments must be integers");
-        return NULL;
-    }
-    if(((PyVarObject *)numerator)->ob_size < 0 ||
-       ((PyVarObject *)denominator)->ob_size < 0) {
-        PyErr_SetString(PyExc_ValueError, "Both arguments must be non-negative");
-        return NULL;
-    }
-    if(((PyVarObject *)numerator)->ob_size > PYGF2X_MAX_DIGITS ||
-       ((PyVarObject *)denominator)->ob_size > PYGF2X_MAX_DIGITS) {
-        PyErr_SetString(PyExc_ValueError, "Numerator or denominator out of range");
-        return NULL;
-    }
-
-    int nbits_d = nbits(denominator);
     int ndigs_d = (nbits_d + (PyLong_SHIFT-1))/PyLong_SHIFT;
-    if(nbits_d == 0) {
-        PyErr_SetString(PyExc_ZeroDivisionError, "Denominator is zero");
-        return NULL;
-    }
-    int nbits_u = nbits(numerator);
     int ndigs_u = (nbits_u + (PyLong_SHIFT-1))/PyLong_SHIFT;
-    
     int nbits_q = nbits_u > nbits_d-1 ? nbits_u - (nbits_d-1) : 0;
-    int nbits_r = nbits_u > nbits_d-1 ? nbits_u : nbits_d-1; // Enough room to store u initially, and r finally
+    int nbits_r = nbits_u > nbits_d-1 ? nbits_u : nbits_d-1;
     int ndigs_q = (nbits_q + (PyLong_SHIFT-1))/PyLong_SHIFT;
     int ndigs_r = (nbits_r + (PyLong_SHIFT-1))/PyLong_SHIFT;
 
-    PyLongObject *q = _PyLong_New(ndigs_q);
-    digit *restrict q_digits = q->ob_digit;
-    memset(q_digits,0,ndigs_q*sizeof(digit));
-    
-    digit * restrict const r_digits = malloc(ndigs_r*sizeof(digit)); // Initialize to numerator
-    memset(r_digits+ndigs_u,0,(ndigs_r-ndigs_u)*sizeof(digit));
-    memcpy(r_digits, numerator->ob_digit, ndigs_u*sizeof(digit));
-    
-    DBG_PRINTF("Bits per digit   = %-4d\n",PyLong_SHIFT);
-    DBG_PRINTF("Numerator bits   = %-4d\n",nbits_u);
-    DBG_PRINTF("Denominator bits = %-4d\n",nbits_d);
-    DBG_PRINTF("Quotient bits    = %-4d\n",nbits_q);
-    DBG_PRINTF("Remainder bits  <= %-4d\n",nbits_d-1);
-
-    DBG_PRINTF_DIGITS("Numerator        :",numerator->ob_digit,ndigs_u);
-    DBG_PRINTF_DIGITS("Denominator      :",denominator->ob_digit,ndigs_d);
+    STATS_BEGIN();
+    stats_size(STATS_DIVMOD_DIGITS, nbits_u);
 
     if(nbits_u==nbits_d) {
         // The special case of quotient==1
-        q_digits[0] = 1;
+        if(q_digits)
+            q_digits[0] = 1;
         for(int i=0; i<ndigs_d; i++)
-            r_digits[i] ^= denominator->ob_digit[i];
+            r_digits[i] ^= d_digits[i];
     } else if(nbits_d==1) {
         // The special case of denominator==1
-        for(int i=0; i<ndigs_u; i++)
-            q_digits[i] = r_digits[i];
+        if(q_digits)
+            for(int i=0; i<ndigs_u; i++)
+                q_digits[i] = r_digits[i];
         for(int i=0; i<ndigs_r; i++)
             r_digits[i] = 0;
     } else if(nbits_u>=nbits_d) {
-        if(nbits_d < LIMIT_DIV_BITWISE) {
+        if(nbits_d < div_bitwise_limit) {
             // Use bitwise Euclidean division for small denominators because it is possibly more efficient
-            div_bitwise(q_digits, r_digits, denominator->ob_digit, nbits_u, nbits_d);
+            div_bitwise(q_digits, r_digits, d_digits, nbits_u, nbits_d);
+        } else if(nbits_d <= DIV_WORD_MAX_BITS) {
+            // Small denominators, the remainder fits in one word
+            div_word(q_digits, r_digits, d_digits, nbits_u, nbits_d);
         } else {
             /*
              *   u = q*d + r
@@ -604,20 +955,26 @@ pygf2x_divmod(PyObject *self, PyObject *args)
             // If nbits_d >= nbits_q just compute q with one single step in the Euclidean division loop below
             // Otherwise take multiple steps, each of size nbits_d or less
             int nbits_e = GF2X_MIN(nbits_q, nbits_d);
+            if(div_inverse_limit > 0)
+                nbits_e = GF2X_MIN(nbits_e, div_inverse_limit*PyLong_SHIFT);
             // Round up to nearest digit size
             int ndigs_e = (nbits_e + (PyLong_SHIFT-1))/PyLong_SHIFT;
             nbits_e = PyLong_SHIFT*ndigs_e;
 
+            // Scratch for the inverse e, r*e and dq*d
+            const int nscratch = ndigs_e + (ndigs_e + ndigs_d) + 2*ndigs_e;
+            digit * restrict const scratch = ws_push(nscratch);
+
             // Compute the inverse e = (d)^-1
-            digit * restrict const e = malloc(ndigs_e*sizeof(digit));
+            digit * restrict const e = scratch;
             memset(e, 0, ndigs_e*sizeof(digit));
             inverse(e, ndigs_e, nbits_e,
-                    denominator->ob_digit, ndigs_d, nbits_d);
+                    d_digits, ndigs_d, nbits_d);
             DBG_PRINTF_DIGITS("inverse          :",e,ndigs_e);
 
             DBG_PRINTF("ndigs_e=%d, ndigs_u=%d, ndigs_q=%d\n", ndigs_e, ndigs_u, ndigs_q);
 
-            digit * restrict const dr = malloc((ndigs_e + ndigs_d)*sizeof(digit));
+            digit * restrict const dr = e + ndigs_e;
             
             // Start with computing the most significant, incomplete digit of q, if it exists.
             if(nbits_q%PyLong_SHIFT != 0)
@@ -635,20 +992,24 @@ pygf2x_divmod(PyObject *self, PyObject *args)
                     DBG_PRINTF("ei=%x, ri=%x, dq=%x\n",ei,ri,dq);
                     DBG_ASSERT(dq >= (1u<<(nbits_ei-1)) && dq<(1u<<nbits_ei));
                     // |dq| = nbits_ei
-                    q_digits[ndigs_q-1] = dq;
+                    if(q_digits)
+                        q_digits[ndigs_q-1] = dq;
 
                     int nbits_qi = nbits_r - nbits_d - (nbits_ei -1);
                     DBG_ASSERT(nbits_qi%PyLong_SHIFT == 0);
                     int ndigs_qi = nbits_qi/PyLong_SHIFT;
 
-                    // dr = (dq*d) << nqi
-                    memset(dr, 0, (ndigs_d+1)*sizeof(digit));
-                    mul_nl_nr(dr, &dq, 1, denominator->ob_digit, ndigs_d);
-                    DBG_PRINTF_DIGITS("dr  :",dr,ndigs_d+1);
-                    DBG_PRINTF("dq=%x\n",dq);
-                    DBG_ASSERT(ndigs_r -1 - ndigs_qi < ndigs_d +1);
-                    for(int i=ndigs_qi; i<ndigs_r; i++) {
-                        r_digits[i] ^= dr[i - ndigs_qi];
+                    // dr = (dq*d) << nqi, unless this was the whole quotient and the
+                    // remainder is not wanted
+                    if((want & DIVMOD_R) || ndigs_qi > 0) {
+                        memset(dr, 0, (ndigs_d+1)*sizeof(digit));
+                        mul_nl_nr(dr, &dq, 1, d_digits, ndigs_d);
+                        DBG_PRINTF_DIGITS("dr  :",dr,ndigs_d+1);
+                        DBG_PRINTF("dq=%x\n",dq);
+                        DBG_ASSERT(ndigs_r -1 - ndigs_qi < ndigs_d +1);
+                        for(int i=ndigs_qi; i<ndigs_r; i++) {
+                            r_digits[i] ^= dr[i - ndigs_qi];
+                        }
                     }
                     DBG_PRINTF_DIGITS("r_0              :",r_digits,ndigs_r);           
                 
@@ -657,7 +1018,7 @@ pygf2x_divmod(PyObject *self, PyObject *args)
             // Loop over whole digits
             DBG_ASSERT(nbits_e%PyLong_SHIFT == 0);
             DBG_ASSERT((nbits_r - nbits_d +1)%PyLong_SHIFT == 0);
-            digit * restrict const dq = malloc((ndigs_e<<1)*sizeof(digit));
+            digit * restrict const dq = dr + ndigs_e + ndigs_d;
             for(; nbits_r >= nbits_d; nbits_r -= nbits_e) {
                 int ndigs_ei = GF2X_MIN(ndigs_e, (nbits_r - nbits_d +1)/PyLong_SHIFT);
                 int nbits_ei = ndigs_ei*PyLong_SHIFT;
@@ -673,7 +1034,8 @@ pygf2x_divmod(PyObject *self, PyObject *args)
                         dr[i] = (r_digits[ndigs_ri - ndigs_ei +i] << (PyLong_SHIFT - nbits_ri) & PyLong_MASK) |
                             r_digits[ndigs_ri - ndigs_ei +i -1] >> nbits_ri;
                     DBG_PRINTF_DIGITS("r>>(nr-ne)       :",dr,ndigs_ei);
-                    mul_nl_nr(dq, &e[ndigs_e - ndigs_ei], ndigs_ei, dr, ndigs_ei);
+                    // Only the digits from bit nbits_ei-1 and up are needed
+                    mulhi(&dq[ndigs_ei-1], &e[ndigs_e - ndigs_ei], ndigs_ei, dr, ndigs_ei, ndigs_ei+1);
                 }
                 rshift(dq, 2*ndigs_ei, nbits_ei-1);
                 // |dq| is now = nbits_ei (the uppermost ndigs_ei digits is 0)
@@ -683,40 +1045,193 @@ pygf2x_divmod(PyObject *self, PyObject *args)
                 DBG_ASSERT(ndigs_qi%PyLong_SHIFT == 0);
                 ndigs_qi /= PyLong_SHIFT;
                 DBG_PRINTF("nbits_r=%d, nbits_d=%d, nbits_e=%d, ndigs_qi=%d\n",nbits_r,nbits_d, nbits_e, ndigs_qi);
+                if(q_digits)
+                    for(int i=0; i<ndigs_ei; i++)
+                        if(dq[i])
+                            q_digits[ndigs_qi+i] ^= dq[i];
+                if(!(want & DIVMOD_R) && ndigs_qi == 0)
+                    break;  // The last digits of the quotient, skip the update of the remainder
                 
-                // dr = (dq*d) << nqi
-                memset(dr, 0, (ndigs_ei + ndigs_d)*sizeof(digit));
-                mul_nl_nr(dr, dq, ndigs_ei, denominator->ob_digit, ndigs_d);
-                DBG_PRINTF_DIGITS("dr               :",dr,ndigs_ei+ndigs_d);
-
-                for(int i=ndigs_qi; i < ndigs_ri; i++)
+                // dr = (dq*d) << nqi, of which only the digits below the new remainder length
+                // are needed, since the ones above cancel r exactly
+                const int ndigs_rn = (nbits_r - nbits_ei + (PyLong_SHIFT-1))/PyLong_SHIFT;
+                memset(dr, 0, (ndigs_rn - ndigs_qi)*sizeof(digit));
+                mullo(dr, dq, ndigs_ei, d_digits, ndigs_d, ndigs_rn - ndigs_qi);
+                DBG_PRINTF_DIGITS("dr               :",dr,ndigs_rn - ndigs_qi);
+
+                for(int i=ndigs_qi; i < ndigs_rn; i++)
                     if(dr[i-ndigs_qi])
                         r_digits[i] ^= dr[i-ndigs_qi];
-                for(int i=0; i<ndigs_ei; i++)
-                    if(dq[i])
-                        q_digits[ndigs_qi+i] ^= dq[i];
+                for(int i=ndigs_rn; i < ndigs_ri; i++)
+                    r_digits[i] = 0;
                 DBG_PRINTF_DIGITS("r                :",r_digits,ndigs_r);
             }
-            free(e);
-            free(dq);
-            free(dr);
+            ws_pop(scratch, nscratch);
         }
     }
+    STATS_END(STATS_DIVMOD_DIGITS);
+}
 
-    DBG_PRINTF_DIGITS("Quotient         :",q_digits,ndigs_q);
+static PyObject *
+divmod_pylong(PyObject *args, int want)
+//
+// Divide two Python integers, interpreted as polynomials over GF(2)
+// Return quotient and remainder, or only one of them, as selected by want
+//
+{
+    PyLongObject *numerator, *denominator;
+    if (!PyArg_ParseTuple(args, "OO", &numerator, &denominator)) {
+        PyErr_SetString(PyExc_TypeError, "Failed to parse arguments");
+        return NULL;
+    }
+    
+    if( ! PyLong_Check(numerator) ||
+        ! PyLong_Check(denominator) ) {
+        PyErr_SetString(PyExc_TypeError, "Both arguments must be integers");
+        return NULL;
+    }
+    if(((PyVarObject *)numerator)->ob_size < 0 ||
+       ((PyVarObject *)denominator)->ob_size < 0) {
+        PyErr_SetString(PyExc_ValueError, "Both arguments must be non-negative");
+        return NULL;
+    }
+    if(((PyVarObject *)numerator)->ob_size > PYGF2X_MAX_DIGITS ||
+       ((PyVarObject *)denominator)->ob_size > PYGF2X_MAX_DIGITS) {
+        PyErr_SetString(PyExc_ValueError, "Numerator or denominator out of range");
+        return NULL;
+    }
+    if(((PyVarObject *)numerator)->ob_size <= FW_DIV_MAX_DIGITS &&
+       ((PyVarObject *)denominator)->ob_size <= FW_DIV_MAX_DIGITS &&
+       ((PyVarObject *)denominator)->ob_size > 0) {
+        // Small operands, use fixed-width kernel
+        return fw_divmod_pylong(numerator->ob_digit, ((PyVarObject *)numerator)->ob_size,
+                                denominator->ob_digit, ((PyVarObject *)denominator)->ob_size, want);
+    }
+
+    int nbits_d = nbits(denominator);
+    if(nbits_d == 0) {
+        PyErr_SetString(PyExc_ZeroDivisionError, "Denominator is zero");
+        return NULL;
+    }
+    int nbits_u = nbits(numerator);
+    int ndigs_u = (nbits_u + (PyLong_SHIFT-1))/PyLong_SHIFT;
+    
+    int nbits_q = nbits_u > nbits_d-1 ? nbits_u - (nbits_d-1) : 0;
+    int nbits_r = nbits_u > nbits_d-1 ? nbits_u : nbits_d-1; // Enough room to store u initially, and r finally
+    int ndigs_q = (nbits_q + (PyLong_SHIFT-1))/PyLong_SHIFT;
+    int ndigs_r = (nbits_r + (PyLong_SHIFT-1))/PyLong_SHIFT;
+
+    PyLongObject *q = NULL;
+    if(want & DIVMOD_Q) {
+        q = pylong_new(ndigs_q);
+        if(q == NULL)
+            return NULL;
+        memset(q->ob_digit,0,ndigs_q*sizeof(digit));
+    }
+
+    // The numerator is reduced to the remainder in place. When the remainder is wanted and
+    // not much shorter than the numerator, this is done in the remainder object itself,
+    // otherwise in scratch memory, and only the remainder is copied out.
+    const int ndigs_rmax = (nbits_d - 1 + (PyLong_SHIFT-1))/PyLong_SHIFT;
+    const int ndigs_u_r = ndigs_r;
+    PyLongObject *r = NULL;
+    if((want & DIVMOD_R) && ndigs_u_r <= 2*ndigs_rmax) {
+        r = pylong_new(ndigs_u_r);
+        if(r == NULL) {
+            Py_XDECREF(q);
+            return NULL;
+        }
+    }
+    digit * restrict const r_digits = r ? r->ob_digit : ws_push(ndigs_u_r); // Initialize to numerator
+    memset(r_digits+ndigs_u,0,(ndigs_r-ndigs_u)*sizeof(digit));
+    memcpy(r_digits, numerator->ob_digit, ndigs_u*sizeof(digit));
+    
+    DBG_PRINTF("Bits per digit   = %-4d\n",PyLong_SHIFT);
+    DBG_PRINTF("Numerator bits   = %-4d\n",nbits_u);
+    DBG_PRINTF("Denominator bits = %-4d\n",nbits_d);
+    DBG_PRINTF("Quotient bits    = %-4d\n",nbits_q);
+    DBG_PRINTF("Remainder bits  <= %-4d\n",nbits_d-1);
+
+    DBG_PRINTF_DIGITS("Numerator        :",numerator->ob_digit,ndigs_u);
+    DBG_PRINTF_DIGITS("Denominator      :",denominator->ob_digit,((PyVarObject *)denominator)->ob_size);
+
+    divmod_digits(q ? q->ob_digit : NULL, r_digits, denominator->ob_digit, nbits_u, nbits_d, want);
+
+    if(!(want & DIVMOD_R)) {
+        ws_pop(r_digits, ndigs_u_r);
+        DBG_PRINTF_DIGITS("Quotient         :",q->ob_digit,ndigs_q);
+        return (PyObject *)q;
+    }
 
     // Remove leading zero digits from remainder
     while(ndigs_r > 0 && r_digits[ndigs_r-1] == 0)
         ndigs_r -= 1;
     DBG_PRINTF_DIGITS("Remainder        :",r_digits,ndigs_r);
     
-    PyLongObject *r = _PyLong_New(ndigs_r);
-    memcpy(r->ob_digit, r_digits, sizeof(digit)*ndigs_r);
-    free(r_digits);
+    if(r == NULL) {
+        r = pylong_new(ndigs_r);
+        if(r != NULL)
+            memcpy(r->ob_digit, r_digits, sizeof(digit)*ndigs_r);
+        ws_pop(r_digits, ndigs_u_r);
+        if(r == NULL) {
+            Py_XDECREF(q);
+            return NULL;
+        }
+    } else if(ndigs_r == 0) {
+        Py_DECREF(r);
+        r = pylong_new(0);
+    } else {
+        ((PyVarObject *)r)->ob_size = ndigs_r;
+    }
+
+    if(!(want & DIVMOD_Q))
+        return (PyObject *)r;
+    DBG_PRINTF_DIGITS("Quotient         :",q->ob_digit,ndigs_q);
+    return Py_BuildValue("NN", q, r);
+}
+
+static PyObject *
+pygf2x_divmod(PyObject *self, PyObject *args)
+//
+// divmod(u, d): quotient and remainder of u divided by d
+//
+{
+    (void)self;
+    return divmod_pylong(args, DIVMOD_Q | DIVMOD_R);
+}
 
-    return Py_BuildValue("OO", q, r);
+static PyObject *
+pygf2x_div(PyObject *self, PyObject *args)
+//
+// div(u, d): quotient of u divided by d. The remainder is not updated by the last
+// multiplication of the quotient digits.
+//
+{
+    (void)self;
+    return divmod_pylong(args, DIVMOD_Q);
+}
+
+static PyObject *
+pygf2x_mod(PyObject *self, PyObject *args)
+//
+// mod(u, d): remainder of u divided by d. No quotient digits are stored.
+//
+{
+    (void)self;
+    return divmod_pylong(args, DIVMOD_R);
 }
 
+#include "crc.h"
+#include "modulus.h"
+#include "divexact.h"
+#include "field.h"
+#include "packed.h"
+#include "subproduct.h"
+#include "remainder_tree.h"
+#include "berlekamp_massey.h"
+#include "jump.h"
+#include "compose.h"
+
 PyObject *pygf2x_get_MAX_BITS(PyObject *self,
                               PyObject *nbits_obj)
 {
@@ -744,32 +1259,230 @@ PyObject *pygf2x_set_MAX_BITS(PyObject *self,
     return Py_None;
 }
 
+static const struct {
+    const char *name;
+    int *value;
+    int min;
+} pygf2x_thresholds[] = {
+    {"karatsuba_limit", &karatsuba_limit, 2},
+    {"div_bitwise_limit", &div_bitwise_limit, 0},
+    {"div_inverse_limit", &div_inverse_limit, 0},
+    {"bm_recursive_limit", &bm_recursive_limit, 64},
+    {"sparse_mul_limit", &sparse_mul_limit, 0},
+    {"toom_limit", &toom_limit, 0},
+};
+#define PYGF2X_NTHRESHOLDS ((int)(sizeof(pygf2x_thresholds)/sizeof(pygf2x_thresholds[0])))
+
+PyObject *pygf2x_get_thresholds(PyObject *self,
+                                PyObject *args)
+{
+    // Return the algorithm thresholds as a dict
+    PyObject *d = PyDict_New();
+    if(d == NULL)
+        return NULL;
+    for(int i=0; i<PYGF2X_NTHRESHOLDS; i++) {
+        PyObject *v = PyLong_FromLong(*pygf2x_thresholds[i].value);
+        if(v == NULL || PyDict_SetItemString(d, pygf2x_thresholds[i].name, v) < 0) {
+            Py_XDECREF(v);
+            Py_DECREF(d);
+            return NULL;
+        }
+        Py_DECREF(v);
+    }
+    return d;
+}
+
+PyObject *pygf2x_set_thresholds(PyObject *self,
+                                PyObject *thresholds)
+{
+    // Set some or all algorithm thresholds from a dict, as returned by get_thresholds
+    // All values are checked before any of them is changed
+    if(! PyDict_Check(thresholds)) {
+        PyErr_SetString(PyExc_TypeError, "Argument must be a dict");
+        return NULL;
+    }
+    int values[PYGF2X_NTHRESHOLDS];
+    for(int i=0; i<PYGF2X_NTHRESHOLDS; i++)
+        values[i] = *pygf2x_thresholds[i].value;
+
+    PyObject *key, *value;
+    Py_ssize_t pos = 0;
+    while(PyDict_Next(thresholds, &pos, &key, &value)) {
+        int i = 0;
+        for(; i<PYGF2X_NTHRESHOLDS; i++)
+            if(PyUnicode_Check(key) && PyUnicode_CompareWithASCIIString(key, pygf2x_thresholds[i].name) == 0)
+                break;
+        if(i == PYGF2X_NTHRESHOLDS) {
+            PyErr_Format(PyExc_KeyError, "Unknown threshold %R", key);
+            return NULL;
+        }
+        if(! PyLong_Check(value)) {
+            PyErr_Format(PyExc_TypeError, "Threshold %s must be an integer", pygf2x_thresholds[i].name);
+            return NULL;
+        }
+        long v = PyLong_AsLong(value);
+        if(v == -1 && PyErr_Occurred())
+            return NULL;
+        if(v < pygf2x_thresholds[i].min || v > INT_MAX) {
+            PyErr_Format(PyExc_ValueError, "Threshold %s must be at least %d", pygf2x_thresholds[i].name, pygf2x_thresholds[i].min);
+            return NULL;
+        }
+        values[i] = (int)v;
+    }
+    for(int i=0; i<PYGF2X_NTHRESHOLDS; i++)
+        *pygf2x_thresholds[i].value = values[i];
+
+    Py_INCREF(Py_None);
+    return Py_None;
+}
+
+#include "tune.h"
+
+STATS_TIMED(pygf2x_divmod, STATS_DIVMOD)
+STATS_TIMED(pygf2x_div, STATS_DIV)
+STATS_TIMED(pygf2x_mod, STATS_MOD)
+STATS_TIMED(pygf2x_divexact, STATS_DIVEXACT)
+STATS_TIMED(pygf2x_mul, STATS_MUL)
+STATS_TIMED(pygf2x_mul_batch, STATS_MUL_BATCH)
+STATS_TIMED(pygf2x_sqr, STATS_SQR)
+STATS_TIMED(pygf2x_inv, STATS_INV)
+STATS_TIMED(pygf2x_rinv, STATS_RINV)
+STATS_TIMED(pygf2x_prod, STATS_PROD)
+
 PyMethodDef pygf2x_functions[] =
     {
         {
             "divmod",
-            pygf2x_divmod,
+            pygf2x_divmod_timed,
             METH_VARARGS,
             "Divide two integers as polynomials over GF(2) (returns quotient and remainder)"
         },
+        {
+            "div",
+            pygf2x_div_timed,
+            METH_VARARGS,
+            "Divide two integers as polynomials over GF(2) (returns quotient)"
+        },
+        {
+            "mod",
+            pygf2x_mod_timed,
+            METH_VARARGS,
+            "Divide two integers as polynomials over GF(2) (returns remainder)"
+        },
+        {
+            "divexact",
+            pygf2x_divexact_timed,
+            METH_VARARGS,
+            "Divide two integers as polynomials over GF(2), where the division is known to be exact"
+        },
         {
             "mul",
-            pygf2x_mul,
+            pygf2x_mul_timed,
             METH_VARARGS,
             "Multiply two integers as polynomials over GF(2)"
         },
+        {
+            "mul_batch",
+            pygf2x_mul_batch_timed,
+            METH_VARARGS,
+            "Multiply two equally long sequences of integers pairwise as polynomials over GF(2)"
+        },
+        {
+            "prod",
+            pygf2x_prod_timed,
+            METH_VARARGS,
+            "Multiply all integers of an iterable as polynomials over GF(2), in a balanced product tree"
+        },
         {
             "sqr",
-            pygf2x_sqr,
+            pygf2x_sqr_timed,
             METH_VARARGS,
             "Square one integer as polynomial over GF(2)"
         },
+        {
+            "sqr_into",
+            pygf2x_sqr_into,
+            METH_VARARGS,
+            "Square one integer as polynomial over GF(2) into a writable buffer, as little-endian bytes"
+        },
         {
             "inv",
-            pygf2x_inv,
+            pygf2x_inv_timed,
             METH_VARARGS,
             "Multiplicative inverse of integer as polynomial over GF(2), with given precision"
         },
+        {
+            "rinv",
+            pygf2x_rinv_timed,
+            METH_VARARGS,
+            "Inverse of odd integer as polynomial over GF(2), modulo x^nbits"
+        },
+        {
+            "pack",
+            pygf2x_pack,
+            METH_VARARGS,
+            "Pack a sequence of k-bit coefficients into one integer, coefficient i in bits k*i to k*i+k-1"
+        },
+        {
+            "unpack",
+            pygf2x_unpack,
+            METH_VARARGS,
+            "Unpack the k-bit coefficients of an integer into a list, up to the highest non-zero one"
+        },
+        {
+            "mul_packed",
+            pygf2x_mul_packed,
+            METH_VARARGS,
+            "Multiply two packed polynomials over GF(2^k), given the modulus of GF(2^k) as integer or Field"
+        },
+        {
+            "berlekamp_massey",
+            pygf2x_berlekamp_massey,
+            METH_VARARGS,
+            "Shortest LFSR (L, C) generating a bit sequence, given as bytes and optional number of bits"
+        },
+        {
+            "xpow_mod",
+            pygf2x_xpow_mod,
+            METH_VARARGS,
+            "Compute x^N mod f, given f as integer or Field"
+        },
+        {
+            "apply_jump",
+            pygf2x_apply_jump,
+            METH_VARARGS,
+            "Advance a Galois LFSR state by multiplying it with a jump polynomial modulo f"
+        },
+        {
+            "compose_mod",
+            pygf2x_compose_mod,
+            METH_VARARGS,
+            "Modular composition f(g) mod h, given h as integer or Field"
+        },
+        {
+            "multi_mod",
+            pygf2x_multi_mod,
+            METH_VARARGS,
+            "Remainders of an integer modulo many, given as a sequence or RemainderTree, as polynomials over GF(2)"
+        },
+        {
+            "crt",
+            pygf2x_crt,
+            METH_VARARGS,
+            "Chinese remaindering: the integer with given remainders modulo pairwise coprime moduli, as polynomials over GF(2)"
+        },
+        {
+            "mullo",
+            pygf2x_mullo,
+            METH_VARARGS,
+            "The n least significant bits of the product of two integers as polynomials over GF(2)"
+        },
+        {
+            "mulhi",
+            pygf2x_mulhi,
+            METH_VARARGS,
+            "The product of two integers as polynomials over GF(2), shifted right by n bits"
+        },
         {
             "get_MAX_BITS",
             pygf2x_get_MAX_BITS,
@@ -782,6 +1495,42 @@ PyMethodDef pygf2x_functions[] =
             METH_O,
             "Set maximum allowed gint bit_length"
         },
+        {
+            "get_thresholds",
+            pygf2x_get_thresholds,
+            METH_NOARGS,
+            "Get the thresholds between algorithms as a dict"
+        },
+        {
+            "set_thresholds",
+            pygf2x_set_thresholds,
+            METH_O,
+            "Set thresholds between algorithms from a dict"
+        },
+        {
+            "tune",
+            pygf2x_tune,
+            METH_NOARGS,
+            "Measure and set the thresholds between algorithms for this host, and return them"
+        },
+        {
+            "stats",
+            pygf2x_stats_get,
+            METH_NOARGS,
+            "Get the operation counters as a dict"
+        },
+        {
+            "reset_stats",
+            pygf2x_reset_stats,
+            METH_NOARGS,
+            "Clear the operation counters"
+        },
+        {
+            "enable_stats",
+            pygf2x_enable_stats,
+            METH_O,
+            "Enable or disable the operation counters, and return whether they were enabled"
+        },
         {
             NULL,                   // const char  *ml_name;  /* The name of the built-in function/method   */
             NULL,                   // PyCFunction ml_meth;   /* The C function that implements it          */
@@ -812,7 +1561,59 @@ struct PyModuleDef pygf2x_module =
 PyMODINIT_FUNC PyInit_pygf2x(void)
 {
     // Python module initialization
+    if(PyType_Ready(&CRCType) < 0 ||
+       PyType_Ready(&FieldType) < 0 ||
+       PyType_Ready(&FieldElementType) < 0 ||
+       PyType_Ready(&SubproductTreeType) < 0 ||
+       PyType_Ready(&RemainderTreeType) < 0 ||
+       PyType_Ready(&MultiplierType) < 0)
+        return NULL;
+
     PyObject *pygf2x = PyModule_Create(&pygf2x_module);
+    if(pygf2x == NULL)
+        return NULL;
+
+    if(PyModule_AddStringConstant(pygf2x, "BACKEND", PYGF2X_BACKEND) < 0) {
+        Py_DECREF(pygf2x);
+        return NULL;
+    }
+
+    Py_INCREF(&CRCType);
+    if(PyModule_AddObject(pygf2x, "CRC", (PyObject *)&CRCType) < 0) {
+        Py_DECREF(&CRCType);
+        Py_DECREF(pygf2x);
+        return NULL;
+    }
+    Py_INCREF(&FieldType);
+    if(PyModule_AddObject(pygf2x, "Field", (PyObject *)&FieldType) < 0) {
+        Py_DECREF(&FieldType);
+        Py_DECREF(pygf2x);
+        return NULL;
+    }
+    Py_INCREF(&FieldElementType);
+    if(PyModule_AddObject(pygf2x, "FieldElement", (PyObject *)&FieldElementType) < 0) {
+        Py_DECREF(&FieldElementType);
+        Py_DECREF(pygf2x);
+        return NULL;
+    }
+    Py_INCREF(&SubproductTreeType);
+    if(PyModule_AddObject(pygf2x, "SubproductTree", (PyObject *)&SubproductTreeType) < 0) {
+        Py_DECREF(&SubproductTreeType);
+        Py_DECREF(pygf2x);
+        return NULL;
+    }
+    Py_INCREF(&RemainderTreeType);
+    if(PyModule_AddObject(pygf2x, "RemainderTree", (PyObject *)&RemainderTreeType) < 0) {
+        Py_DECREF(&RemainderTreeType);
+        Py_DECREF(pygf2x);
+        return NULL;
+    }
+    Py_INCREF(&MultiplierType);
+    if(PyModule_AddObject(pygf2x, "Multiplier", (PyObject *)&MultiplierType) < 0) {
+        Py_DECREF(&MultiplierType);
+        Py_DECREF(pygf2x);
+        return NULL;
+    }
 
     return pygf2x;
 }
@@ -0,0 +1,608 @@
+/* -*- mode: c; c-basic-offset: 4; -*- */
+/*******************************************************************************
+ *
+ * Copyright (c) 2021 Oskar Enoksson. All rights reserved.
+ * Licensed under the MIT license. See LICENSE file in the project root for details.
+ *
+ * Description:
+ * Remainders of one polynomial over GF(2) modulo many, and Chinese remaindering
+ *
+ * A RemainderTree holds moduli m_j and the products M of the halves, quarters, ...
+ * of them, down to single moduli, each with its inverse for Barrett reduction
+ * (modulus.h). The moduli are split where the degrees of the halves are as equal as
+ * possible, so that the remainder modulo a node is at most about twice as long as
+ * the children, which is what modulus_reduce takes. A polynomial is reduced modulo
+ * all m_j by reducing it modulo the root, the remainder modulo the two children,
+ * and so on (remainder tree), for O(M(n) log k) instead of k divisions.
+ *
+ * For pairwise coprime moduli, the polynomial of degree < deg M with the residues r_j
+ * is found as for interpolation, by combining c_j = r_j*s_j mod m_j upwards as
+ *
+ *   R = R_left*M_right + R_right*M_left
+ *
+ * where s_j = (M/m_j)^-1 mod m_j. The cofactors M/m_j mod m_j are passed down the tree,
+ * each child getting the one of its parent times the product of its sibling, and
+ * are inverted by the extended Euclidean algorithm. This is done by the first
+ * reconstruction and cached.
+ *
+ *******************************************************************************/
+
+typedef struct {
+    PyObject_HEAD
+    int n;                  // Number of moduli
+    gf2x_modulus *mod;      // Products of the nodes and their inverses, pointing into f and e
+    int *split;             // First modulus of the right child of each node
+    int *leaf;              // Node of each modulus
+    digit *f;               // Products
+    digit *e;               // Inverses
+    int *roff;              // Offset of the residue of each modulus, in an array of nres digits
+    int nres;
+    digit *s;               // s_j at roff[j], computed by the first reconstruction
+} RemainderTreeObject;
+
+static PyTypeObject RemainderTreeType;
+
+//
+// The nodes are numbered in preorder: node i of moduli lo..hi-1 has its children
+// i+1 and i+2*(mid-lo), of moduli lo..mid-1 and mid..hi-1, where mid = split[i]
+//
+
+static void
+rt_rem(const gf2x_modulus *m, digit * restrict r, const digit *c, int ndigs_c)
+//
+// r = c mod f, for c of any length, where r has ndigs_r digits
+//
+{
+    while(ndigs_c > 0 && c[ndigs_c-1] == 0)
+        ndigs_c--;
+    const int nbits_c = fw_digits_nbits(c, ndigs_c);
+    if(nbits_c <= 2*(m->nbits_f - 1)) {
+        modulus_reduce(m, r, c, ndigs_c);
+        return;
+    }
+    // Longer than the inverse is for, divide
+    digit * restrict const u = ws_push(ndigs_c);
+    memcpy(u, c, ndigs_c*sizeof(digit));
+    divmod_digits(NULL, u, m->f, nbits_c, m->nbits_f, DIVMOD_R);
+    memcpy(r, u, m->ndigs_r*sizeof(digit));
+    ws_pop(u, ndigs_c);
+}
+
+static int
+rt_invmod(digit * restrict s, const digit *w, const gf2x_modulus *m)
+//
+// s = w^-1 mod f, where w is reduced and s has ndigs_r digits.
+// Return -1 if w and f are not coprime.
+//
+// Extended Euclid by shifts: with gu*w = u and gv*w = v (mod f), the longer of u
+// and v is reduced by the other, shifted to the same length, until v = 1. All g
+// stay shorter than f, but a shifted xor may touch one more word.
+//
+{
+    const int nw = m->nbits_f/64 + 1;
+    uint64_t * restrict const buf = ws_push_words(4*(nw+1));
+    uint64_t *u = buf;
+    uint64_t *v = u + (nw+1);
+    uint64_t *gu = v + (nw+1);
+    uint64_t *gv = gu + (nw+1);
+    memset(buf, 0, 4*(nw+1)*sizeof(uint64_t));
+    fw_from_digits(u, nw, m->f, m->ndigs_f);
+    fw_from_digits(v, nw, w, m->ndigs_r);
+    gv[0] = 1;
+    int nu = m->nbits_f;
+    int nv = fw_nbits(v, nw);
+    for(;;) {
+        if(nu < nv) {
+            uint64_t *t = u; u = v; v = t;
+            t = gu; gu = gv; gv = t;
+            const int n = nu; nu = nv; nv = n;
+        }
+        if(nv <= 1)
+            break;
+        const int shift = nu - nv;
+        fw_xor_lshift(u, v, (nv + 63)/64, shift);
+        fw_xor_lshift(gu, gv, (fw_nbits(gv, nw) + 63)/64, shift);
+        nu = fw_nbits(u, (nu + 63)/64);
+    }
+    if(nv == 1)
+        fw_to_digits(s, m->ndigs_r, gv, nw);
+    ws_pop_words(buf, 4*(nw+1));
+    return nv == 1 ? 0 : -1;
+}
+
+//
+// Tree
+//
+
+static void
+rt_layout(RemainderTreeObject *T, int i, int lo, int hi, const int64_t *deg,
+          int *nf, int *ne)
+//
+// Split node i and its descendants, where deg[j] is the sum of the degrees of the
+// first j moduli, and count the digits of the products and inverses in nf and ne.
+// The products and inverses are placed there if T->f and T->e are allocated.
+//
+{
+    gf2x_modulus *m = &T->mod[i];
+    m->nbits_f = (int)(deg[hi] - deg[lo]) + 1;
+    m->ndigs_f = (m->nbits_f + (PyLong_SHIFT-1))/PyLong_SHIFT;
+    m->ndigs_r = (m->nbits_f - 1 + (PyLong_SHIFT-1))/PyLong_SHIFT;
+    m->f = T->f ? T->f + *nf : NULL;
+    m->e = T->e ? T->e + *ne : NULL;
+    *nf += m->ndigs_f;
+    *ne += m->ndigs_r;
+    if(hi - lo == 1) {
+        T->leaf[lo] = i;
+        return;
+    }
+    // The split point where the degrees of the halves are closest
+    const int64_t half = (deg[lo] + deg[hi])/2;
+    int mid = lo + 1;
+    while(mid < hi - 1 && deg[mid] < half)
+        mid++;
+    if(mid > lo + 1 && half - deg[mid-1] < deg[mid] - half)
+        mid--;
+    T->split[i] = mid;
+    rt_layout(T, i+1, lo, mid, deg, nf, ne);
+    rt_layout(T, i+2*(mid-lo), mid, hi, deg, nf, ne);
+}
+
+static void
+rt_build(RemainderTreeObject *T, int i, int lo, int hi, PyObject **moduli)
+//
+// Products and inverses of node i and its descendants
+//
+{
+    gf2x_modulus *m = &T->mod[i];
+    if(hi - lo == 1) {
+        memcpy(m->f, ((PyLongObject *)moduli[lo])->ob_digit, m->ndigs_f*sizeof(digit));
+    } else {
+        const int mid = T->split[i];
+        const gf2x_modulus *l = &T->mod[i+1];
+        const gf2x_modulus *r = &T->mod[i+2*(mid-lo)];
+        rt_build(T, i+1, lo, mid, moduli);
+        rt_build(T, i+2*(mid-lo), mid, hi, moduli);
+        digit * restrict const p = ws_push(l->ndigs_f + r->ndigs_f);
+        memset(p, 0, (l->ndigs_f + r->ndigs_f)*sizeof(digit));
+        mul_nl_nr(p, l->f, l->ndigs_f, r->f, r->ndigs_f);
+        memcpy(m->f, p, m->ndigs_f*sizeof(digit));
+        ws_pop(p, l->ndigs_f + r->ndigs_f);
+    }
+    memset(m->e, 0, m->ndigs_r*sizeof(digit));
+    inverse(m->e, m->ndigs_r, m->nbits_f-1, m->f, m->ndigs_f, m->nbits_f);
+}
+
+static void
+rt_reduce(const RemainderTreeObject *T, int i, int lo, int hi, const digit *c, digit *res)
+//
+// Residues of c modulo the moduli lo..hi-1, where c is reduced modulo node i
+//
+{
+    const gf2x_modulus *m = &T->mod[i];
+    if(hi - lo == 1) {
+        memcpy(res + T->roff[lo], c, m->ndigs_r*sizeof(digit));
+        return;
+    }
+    const int mid = T->split[i];
+    const int child[2][3] = {{i+1, lo, mid}, {i+2*(mid-lo), mid, hi}};
+    for(int k=0; k<2; k++) {
+        const gf2x_modulus *mc = &T->mod[child[k][0]];
+        digit * restrict const t = ws_push(mc->ndigs_r);
+        rt_rem(mc, t, c, m->ndigs_r);
+        rt_reduce(T, child[k][0], child[k][1], child[k][2], t, res);
+        ws_pop(t, mc->ndigs_r);
+    }
+}
+
+static void
+rt_mulmod(const gf2x_modulus *m, digit *r, const digit *a, const digit *b)
+//
+// r = a*b mod f, for reduced a and b
+//
+{
+    const int nd = m->ndigs_r;
+    digit * restrict const p = ws_push(2*nd);
+    memset(p, 0, 2*nd*sizeof(digit));
+    mul_nl_nr(p, a, nd, b, nd);
+    rt_rem(m, r, p, 2*nd);
+    ws_pop(p, 2*nd);
+}
+
+static int
+rt_cofactors(RemainderTreeObject *T, int i, int lo, int hi, const digit *c)
+//
+// s_j for the moduli lo..hi-1, where c = (M/M_i) mod M_i for the product M_i of node i.
+// Return -1 if some cofactor is not invertible.
+//
+{
+    const gf2x_modulus *m = &T->mod[i];
+    if(hi - lo == 1)
+        return rt_invmod(T->s + T->roff[lo], c, m);
+    const int mid = T->split[i];
+    const int child[2][3] = {{i+1, lo, mid}, {i+2*(mid-lo), mid, hi}};
+    int err = 0;
+    for(int k=0; k<2 && !err; k++) {
+        const gf2x_modulus *mc = &T->mod[child[k][0]];
+        const gf2x_modulus *ms = &T->mod[child[1-k][0]];
+        const int nd = mc->ndigs_r;
+        digit * restrict const t = ws_push(2*nd);
+        rt_rem(mc, t, c, m->ndigs_r);
+        rt_rem(mc, t + nd, ms->f, ms->ndigs_f);
+        rt_mulmod(mc, t, t, t + nd);
+        err = rt_cofactors(T, child[k][0], child[k][1], child[k][2], t);
+        ws_pop(t, 2*nd);
+    }
+    return err;
+}
+
+static void
+rt_combine(const RemainderTreeObject *T, int i, int lo, int hi, const digit *c, digit *r)
+//
+// r = sum of c_j*M_i/m_j for lo <= j < hi, where r has the ndigs_r digits of node i
+//
+{
+    const gf2x_modulus *m = &T->mod[i];
+    if(hi - lo == 1) {
+        memcpy(r, c + T->roff[lo], m->ndigs_r*sizeof(digit));
+        return;
+    }
+    const int mid = T->split[i];
+    const gf2x_modulus *ml = &T->mod[i+1];
+    const gf2x_modulus *mr = &T->mod[i+2*(mid-lo)];
+    const int np = GF2X_MAX(ml->ndigs_r + mr->ndigs_f, mr->ndigs_r + ml->ndigs_f);
+    digit * restrict const t = ws_push(ml->ndigs_r + mr->ndigs_r + np);
+    digit * restrict const rl = t;
+    digit * restrict const rr = rl + ml->ndigs_r;
+    digit * restrict const p = rr + mr->ndigs_r;
+    rt_combine(T, i+1, lo, mid, c, rl);
+    rt_combine(T, i+2*(mid-lo), mid, hi, c, rr);
+    memset(p, 0, np*sizeof(digit));
+    mul_nl_nr(p, rl, ml->ndigs_r, mr->f, mr->ndigs_f);
+    mul_nl_nr(p, rr, mr->ndigs_r, ml->f, ml->ndigs_f);
+    memcpy(r, p, m->ndigs_r*sizeof(digit));
+    ws_pop(t, ml->ndigs_r + mr->ndigs_r + np);
+}
+
+//
+// Python object
+//
+
+static PyObject *
+rt_new(PyTypeObject *type, PyObject *args, PyObject *kwds)
+//
+// RemainderTree(moduli)
+//
+{
+    static char *kwlist[] = {"moduli", NULL};
+    PyObject *moduli;
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "O", kwlist, &moduli))
+        return NULL;
+    PyObject *seq = PySequence_Fast(moduli, "Moduli must be a sequence of integers");
+    if(seq == NULL)
+        return NULL;
+    const Py_ssize_t n = PySequence_Fast_GET_SIZE(seq);
+    PyObject **items = PySequence_Fast_ITEMS(seq);
+    if(n == 0) {
+        Py_DECREF(seq);
+        PyErr_SetString(PyExc_ValueError, "At least one modulus is required");
+        return NULL;
+    }
+    int64_t *deg = malloc((n+1)*sizeof(int64_t));
+    if(deg == NULL) {
+        Py_DECREF(seq);
+        return PyErr_NoMemory();
+    }
+    deg[0] = 0;
+    for(Py_ssize_t j=0; j<n; j++) {
+        if(!PyLong_Check(items[j])) {
+            PyErr_SetString(PyExc_TypeError, "Moduli must be integers");
+        } else if(((PyVarObject *)items[j])->ob_size < 0 || _PyLong_NumBits(items[j]) < 2) {
+            PyErr_SetString(PyExc_ValueError, "Moduli must have degree at least 1");
+        } else {
+            deg[j+1] = deg[j] + _PyLong_NumBits(items[j]) - 1;
+            if(deg[j+1] < (int64_t)PYGF2X_MAX_DIGITS*PyLong_SHIFT)
+                continue;
+            PyErr_SetString(PyExc_OverflowError, "Product of moduli is out of range");
+        }
+        free(deg);
+        Py_DECREF(seq);
+        return NULL;
+    }
+
+    RemainderTreeObject *T = (RemainderTreeObject *)type->tp_alloc(type, 0);
+    if(T == NULL) {
+        free(deg);
+        Py_DECREF(seq);
+        return NULL;
+    }
+    T->n = (int)n;
+    T->mod = malloc((2*n-1)*sizeof(gf2x_modulus));
+    T->split = malloc((2*n-1)*sizeof(int));
+    T->leaf = malloc(n*sizeof(int));
+    T->roff = malloc(n*sizeof(int));
+    if(!T->mod || !T->split || !T->leaf || !T->roff) {
+        free(deg);
+        Py_DECREF(seq);
+        Py_DECREF(T);
+        return PyErr_NoMemory();
+    }
+    int nf = 0;
+    int ne = 0;
+    rt_layout(T, 0, 0, T->n, deg, &nf, &ne);
+    T->f = malloc(nf*sizeof(digit));
+    T->e = malloc(ne*sizeof(digit));
+    if(!T->f || !T->e) {
+        free(deg);
+        Py_DECREF(seq);
+        Py_DECREF(T);
+        return PyErr_NoMemory();
+    }
+    nf = ne = 0;
+    rt_layout(T, 0, 0, T->n, deg, &nf, &ne);
+    free(deg);
+    for(int j=0; j<T->n; j++) {
+        T->roff[j] = T->nres;
+        T->nres += T->mod[T->leaf[j]].ndigs_r;
+    }
+    rt_build(T, 0, 0, T->n, items);
+    Py_DECREF(seq);
+    return (PyObject *)T;
+}
+
+static void
+rt_dealloc(RemainderTreeObject *self)
+{
+    free(self->mod);
+    free(self->split);
+    free(self->leaf);
+    free(self->f);
+    free(self->e);
+    free(self->roff);
+    free(self->s);
+    Py_TYPE(self)->tp_free((PyObject *)self);
+}
+
+static PyObject *
+rt_residues_to_list(const RemainderTreeObject *T, const digit *res)
+//
+// The residues as a list of integers
+//
+{
+    PyObject *l = PyList_New(T->n);
+    for(int j=0; l && j<T->n; j++) {
+        const int nd = field_ndigs(res + T->roff[j], T->mod[T->leaf[j]].ndigs_r);
+        PyLongObject *o = pylong_new(nd);
+        if(o == NULL) {
+            Py_CLEAR(l);
+        } else {
+            memcpy(o->ob_digit, res + T->roff[j], nd*sizeof(digit));
+            PyList_SET_ITEM(l, j, (PyObject *)o);
+        }
+    }
+    return l;
+}
+
+static PyObject *
+rt_reduce_pylong(RemainderTreeObject *self, PyObject *a)
+//
+// The residues of a modulo all moduli, as a list of integers
+//
+{
+    if(!PyLong_Check(a)) {
+        PyErr_SetString(PyExc_TypeError, "Argument must be an integer");
+        return NULL;
+    }
+    if(((PyVarObject *)a)->ob_size < 0) {
+        PyErr_SetString(PyExc_ValueError, "Argument must be non-negative");
+        return NULL;
+    }
+    if(((PyVarObject *)a)->ob_size > PYGF2X_MAX_DIGITS) {
+        PyErr_SetString(PyExc_ValueError, "Argument out of range");
+        return NULL;
+    }
+    digit *res = malloc(GF2X_MAX(self->nres, 1)*sizeof(digit));
+    if(res == NULL)
+        return PyErr_NoMemory();
+    const gf2x_modulus *m = &self->mod[0];
+    digit * restrict const t = ws_push(m->ndigs_r);
+    rt_rem(m, t, ((PyLongObject *)a)->ob_digit, ((PyVarObject *)a)->ob_size);
+    rt_reduce(self, 0, 0, self->n, t, res);
+    ws_pop(t, m->ndigs_r);
+    PyObject *l = rt_residues_to_list(self, res);
+    free(res);
+    return l;
+}
+
+static PyObject *
+rt_crt(RemainderTreeObject *self, PyObject *residues)
+//
+// The integer of degree less than the product of the moduli with the given residues
+//
+{
+    PyObject *seq = PySequence_Fast(residues, "Residues must be a sequence of integers");
+    if(seq == NULL)
+        return NULL;
+    if(PySequence_Fast_GET_SIZE(seq) != self->n) {
+        PyErr_Format(PyExc_ValueError, "Expected %d residues, got %zd", self->n, PySequence_Fast_GET_SIZE(seq));
+        Py_DECREF(seq);
+        return NULL;
+    }
+    PyObject **items = PySequence_Fast_ITEMS(seq);
+    for(int j=0; j<self->n; j++) {
+        if(!PyLong_Check(items[j])) {
+            PyErr_SetString(PyExc_TypeError, "Residues must be integers");
+        } else if(((PyVarObject *)items[j])->ob_size < 0) {
+            PyErr_SetString(PyExc_ValueError, "Residues must be non-negative");
+        } else if(((PyVarObject *)items[j])->ob_size > PYGF2X_MAX_DIGITS) {
+            PyErr_SetString(PyExc_ValueError, "Residue out of range");
+        } else {
+            continue;
+        }
+        Py_DECREF(seq);
+        return NULL;
+    }
+
+    if(self->s == NULL) {
+        // The inverse cofactors, starting from M/M = 1 at the root
+        const gf2x_modulus *m = &self->mod[0];
+        self->s = malloc(GF2X_MAX(self->nres, 1)*sizeof(digit));
+        digit * restrict const one = ws_push(m->ndigs_r);
+        int err = self->s == NULL;
+        if(!err) {
+            memset(one, 0, m->ndigs_r*sizeof(digit));
+            one[0] = 1;
+            err = rt_cofactors(self, 0, 0, self->n, one);
+            if(err)
+                PyErr_SetString(PyExc_ValueError, "Moduli must be pairwise coprime");
+        } else {
+            PyErr_NoMemory();
+        }
+        ws_pop(one, m->ndigs_r);
+        if(err) {
+            free(self->s);
+            self->s = NULL;
+            Py_DECREF(seq);
+            return NULL;
+        }
+    }
+
+    // c_j = r_j*s_j mod m_j, in leaf order
+    digit *c = malloc(GF2X_MAX(self->nres, 1)*sizeof(digit));
+    if(c == NULL) {
+        Py_DECREF(seq);
+        return PyErr_NoMemory();
+    }
+    for(int j=0; j<self->n; j++) {
+        const gf2x_modulus *m = &self->mod[self->leaf[j]];
+        digit * restrict const t = ws_push(m->ndigs_r);
+        rt_rem(m, t, ((PyLongObject *)items[j])->ob_digit, ((PyVarObject *)items[j])->ob_size);
+        rt_mulmod(m, c + self->roff[j], t, self->s + self->roff[j]);
+        ws_pop(t, m->ndigs_r);
+    }
+    Py_DECREF(seq);
+
+    const gf2x_modulus *m = &self->mod[0];
+    PyLongObject *r = pylong_new(m->ndigs_r);
+    if(r != NULL) {
+        rt_combine(self, 0, 0, self->n, c, r->ob_digit);
+        pylong_trim(r, m->ndigs_r);
+    }
+    free(c);
+    return (PyObject *)r;
+}
+
+static Py_ssize_t
+rt_length(RemainderTreeObject *self)
+{
+    return self->n;
+}
+
+static PyObject *
+rt_get_product(RemainderTreeObject *self, void *closure)
+{
+    (void)closure;
+    const gf2x_modulus *m = &self->mod[0];
+    PyLongObject *p = pylong_new(m->ndigs_f);
+    if(p)
+        memcpy(p->ob_digit, m->f, m->ndigs_f*sizeof(digit));
+    return (PyObject *)p;
+}
+
+static PyMethodDef rt_methods[] =
+    {
+        {
+            "reduce",
+            (PyCFunction)rt_reduce_pylong,
+            METH_O,
+            "Remainders of an integer modulo all moduli, as a list of integers"
+        },
+        {
+            "crt",
+            (PyCFunction)rt_crt,
+            METH_O,
+            "Integer of degree less than the product of the pairwise coprime moduli, with the given remainders"
+        },
+        {NULL, NULL, 0, NULL}
+    };
+
+static PyGetSetDef rt_getset[] =
+    {
+        {"product", (getter)rt_get_product, NULL, "Product of all moduli", NULL},
+        {NULL, NULL, NULL, NULL, NULL}
+    };
+
+static PySequenceMethods rt_as_sequence =
+    {
+        .sq_length = (lenfunc)rt_length,
+    };
+
+static PyTypeObject RemainderTreeType =
+    {
+        PyVarObject_HEAD_INIT(NULL, 0)
+        .tp_name = "pygf2x.RemainderTree",
+        .tp_basicsize = sizeof(RemainderTreeObject),
+        .tp_itemsize = 0,
+        .tp_dealloc = (destructor)rt_dealloc,
+        .tp_as_sequence = &rt_as_sequence,
+        .tp_flags = Py_TPFLAGS_DEFAULT,
+        .tp_doc = "RemainderTree(moduli)\n"
+                  "Product and remainder tree of integers as polynomials over GF(2), of degree at\n"
+                  "least 1, for remainders modulo all of them and Chinese remaindering.",
+        .tp_methods = rt_methods,
+        .tp_getset = rt_getset,
+        .tp_new = rt_new,
+    };
+
+//
+// Module functions, taking the moduli as a sequence or a RemainderTree
+//
+
+static PyObject *
+rt_tree(PyObject *moduli)
+//
+// New reference to the RemainderTree of the moduli
+//
+{
+    if(PyObject_TypeCheck(moduli, &RemainderTreeType)) {
+        Py_INCREF(moduli);
+        return moduli;
+    }
+    return PyObject_CallFunctionObjArgs((PyObject *)&RemainderTreeType, moduli, NULL);
+}
+
+static PyObject *
+pygf2x_multi_mod(PyObject *self, PyObject *args)
+//
+// multi_mod(a, moduli): [a mod m for m in moduli]
+//
+{
+    (void)self;
+    PyObject *a, *moduli;
+    if(!PyArg_ParseTuple(args, "OO", &a, &moduli))
+        return NULL;
+    PyObject *T = rt_tree(moduli);
+    if(T == NULL)
+        return NULL;
+    PyObject *r = rt_reduce_pylong((RemainderTreeObject *)T, a);
+    Py_DECREF(T);
+    return r;
+}
+
+static PyObject *
+pygf2x_crt(PyObject *self, PyObject *args)
+//
+// crt(residues, moduli): the integer a of degree less than the product of the moduli
+// with a mod m = r for the residues r and pairwise coprime moduli m
+//
+{
+    (void)self;
+    PyObject *residues, *moduli;
+    if(!PyArg_ParseTuple(args, "OO", &residues, &moduli))
+        return NULL;
+    PyObject *T = rt_tree(moduli);
+    if(T == NULL)
+        return NULL;
+    PyObject *r = rt_crt((RemainderTreeObject *)T, residues);
+    Py_DECREF(T);
+    return r;
+}
@@ -0,0 +1,87 @@
+/* -*- mode: c; c-basic-offset: 4; -*- */
+/*******************************************************************************
+ *
+ * Copyright (c) 2021 Oskar Enoksson. All rights reserved.
+ * Licensed under the MIT license. See LICENSE file in the project root for details.
+ *
+ * Description:
+ * Multiplication by a sparse factor, as a sum of shifted copies of the other
+ *
+ * With b = x^j1 + ... + x^jw, a*b is the xor of a shifted by each j, which costs
+ * w passes over a instead of the Karatsuba recursion. Trinomial and pentanomial
+ * moduli, x^k+1 and such are typical sparse factors. The Hamming weight is
+ * counted with an early exit, so a dense factor is rejected after its first few
+ * digits.
+ *
+ *******************************************************************************/
+
+static int
+sparse_weight(const digit *a, int na, int limit)
+//
+// Number of non-zero bits of a, or limit+1 if there are more than limit
+//
+{
+    int w = 0;
+    for(int i=0; i<na && w<=limit; i++)
+        w += popcount_64(a[i]);
+    return GF2X_MIN(w, limit+1);
+}
+
+static void
+mul_sparse(digit * restrict p, const digit *a, int na, const digit *b, int nb)
+//
+// p ^= a*b by shifted copies of a, one for each non-zero bit of b, where p has na+nb digits
+//
+{
+    for(int j=0; j<nb; j++) {
+        for(digit bj=b[j]; bj; bj&=bj-1) {
+            int s = 0;
+            while(((bj >> s) & 1) == 0)
+                s++;
+            digit * restrict const pj = p + j;
+            digit c = 0;
+            for(int i=0; i<na; i++) {
+                pj[i] ^= ((a[i] << s) & PyLong_MASK) | c;
+                c = a[i] >> (PyLong_SHIFT - s);
+            }
+            pj[na] ^= c;
+        }
+    }
+}
+
+static int
+sparse_limit(int ndigs)
+//
+// Max weight of a factor multiplied by shifts, where the shorter factor has ndigs digits.
+// For factors of n <= N digits the shifts cost about w*N and Karatsuba, in chunks of n,
+// about N*n^0.58, so the limit grows as n^0.58: it is sparse_mul_limit up to 3072 bits
+// and doubled each time n triples. Below that, no more than n, since the schoolbook
+// product makes n passes over the long factor.
+//
+{
+    int limit = sparse_mul_limit;
+    for(int64_t n=(int64_t)ndigs*PyLong_SHIFT; n >= 3*1024 && limit < INT_MAX/2; n /= 3)
+        limit *= 2;
+    return GF2X_MIN(limit, ndigs);
+}
+
+static void
+mul_sparse_or_dense(digit * restrict p, const digit *a, int na, const digit *b, int nb)
+//
+// p ^= a*b, by shifted copies if one factor is sparse, else by mul_nl_nr,
+// where p has na+nb digits
+//
+{
+    if(sparse_mul_limit > 0) {
+        const int limit = sparse_limit(GF2X_MIN(na, nb));
+        if(sparse_weight(b, nb, limit) <= limit) {
+            mul_sparse(p, a, na, b, nb);
+            return;
+        }
+        if(sparse_weight(a, na, limit) <= limit) {
+            mul_sparse(p, b, nb, a, na);
+            return;
+        }
+    }
+    mul_nl_nr(p, a, na, b, nb);
+}
@@ -0,0 +1,132 @@
+/* -*- mode: c; c-basic-offset: 4; -*- */
+/*******************************************************************************
+ *
+ * Copyright (c) 2021 Oskar Enoksson. All rights reserved.
+ * Licensed under the MIT license. See LICENSE file in the project root for details.
+ *
+ * Description:
+ * Squaring of polynomials over GF(2) by SIMD bit spreading, on x86
+ *
+ * Squaring over GF(2) only inserts a zero bit after every bit of the operand, so the
+ * square can be formed many digits at a time without any multiplication. Each byte is
+ * split into its two nibbles, which are looked up with PSHUFB in a table of spread
+ * nibbles, and the results are interleaved into the spread 16-bit value of the byte.
+ * This is done 16 bytes at a time with SSSE3 and 32 bytes at a time with AVX2. With
+ * only SSE2 (the x86-64 baseline) the bytes are spread by shifts and masks instead.
+ *
+ * The bits of each digit are first arranged so that the spread bytes come out in the
+ * order of the digits of the square, with 30-bit digits, or fixed up afterwards with
+ * 15-bit digits.
+ *
+ *******************************************************************************/
+
+#if defined(__GNUC__) && defined(__SSE2__)
+#define PYGF2X_SQUARE_SIMD
+
+#include <immintrin.h>
+
+static inline __m128i
+sqs_spread_128(__m128i x, __m128i *hi)
+//
+// Spread the bits of the 16 bytes of x into 16-bit values
+// Return those of bytes 0-7, store those of bytes 8-15 in *hi
+//
+{
+#ifdef __SSSE3__
+    const __m128i table = _mm_setr_epi8(0x00, 0x01, 0x04, 0x05, 0x10, 0x11, 0x14, 0x15,
+                                        0x40, 0x41, 0x44, 0x45, 0x50, 0x51, 0x54, 0x55);
+    const __m128i nibble = _mm_set1_epi8(0x0f);
+    __m128i l = _mm_shuffle_epi8(table, _mm_and_si128(x, nibble));
+    __m128i h = _mm_shuffle_epi8(table, _mm_and_si128(_mm_srli_epi16(x, 4), nibble));
+    *hi = _mm_unpackhi_epi8(l, h);
+    return _mm_unpacklo_epi8(l, h);
+#else
+    const __m128i zero = _mm_setzero_si128();
+    __m128i v[2] = {_mm_unpacklo_epi8(x, zero), _mm_unpackhi_epi8(x, zero)};
+    for(int i=0; i<2; i++) {
+        v[i] = _mm_and_si128(_mm_or_si128(v[i], _mm_slli_epi16(v[i], 4)), _mm_set1_epi16(0x0f0f));
+        v[i] = _mm_and_si128(_mm_or_si128(v[i], _mm_slli_epi16(v[i], 2)), _mm_set1_epi16(0x3333));
+        v[i] = _mm_and_si128(_mm_or_si128(v[i], _mm_slli_epi16(v[i], 1)), _mm_set1_epi16(0x5555));
+    }
+    *hi = v[1];
+    return v[0];
+#endif
+}
+
+#if (PyLong_SHIFT == 30)
+// Low 15 bits of each digit in bits 0-14, high 15 bits in bits 16-30, so that the
+// two spread 16-bit halves are the two digits of its square
+#define SQS_PRE(x, set1, and, or, slli)                                 \
+    or(and(x, set1(0x7fff)), and(slli(x, 1), set1(0x7fff0000)))
+#define SQS_POST(x, set1, and, add) (x)
+#elif (PyLong_SHIFT == 15)
+// The spread high byte of each digit ends one bit below the second digit of its
+// square, and is shifted into place by adding it to itself
+#define SQS_PRE(x, set1, and, or, slli) (x)
+#define SQS_POST(x, set1, and, add) add(x, and(x, set1(0xffff0000)))
+#else
+#error
+#endif
+
+#ifdef __AVX2__
+static inline __m256i
+sqs_spread_256(__m256i x, __m256i *hi)
+//
+// Spread the bits of the 32 bytes of x into 16-bit values
+// Return those of bytes 0-15, store those of bytes 16-31 in *hi
+//
+{
+    const __m256i table = _mm256_setr_epi8(0x00, 0x01, 0x04, 0x05, 0x10, 0x11, 0x14, 0x15,
+                                           0x40, 0x41, 0x44, 0x45, 0x50, 0x51, 0x54, 0x55,
+                                           0x00, 0x01, 0x04, 0x05, 0x10, 0x11, 0x14, 0x15,
+                                           0x40, 0x41, 0x44, 0x45, 0x50, 0x51, 0x54, 0x55);
+    const __m256i nibble = _mm256_set1_epi8(0x0f);
+    // The unpacks work within 128-bit lanes, so the 64-bit quarters are first
+    // reordered 0 2 1 3 for the results to come out in order
+    x = _mm256_permute4x64_epi64(x, 0xd8);
+    __m256i l = _mm256_shuffle_epi8(table, _mm256_and_si256(x, nibble));
+    __m256i h = _mm256_shuffle_epi8(table, _mm256_and_si256(_mm256_srli_epi16(x, 4), nibble));
+    *hi = _mm256_unpackhi_epi8(l, h);
+    return _mm256_unpacklo_epi8(l, h);
+}
+#endif
+
+static int
+square_simd(digit * restrict result, const digit *fdigits, int ndigs_f)
+//
+// Square the lowest digits of f, as many as fill whole vectors, into 2x as many digits
+// of result. Return the number of digits of f squared.
+//
+{
+    int id = 0;
+#ifdef __AVX2__
+    const int n256 = 32/sizeof(digit);
+    for(; id+n256 <= ndigs_f; id+=n256) {
+        __m256i x = _mm256_loadu_si256((const __m256i *)(fdigits + id));
+        x = SQS_PRE(x, _mm256_set1_epi32, _mm256_and_si256, _mm256_or_si256, _mm256_slli_epi32);
+        __m256i hi;
+        __m256i lo = sqs_spread_256(x, &hi);
+        lo = SQS_POST(lo, _mm256_set1_epi32, _mm256_and_si256, _mm256_add_epi32);
+        hi = SQS_POST(hi, _mm256_set1_epi32, _mm256_and_si256, _mm256_add_epi32);
+        _mm256_storeu_si256((__m256i *)(result + 2*id), lo);
+        _mm256_storeu_si256((__m256i *)(result + 2*id + n256), hi);
+    }
+#endif
+    const int n128 = 16/sizeof(digit);
+    for(; id+n128 <= ndigs_f; id+=n128) {
+        __m128i x = _mm_loadu_si128((const __m128i *)(fdigits + id));
+        x = SQS_PRE(x, _mm_set1_epi32, _mm_and_si128, _mm_or_si128, _mm_slli_epi32);
+        __m128i hi;
+        __m128i lo = sqs_spread_128(x, &hi);
+        lo = SQS_POST(lo, _mm_set1_epi32, _mm_and_si128, _mm_add_epi32);
+        hi = SQS_POST(hi, _mm_set1_epi32, _mm_and_si128, _mm_add_epi32);
+        _mm_storeu_si128((__m128i *)(result + 2*id), lo);
+        _mm_storeu_si128((__m128i *)(result + 2*id + n128), hi);
+    }
+    return id;
+}
+
+#undef SQS_PRE
+#undef SQS_POST
+
+#endif // __GNUC__ && __SSE2__
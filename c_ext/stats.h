@@ -0,0 +1,230 @@
+/* -*- mode: c; c-basic-offset: 4; -*- */
+/*******************************************************************************
+ *
+ * Copyright (c) 2021 Oskar Enoksson. All rights reserved.
+ * Licensed under the MIT license. See LICENSE file in the project root for details.
+ *
+ * Description:
+ * Optional operation counters and timing, enabled at runtime by enable_stats
+ *
+ * Per kernel the number of calls, the accumulated time and a histogram of operand
+ * sizes are kept, together with the scratch and integer object allocations and
+ * the recursion depths of mul_nl_nr. When disabled, the cost is one predictable
+ * branch per kernel call.
+ *
+ * The time is counted in TSC cycles on x86 with GCC, and in nanoseconds otherwise.
+ * Nested kernels are timed separately, e.g. the time of divmod includes the time
+ * of inverse. Recursive calls of mul_nl_nr are only timed at the top level.
+ *
+ *******************************************************************************/
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <x86intrin.h>
+#define STATS_CLOCK "tsc"
+#else
+#include <time.h>
+#define STATS_CLOCK "ns"
+#endif
+
+#define STATS_NBUCKETS 32  // Histogram buckets, bucket i counts values v with 2^(i-1) <= v < 2^i
+
+enum {
+    STATS_MUL,
+    STATS_SQR,
+    STATS_DIVMOD,
+    STATS_DIV,
+    STATS_MOD,
+    STATS_DIVEXACT,
+    STATS_INV,
+    STATS_MUL_BATCH,
+    STATS_RINV,
+    STATS_PROD,
+    STATS_MUL_NL_NR,
+    STATS_INVERSE,
+    STATS_DIVMOD_DIGITS,
+    STATS_NKERNELS
+};
+
+static const char * const stats_kernel_names[STATS_NKERNELS] = {
+    "mul", "sqr", "divmod", "div", "mod", "divexact", "inv", "mul_batch", "rinv", "prod", "mul_nl_nr", "inverse", "divmod_digits"
+};
+
+typedef struct {
+    uint64_t calls;
+    uint64_t ticks;
+    uint64_t nbits[STATS_NBUCKETS];      // Operand sizes in bits, where recorded
+} stats_kernel;
+
+static struct {
+    bool enabled;
+    stats_kernel kernel[STATS_NKERNELS];
+    uint64_t alloc_calls;                // Scratch memory
+    uint64_t alloc_bytes;
+    uint64_t pylong_calls;               // Result objects
+    uint64_t pylong_bytes;
+    int mul_depth;                       // Current recursion depth of mul_nl_nr
+    uint64_t mul_depth_calls[STATS_NBUCKETS];   // Calls by recursion depth
+} pygf2x_stats;
+
+static inline uint64_t
+stats_ticks(void)
+{
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    return __rdtsc();
+#else
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (uint64_t)t.tv_sec*1000000000u + t.tv_nsec;
+#endif
+}
+
+static inline int
+stats_bucket(uint64_t v)
+{
+    int b = 0;
+    for(; v && b < STATS_NBUCKETS-1; v >>= 1)
+        b++;
+    return b;
+}
+
+// Start timing a kernel, in a scope that ends with STATS_END
+#define STATS_BEGIN()                                                   \
+    const uint64_t stats_t0 = pygf2x_stats.enabled ? stats_ticks() : 0
+
+#define STATS_END(k)                                                    \
+    if(pygf2x_stats.enabled) {                                          \
+        pygf2x_stats.kernel[k].calls++;                                 \
+        pygf2x_stats.kernel[k].ticks += stats_ticks() - stats_t0;       \
+    }
+
+// Define name_timed, which calls the Python function name and times it as kernel k
+#define STATS_TIMED(name, k)                                            \
+    static PyObject *                                                   \
+    name##_timed(PyObject *self, PyObject *args)                        \
+    {                                                                   \
+        STATS_BEGIN();                                                  \
+        PyObject *result = name(self, args);                            \
+        STATS_END(k);                                                   \
+        return result;                                                  \
+    }
+
+static inline void
+stats_size(int k, uint64_t nbits)
+{
+    if(pygf2x_stats.enabled)
+        pygf2x_stats.kernel[k].nbits[stats_bucket(nbits)]++;
+}
+
+static inline void *
+stats_malloc(size_t size)
+{
+    if(pygf2x_stats.enabled) {
+        pygf2x_stats.alloc_calls++;
+        pygf2x_stats.alloc_bytes += size;
+    }
+    return malloc(size);
+}
+
+static PyObject *
+stats_histogram(const uint64_t *h)
+//
+// Dict from the exclusive upper bound of each non-empty bucket to its count
+//
+{
+    PyObject *d = PyDict_New();
+    for(int b=0; d && b<STATS_NBUCKETS; b++) {
+        if(h[b] == 0)
+            continue;
+        PyObject *key = PyLong_FromUnsignedLongLong(b < STATS_NBUCKETS-1 ? (uint64_t)1 << b : UINT64_MAX);
+        PyObject *value = PyLong_FromUnsignedLongLong(h[b]);
+        if(!key || !value || PyDict_SetItem(d, key, value) < 0)
+            Py_CLEAR(d);
+        Py_XDECREF(key);
+        Py_XDECREF(value);
+    }
+    return d;
+}
+
+static PyObject *
+stats_list(const uint64_t *h)
+//
+// List of all counts up to the last non-zero one
+//
+{
+    int n = STATS_NBUCKETS;
+    while(n > 0 && h[n-1] == 0)
+        n--;
+    PyObject *l = PyList_New(n);
+    for(int i=0; l && i<n; i++) {
+        PyObject *v = PyLong_FromUnsignedLongLong(h[i]);
+        if(!v)
+            Py_CLEAR(l);
+        else
+            PyList_SET_ITEM(l, i, v);
+    }
+    return l;
+}
+
+static PyObject *
+pygf2x_stats_get(PyObject *self, PyObject *args)
+//
+// All counters as a dict
+//
+{
+    (void)self;
+    (void)args;
+
+    PyObject *kernels = PyDict_New();
+    for(int k=0; kernels && k<STATS_NKERNELS; k++) {
+        const stats_kernel *s = &pygf2x_stats.kernel[k];
+        PyObject *v = Py_BuildValue("{s:K,s:K,s:N}",
+                                    "calls", (unsigned long long)s->calls,
+                                    "ticks", (unsigned long long)s->ticks,
+                                    "nbits", stats_histogram(s->nbits));
+        if(!v || PyDict_SetItemString(kernels, stats_kernel_names[k], v) < 0)
+            Py_CLEAR(kernels);
+        Py_XDECREF(v);
+    }
+    if(!kernels)
+        return NULL;
+    return Py_BuildValue("{s:O,s:s,s:N,s:K,s:K,s:K,s:K,s:N}",
+                         "enabled", pygf2x_stats.enabled ? Py_True : Py_False,
+                         "clock", STATS_CLOCK,
+                         "kernels", kernels,
+                         "alloc_calls", (unsigned long long)pygf2x_stats.alloc_calls,
+                         "alloc_bytes", (unsigned long long)pygf2x_stats.alloc_bytes,
+                         "pylong_calls", (unsigned long long)pygf2x_stats.pylong_calls,
+                         "pylong_bytes", (unsigned long long)pygf2x_stats.pylong_bytes,
+                         "mul_nl_nr_depth", stats_list(pygf2x_stats.mul_depth_calls));
+}
+
+static PyObject *
+pygf2x_reset_stats(PyObject *self, PyObject *args)
+//
+// Clear all counters, but keep them enabled or disabled
+//
+{
+    (void)self;
+    (void)args;
+
+    const bool enabled = pygf2x_stats.enabled;
+    memset(&pygf2x_stats, 0, sizeof(pygf2x_stats));
+    pygf2x_stats.enabled = enabled;
+    Py_RETURN_NONE;
+}
+
+static PyObject *
+pygf2x_enable_stats(PyObject *self, PyObject *flag)
+//
+// Enable or disable the counters, and return whether they were enabled before
+//
+{
+    (void)self;
+
+    const int enable = PyObject_IsTrue(flag);
+    if(enable < 0)
+        return NULL;
+    const bool was_enabled = pygf2x_stats.enabled;
+    pygf2x_stats.enabled = enable;
+    return PyBool_FromLong(was_enabled);
+}
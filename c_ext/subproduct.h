@@ -0,0 +1,540 @@
+/* -*- mode: c; c-basic-offset: 4; -*- */
+/*******************************************************************************
+ *
+ * Copyright (c) 2021 Oskar Enoksson. All rights reserved.
+ * Licensed under the MIT license. See LICENSE file in the project root for details.
+ *
+ * Description:
+ * Multipoint evaluation and interpolation of polynomials over GF(2^k), k <= 64
+ *
+ * A SubproductTree holds n points x_i of a Field and the products M = prod (y + x_i)
+ * over the halves, quarters, ... of the points, down to single points. A polynomial
+ * is evaluated at all points by reducing it modulo the root, the remainder modulo
+ * the two children, and so on (remainder tree). It is interpolated from its values
+ * v_i by combining c_i = v_i/M'(x_i) upwards as
+ *
+ *   R = R_left*M_right + R_right*M_left
+ *
+ * Polynomials over GF(2^k) are multiplied by Kronecker substitution, see packed.h.
+ *
+ * The remainder modulo a node M of degree m is computed by Barrett reduction, as in
+ * modulus.h but in y. With rev(p) the polynomial p with its coefficients reversed and
+ * g = rev(M)^-1 mod y^l, the l highest coefficients of a give the quotient
+ *
+ *   rev(q) = rev(a)*g mod y^l
+ *
+ * The inverse g of every node is cached in the tree, for the l a parent remainder
+ * needs. It is built by Newton iteration, which in characteristic 2 is
+ *
+ *   g' = rev(M)*g^2 mod y^2l
+ *
+ * where squaring only squares each coefficient of g.
+ *
+ * In Python, polynomials over GF(2^k) are in packed form, see packed.h.
+ *
+ *******************************************************************************/
+
+#define SPT_LEAF 16         // Nodes of at most this many points evaluate the remainder by Horner
+
+typedef struct {
+    PyObject_HEAD
+    FieldObject *field;
+    pk_reducer *R;          // Reduction modulo the field modulus
+    int n;                  // Number of points
+    uint64_t *x;            // Points
+    uint64_t *m;            // Node products, node i of points lo..hi-1 has hi-lo+1 coefficients
+    int *moff;              // Offset in m of each node
+    uint64_t *g;            // Cached inverses, for the children of nodes of more than SPT_LEAF points
+    int *goff;              // Offset in g of each node, or -1
+    uint64_t *winv;         // 1/M'(x_i), computed by the first interpolation
+} SubproductTreeObject;
+
+static PyTypeObject SubproductTreeType;
+
+//
+// Inverse and remainder of polynomials over GF(2^k), as arrays of one word per coefficient
+//
+// The nodes are numbered in preorder: node i of points lo..hi-1 has its children
+// i+1 and i+2*(mid-lo), of points lo..mid-1 and mid..hi-1, where mid = lo+(hi-lo)/2
+//
+
+static void
+spt_inverse(const pk_reducer *R, uint64_t * restrict g, int l,
+            const uint64_t *h, int nh)
+//
+// g = h^-1 mod y^l, where h has nh coefficients and h[0] = 1
+//
+{
+    uint64_t *t = ws_push_words(3*l);
+    g[0] = 1;
+    for(int lg=1; lg<l; ) {
+        const int l2 = GF2X_MIN(2*lg, l);
+        uint64_t *sq = t;
+        uint64_t *hsq = t + l2;
+        memset(sq, 0, l2*sizeof(uint64_t));
+        for(int i=0; 2*i<l2; i++)
+            sq[2*i] = pk_mulmod(R, g[i], g[i]);
+        pk_mul(R, hsq, h, GF2X_MIN(nh, l2), sq, l2);
+        memcpy(g, hsq, l2*sizeof(uint64_t));
+        lg = l2;
+    }
+    ws_pop_words(t, 3*l);
+}
+
+static void
+spt_inverse_rev(const pk_reducer *R, uint64_t * restrict g, int l,
+                const uint64_t *m, int deg)
+//
+// g = rev(m)^-1 mod y^l, where m is monic of degree deg
+//
+{
+    const int nh = GF2X_MIN(deg+1, l);
+    uint64_t *h = ws_push_words(nh);
+    for(int i=0; i<nh; i++)
+        h[i] = m[deg-i];
+    spt_inverse(R, g, l, h, nh);
+    ws_pop_words(h, nh);
+}
+
+static void
+spt_rem(const pk_reducer *R, uint64_t * restrict r, const uint64_t *a, int na,
+        const uint64_t *m, int deg, const uint64_t *g)
+//
+// r = a mod m with deg coefficients, where m is monic of degree deg < na and
+// g = rev(m)^-1 mod y^l with at least l = na-deg coefficients
+//
+{
+    const int lq = na - deg;
+    uint64_t *t = ws_push_words(3*lq + na);
+    uint64_t *q = t;
+    uint64_t *rq = t + lq;
+    uint64_t *qm = t + 3*lq;
+    for(int i=0; i<lq; i++)
+        q[i] = a[na-1-i];
+    pk_mul(R, rq, q, lq, g, lq);
+    for(int i=0; i<lq; i++)
+        q[i] = rq[lq-1-i];
+    pk_mul(R, qm, q, lq, m, deg+1);
+    for(int i=0; i<deg; i++)
+        r[i] = a[i] ^ qm[i];
+    ws_pop_words(t, 3*lq + na);
+}
+
+//
+// Tree
+//
+
+static void
+spt_layout(SubproductTreeObject *T, int i, int lo, int hi, int *nm, int *ng, int l)
+//
+// Assign the offsets of node i and its descendants, counting the coefficients in nm and ng,
+// where node i needs an inverse with l coefficients, or none if l is 0
+//
+{
+    T->moff[i] = *nm;
+    *nm += hi - lo + 1;
+    T->goff[i] = l ? *ng : -1;
+    *ng += l;
+    if(hi - lo > 1) {
+        // A remainder of this node has at most hi-lo coefficients, so the quotient by
+        // either child has at most as many as the other child
+        const int mid = lo + (hi-lo)/2;
+        const bool big = hi - lo > SPT_LEAF;
+        spt_layout(T, i+1, lo, mid, nm, ng, big ? hi-mid : 0);
+        spt_layout(T, i+2*(mid-lo), mid, hi, nm, ng, big ? mid-lo : 0);
+    }
+}
+
+static void
+spt_build(SubproductTreeObject *T, int i, int lo, int hi)
+//
+// Products of node i and its descendants, and the inverses of its children
+//
+{
+    const pk_reducer *R = T->R;
+    uint64_t *m = T->m + T->moff[i];
+    if(hi - lo == 1) {
+        m[0] = T->x[lo];
+        m[1] = 1;
+        return;
+    }
+    const int mid = lo + (hi-lo)/2;
+    const int il = i+1;
+    const int ir = i+2*(mid-lo);
+    spt_build(T, il, lo, mid);
+    spt_build(T, ir, mid, hi);
+    pk_mul(R, m, T->m + T->moff[il], mid-lo+1, T->m + T->moff[ir], hi-mid+1);
+    if(T->goff[il] >= 0) {
+        spt_inverse_rev(R, T->g + T->goff[il], hi-mid, T->m + T->moff[il], mid-lo);
+        spt_inverse_rev(R, T->g + T->goff[ir], mid-lo, T->m + T->moff[ir], hi-mid);
+    }
+}
+
+static void
+spt_eval(const SubproductTreeObject *T, int i, int lo, int hi,
+         const uint64_t *r, int nr, uint64_t *v)
+//
+// v[j] = r(x_j) for lo <= j < hi, where r has nr <= hi-lo coefficients
+//
+{
+    const pk_reducer *R = T->R;
+    if(hi - lo <= SPT_LEAF) {
+        for(int j=lo; j<hi; j++) {
+            uint64_t y = 0;
+            for(int k=nr-1; k>=0; k--) {
+                y = pk_mulmod(R, y, T->x[j]);
+                y ^= r[k];
+            }
+            v[j] = y;
+        }
+        return;
+    }
+    const int mid = lo + (hi-lo)/2;
+    const int child[2][3] = {{i+1, lo, mid}, {i+2*(mid-lo), mid, hi}};
+    uint64_t *t = ws_push_words(hi-mid);
+    for(int c=0; c<2; c++) {
+        const int ic = child[c][0];
+        const int deg = child[c][2] - child[c][1];
+        if(nr > deg) {
+            spt_rem(R, t, r, nr, T->m + T->moff[ic], deg, T->g + T->goff[ic]);
+            spt_eval(T, ic, child[c][1], child[c][2], t, deg, v);
+        } else {
+            spt_eval(T, ic, child[c][1], child[c][2], r, nr, v);
+        }
+    }
+    ws_pop_words(t, hi-mid);
+}
+
+static void
+spt_combine(const SubproductTreeObject *T, int i, int lo, int hi,
+            const uint64_t *c, uint64_t *r)
+//
+// r = sum of c_j*M/(y + x_j) for lo <= j < hi, with M the product of node i,
+// which has hi-lo coefficients
+//
+{
+    const pk_reducer *R = T->R;
+    if(hi - lo == 1) {
+        r[0] = c[lo];
+        return;
+    }
+    const int mid = lo + (hi-lo)/2;
+    const int il = i+1;
+    const int ir = i+2*(mid-lo);
+    const int n = hi - lo;
+    spt_combine(T, il, lo, mid, c, r);
+    spt_combine(T, ir, mid, hi, c, r + (mid-lo));
+    uint64_t *t = ws_push_words(2*n);
+    pk_mul(R, t, r, mid-lo, T->m + T->moff[ir], hi-mid+1);
+    pk_mul(R, t+n, r + (mid-lo), hi-mid, T->m + T->moff[il], mid-lo+1);
+    for(int j=0; j<n; j++)
+        r[j] = t[j] ^ t[n+j];
+    ws_pop_words(t, 2*n);
+}
+
+static int
+spt_weights(SubproductTreeObject *T)
+//
+// Compute winv[i] = 1/M'(x_i), by evaluating the derivative of the root product and
+// inverting all values with one field inversion. Return -1 with exception set if
+// the points are not distinct or the modulus is not irreducible.
+//
+{
+    const pk_reducer *R = T->R;
+    const int n = T->n;
+    uint64_t *w = malloc(2*n*sizeof(uint64_t));
+    uint64_t *winv = malloc(n*sizeof(uint64_t));
+    if(!w || !winv) {
+        free(w);
+        free(winv);
+        PyErr_NoMemory();
+        return -1;
+    }
+    uint64_t *prefix = w + n;
+
+    // M' has the odd coefficients of M, one step down
+    const uint64_t *m = T->m + T->moff[0];
+    uint64_t *d = ws_push_words(n);
+    for(int j=0; j<n; j++)
+        d[j] = (j & 1) ? 0 : m[j+1];
+    spt_eval(T, 0, 0, n, d, n, w);
+    ws_pop_words(d, n);
+
+    // Montgomery's trick: invert the product of all, then peel off one at a time
+    int err = 0;
+    uint64_t acc = 1;
+    for(int j=0; j<n && !err; j++) {
+        if(w[j] == 0)
+            err = 1;
+        prefix[j] = acc;
+        acc = pk_mulmod(R, acc, w[j]);
+    }
+    if(err) {
+        PyErr_SetString(PyExc_ValueError, "Interpolation points must be distinct");
+    } else if(field_inverse(T->field, &acc, &acc)) {
+        if(!PyErr_Occurred())
+            PyErr_SetString(PyExc_ValueError, "Point differences are not invertible, modulus is not irreducible");
+        err = 1;
+    } else {
+        for(int j=n-1; j>=0; j--) {
+            winv[j] = pk_mulmod(R, acc, prefix[j]);
+            acc = pk_mulmod(R, acc, w[j]);
+        }
+    }
+    free(w);
+    if(err) {
+        free(winv);
+        return -1;
+    }
+    T->winv = winv;
+    return 0;
+}
+
+//
+// Python object
+//
+
+static uint64_t *
+spt_elements(FieldObject *F, PyObject *values, int *n)
+//
+// The field elements of an iterable of *n integers or elements of F, malloc'ed,
+// or NULL with exception set. With *n < 0 any non-zero length is accepted, and
+// returned in *n.
+//
+{
+    PyObject *seq = PySequence_Fast(values, "Expected a sequence of field elements");
+    if(seq == NULL)
+        return NULL;
+    const Py_ssize_t len = PySequence_Fast_GET_SIZE(seq);
+    uint64_t *v = NULL;
+    if(*n >= 0 && len != *n) {
+        PyErr_Format(PyExc_ValueError, "Expected %d values, got %zd", *n, len);
+    } else if(len == 0) {
+        PyErr_SetString(PyExc_ValueError, "At least one point is required");
+    } else if(!pk_fits(len+1, F->n)) {
+        PyErr_SetString(PyExc_ValueError, "Too many points");
+    } else if((v = malloc(len*sizeof(uint64_t))) == NULL) {
+        PyErr_NoMemory();
+    } else {
+        for(Py_ssize_t i=0; i<len; i++) {
+            FieldElementObject *e = field_coerce(F, PySequence_Fast_GET_ITEM(seq, i));
+            if(e == NULL) {
+                if(!PyErr_Occurred())
+                    PyErr_SetString(PyExc_TypeError, "Values must be integers or field elements");
+                free(v);
+                v = NULL;
+                break;
+            }
+            v[i] = e->v[0];
+            Py_DECREF(e);
+        }
+        if(v)
+            *n = (int)len;
+    }
+    Py_DECREF(seq);
+    return v;
+}
+
+static PyObject *
+spt_new(PyTypeObject *type, PyObject *args, PyObject *kwds)
+//
+// SubproductTree(field, points)
+//
+{
+    static char *kwlist[] = {"field", "points", NULL};
+    FieldObject *F;
+    PyObject *points;
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "O!O", kwlist, &FieldType, &F, &points))
+        return NULL;
+    if(F->n > PK_MAX_K) {
+        PyErr_SetString(PyExc_ValueError, "Field degree must be at most 64");
+        return NULL;
+    }
+
+    SubproductTreeObject *T = (SubproductTreeObject *)type->tp_alloc(type, 0);
+    if(T == NULL)
+        return NULL;
+    Py_INCREF(F);
+    T->field = F;
+    int n = -1;
+    T->x = spt_elements(F, points, &n);
+    if(T->x == NULL) {
+        Py_DECREF(T);
+        return NULL;
+    }
+    T->n = n;
+
+    T->R = malloc(sizeof(pk_reducer));
+    T->moff = malloc((2*n-1)*sizeof(int));
+    T->goff = malloc((2*n-1)*sizeof(int));
+    if(!T->R || !T->moff || !T->goff) {
+        Py_DECREF(T);
+        return PyErr_NoMemory();
+    }
+    pk_reducer_init(T->R, F->f[0], F->n);
+    int nm = 0;
+    int ng = 0;
+    spt_layout(T, 0, 0, n, &nm, &ng, 0);
+    T->m = malloc(nm*sizeof(uint64_t));
+    T->g = malloc(GF2X_MAX(ng, 1)*sizeof(uint64_t));
+    if(!T->m || !T->g) {
+        Py_DECREF(T);
+        return PyErr_NoMemory();
+    }
+    spt_build(T, 0, 0, n);
+    return (PyObject *)T;
+}
+
+static void
+spt_dealloc(SubproductTreeObject *self)
+{
+    free(self->x);
+    free(self->m);
+    free(self->moff);
+    free(self->g);
+    free(self->goff);
+    free(self->winv);
+    free(self->R);
+    Py_XDECREF(self->field);
+    Py_TYPE(self)->tp_free((PyObject *)self);
+}
+
+static PyObject *
+spt_evaluate(SubproductTreeObject *self, PyObject *a)
+//
+// Values of the packed polynomial a at all points, as a list of integers
+//
+{
+    const pk_reducer *R = self->R;
+    const int n = self->n;
+    if(!PyLong_Check(a)) {
+        PyErr_SetString(PyExc_TypeError, "Polynomial must be a packed integer");
+        return NULL;
+    }
+    if(pk_check_packed(a, R->k))
+        return NULL;
+    int nc;
+    uint64_t *c = pk_unpack_pylong(a, R->k, &nc);
+    uint64_t *v = malloc(n*sizeof(uint64_t));
+    if(!c || !v) {
+        free(c);
+        free(v);
+        return c ? PyErr_NoMemory() : NULL;
+    }
+
+    if(nc > n) {
+        // Reduce modulo the root, with its inverse for this length
+        const uint64_t *m = self->m + self->moff[0];
+        uint64_t *g = ws_push_words(nc - n);
+        uint64_t *r = ws_push_words(n);
+        spt_inverse_rev(R, g, nc - n, m, n);
+        spt_rem(R, r, c, nc, m, n, g);
+        spt_eval(self, 0, 0, n, r, n, v);
+        ws_pop_words(r, n);
+        ws_pop_words(g, nc - n);
+    } else {
+        spt_eval(self, 0, 0, n, c, nc, v);
+    }
+
+    PyObject *l = PyList_New(n);
+    for(int j=0; l && j<n; j++) {
+        PyObject *o = PyLong_FromUnsignedLongLong(v[j]);
+        if(o == NULL)
+            Py_CLEAR(l);
+        else
+            PyList_SET_ITEM(l, j, o);
+    }
+    free(c);
+    free(v);
+    return l;
+}
+
+static PyObject *
+spt_interpolate(SubproductTreeObject *self, PyObject *values)
+//
+// The packed polynomial of degree < n with the given values at the n points
+//
+{
+    const pk_reducer *R = self->R;
+    int n = self->n;
+    if(!self->winv && spt_weights(self))
+        return NULL;
+    uint64_t *c = spt_elements(self->field, values, &n);
+    if(c == NULL)
+        return NULL;
+    for(int j=0; j<n; j++)
+        c[j] = pk_mulmod(R, c[j], self->winv[j]);
+    uint64_t *r = ws_push_words(n);
+    spt_combine(self, 0, 0, n, c, r);
+    PyObject *p = pk_pack_pylong(r, n, R->k);
+    ws_pop_words(r, n);
+    free(c);
+    return p;
+}
+
+static Py_ssize_t
+spt_length(SubproductTreeObject *self)
+{
+    return self->n;
+}
+
+static PyObject *
+spt_get_field(SubproductTreeObject *self, void *closure)
+{
+    (void)closure;
+    Py_INCREF(self->field);
+    return (PyObject *)self->field;
+}
+
+static PyObject *
+spt_get_product(SubproductTreeObject *self, void *closure)
+{
+    (void)closure;
+    return pk_pack_pylong(self->m + self->moff[0], self->n + 1, self->field->n);
+}
+
+static PyMethodDef spt_methods[] =
+    {
+        {
+            "evaluate",
+            (PyCFunction)spt_evaluate,
+            METH_O,
+            "Values of a packed polynomial at all points, as a list of integers"
+        },
+        {
+            "interpolate",
+            (PyCFunction)spt_interpolate,
+            METH_O,
+            "Packed polynomial of degree less than the number of points, with the given values at the points"
+        },
+        {NULL, NULL, 0, NULL}
+    };
+
+static PyGetSetDef spt_getset[] =
+    {
+        {"field", (getter)spt_get_field, NULL, "The field of the points", NULL},
+        {"product", (getter)spt_get_product, NULL, "Product of (y + x) over all points x, packed", NULL},
+        {NULL, NULL, NULL, NULL, NULL}
+    };
+
+static PySequenceMethods spt_as_sequence =
+    {
+        .sq_length = (lenfunc)spt_length,
+    };
+
+static PyTypeObject SubproductTreeType =
+    {
+        PyVarObject_HEAD_INIT(NULL, 0)
+        .tp_name = "pygf2x.SubproductTree",
+        .tp_basicsize = sizeof(SubproductTreeObject),
+        .tp_itemsize = 0,
+        .tp_dealloc = (destructor)spt_dealloc,
+        .tp_as_sequence = &spt_as_sequence,
+        .tp_flags = Py_TPFLAGS_DEFAULT,
+        .tp_doc = "SubproductTree(field, points)\n"
+                  "Multipoint evaluation and interpolation at the given points of a Field of degree\n"
+                  "at most 64. Polynomials over the field are packed integers, see pygf2x.pack.",
+        .tp_methods = spt_methods,
+        .tp_getset = spt_getset,
+        .tp_new = spt_new,
+    };
@@ -0,0 +1,282 @@
+/* -*- mode: c; c-basic-offset: 4; -*- */
+/*******************************************************************************
+ *
+ * Copyright (c) 2021 Oskar Enoksson. All rights reserved.
+ * Licensed under the MIT license. See LICENSE file in the project root for details.
+ *
+ * Description:
+ * Measurement of the thresholds between algorithms on the running host
+ *
+ * Each threshold is chosen among a few candidates, by timing the affected kernel
+ * over a range of operand sizes and picking the candidate with the smallest sum of
+ * times relative to the fastest candidate at each size. Each time is the median of
+ * a few runs, each repeated for at least TUNE_MIN_TIME seconds.
+ *
+ *******************************************************************************/
+
+#include <time.h>
+
+#define TUNE_SAMPLES 5
+#define TUNE_MIN_TIME 0.001
+
+typedef struct {
+    int ndigs_l, ndigs_r;      // Factors l and r for mul_nl_nr
+    int nbits_u, nbits_d;      // Numerator l and denominator d for divmod_digits
+    const digit *l, *r, *d;
+    digit *p, *q;
+    const uint64_t *s;         // Sequence of nbits_u bits for berlekamp_massey
+    uint64_t *c;
+} tune_args;
+
+static double
+tune_now(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + 1e-9*t.tv_nsec;
+}
+
+static void
+tune_mul(tune_args *x)
+{
+    memset(x->p, 0, (x->ndigs_l + x->ndigs_r)*sizeof(digit));
+    mul_nl_nr(x->p, x->l, x->ndigs_l, x->r, x->ndigs_r);
+}
+
+static void
+tune_operand(digit *dst, const digit *src, int nbits)
+//
+// Copy src truncated to exactly nbits bits
+//
+{
+    const int ndigs = (nbits + (PyLong_SHIFT-1))/PyLong_SHIFT;
+    memcpy(dst, src, ndigs*sizeof(digit));
+    dst[ndigs-1] &= ((digit)1 << ((nbits-1) % PyLong_SHIFT + 1)) - 1;
+    dst[ndigs-1] |= (digit)1 << ((nbits-1) % PyLong_SHIFT);
+}
+
+static void
+tune_divmod(tune_args *x)
+{
+    tune_operand(x->p, x->l, x->nbits_u);
+    memset(x->q, 0, ((x->nbits_u - x->nbits_d + 1 + (PyLong_SHIFT-1))/PyLong_SHIFT)*sizeof(digit));
+    divmod_digits(x->q, x->p, x->d, x->nbits_u, x->nbits_d, DIVMOD_Q | DIVMOD_R);
+}
+
+static void
+tune_berlekamp_massey(tune_args *x)
+{
+    berlekamp_massey(x->c, x->s, x->nbits_u);
+}
+
+static int
+tune_cmp(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static double
+tune_time(void (*kernel)(tune_args *), tune_args *x)
+//
+// Median time of one call
+//
+{
+    long n = 1;
+    for(;;) {
+        double t0 = tune_now();
+        for(long i=0; i<n; i++)
+            kernel(x);
+        if(tune_now() - t0 >= TUNE_MIN_TIME)
+            break;
+        n *= 2;
+    }
+    double t[TUNE_SAMPLES];
+    for(int s=0; s<TUNE_SAMPLES; s++) {
+        double t0 = tune_now();
+        for(long i=0; i<n; i++)
+            kernel(x);
+        t[s] = (tune_now() - t0)/n;
+    }
+    qsort(t, TUNE_SAMPLES, sizeof(double), tune_cmp);
+    return t[TUNE_SAMPLES/2];
+}
+
+static int
+tune_select(int *threshold, const int *candidates, int ncandidates,
+            void (*kernel)(tune_args *), tune_args *sizes, int nsizes)
+//
+// Set *threshold to the best of the candidates for the given operand sizes
+//
+{
+    double *t = malloc(ncandidates*nsizes*sizeof(double));
+    if(t == NULL)
+        return -1;
+    for(int c=0; c<ncandidates; c++) {
+        *threshold = candidates[c];
+        for(int s=0; s<nsizes; s++)
+            t[c*nsizes + s] = tune_time(kernel, &sizes[s]);
+    }
+    int best = 0;
+    double best_score = 0;
+    for(int c=0; c<ncandidates; c++) {
+        double score = 0;
+        for(int s=0; s<nsizes; s++) {
+            double t_min = t[s];
+            for(int c2=1; c2<ncandidates; c2++)
+                t_min = GF2X_MIN(t_min, t[c2*nsizes + s]);
+            score += t[c*nsizes + s]/t_min;
+        }
+        if(c == 0 || score < best_score) {
+            best = c;
+            best_score = score;
+        }
+    }
+    *threshold = candidates[best];
+    free(t);
+    return 0;
+}
+
+static PyObject *
+pygf2x_tune(PyObject *self, PyObject *args)
+//
+// Measure and set all thresholds, and return them as by get_thresholds
+//
+{
+    (void)args;
+    const int max_ndigs = 16384/PyLong_SHIFT;
+    digit *buf = malloc(5*max_ndigs*sizeof(digit));
+    if(buf == NULL)
+        return PyErr_NoMemory();
+    digit * const l = buf;
+    digit * const r = l + max_ndigs;
+    digit * const d = r + max_ndigs;
+    digit * const p = d + max_ndigs;
+    digit * const q = p + max_ndigs;
+    uint32_t seed = 1234567890;
+    for(int i=0; i<2*max_ndigs; i++) {
+        seed ^= seed << 13;
+        seed ^= seed >> 17;
+        seed ^= seed << 5;
+        l[i] = seed & PyLong_MASK;
+    }
+#define TUNE_NELEMS(a) ((int)(sizeof(a)/sizeof((a)[0])))
+    int ret = 0;
+
+    // Schoolbook vs Karatsuba multiplication
+    {
+        static const int candidates[] = {2, 3, 4, 6, 8, 12, 16, 24, 32, 48, 64};
+        tune_args sizes[] = {
+            {.ndigs_l = 4, .ndigs_r = 4},
+            {.ndigs_l = 8, .ndigs_r = 8},
+            {.ndigs_l = 16, .ndigs_r = 16},
+            {.ndigs_l = 32, .ndigs_r = 32},
+            {.ndigs_l = 64, .ndigs_r = 64},
+            {.ndigs_l = 128, .ndigs_r = 128},
+        };
+        for(int s=0; s<TUNE_NELEMS(sizes); s++) {
+            sizes[s].l = l;
+            sizes[s].r = r;
+            sizes[s].p = p;
+        }
+        ret |= tune_select(&karatsuba_limit, candidates, TUNE_NELEMS(candidates),
+                           tune_mul, sizes, TUNE_NELEMS(sizes));
+    }
+
+    // Chunked Karatsuba vs Toom-(4,2) for factors of a length ratio of 8, by the length of
+    // the shorter one. The threshold is lowered for as long as Toom is faster.
+    {
+        static const int ndigs[] = {256, 192, 128, 96, 64, 48, 32, 24, 16, 12, 8, 6, 4};
+        const int nl_max = 8*ndigs[0];
+        digit *w = malloc((2*nl_max + ndigs[0])*sizeof(digit));
+        if(w == NULL) {
+            ret = -1;
+        } else {
+            for(int i=0; i<nl_max; i++) {
+                seed ^= seed << 13;
+                seed ^= seed >> 17;
+                seed ^= seed << 5;
+                w[i] = seed & PyLong_MASK;
+            }
+            int limit = 0;
+            for(int i=0; i<TUNE_NELEMS(ndigs); i++) {
+                tune_args x = {.ndigs_l = 8*ndigs[i], .ndigs_r = ndigs[i], .l = w, .r = r, .p = w + nl_max};
+                toom_limit = ndigs[i];
+                double t_toom = tune_time(tune_mul, &x);
+                toom_limit = 0;
+                double t_chunks = tune_time(tune_mul, &x);
+                if(t_toom >= t_chunks)
+                    break;
+                limit = ndigs[i];
+            }
+            toom_limit = limit;
+            free(w);
+        }
+    }
+
+    // Bitwise vs word or Newton division, by small denominators. The threshold is raised for
+    // as long as bitwise division is faster.
+    {
+        static const int nbits[] = {4, 8, 16, 32, 64, 128, 256};
+        int limit = 0;
+        for(int i=0; i<TUNE_NELEMS(nbits); i++) {
+            tune_args x = {.nbits_u = 1024, .nbits_d = nbits[i], .l = l, .d = d, .p = p, .q = q};
+            tune_operand(d, r, nbits[i]);
+            div_bitwise_limit = nbits[i] + 1;
+            double t_bitwise = tune_time(tune_divmod, &x);
+            div_bitwise_limit = 0;
+            double t_newton = tune_time(tune_divmod, &x);
+            if(t_bitwise >= t_newton)
+                break;
+            limit = nbits[i] + 1;
+        }
+        div_bitwise_limit = limit;
+    }
+
+    // Size of the inverse used in each step of Newton division
+    if(ret == 0) {
+        static const int candidates[] = {0, 2, 4, 8, 16, 32, 64};
+        tune_args sizes[] = {
+            {.nbits_u = 3960, .nbits_d = 990},
+            {.nbits_u = 15960, .nbits_d = 3990},
+            {.nbits_u = 15960, .nbits_d = 12000},
+        };
+        // The denominators are the leading digits of one 12000-bit operand, which is
+        // why their sizes are multiples of 30 bits
+        tune_operand(d, r, 12000);
+        for(int s=0; s<TUNE_NELEMS(sizes); s++) {
+            sizes[s].l = l;
+            sizes[s].d = d + (12000 - sizes[s].nbits_d)/PyLong_SHIFT;
+            sizes[s].p = p;
+            sizes[s].q = q;
+        }
+        ret |= tune_select(&div_inverse_limit, candidates, TUNE_NELEMS(candidates),
+                           tune_divmod, sizes, TUNE_NELEMS(sizes));
+    }
+
+    // Plain vs recursive Berlekamp-Massey
+    if(ret == 0) {
+        static const int candidates[] = {256, 512, 1024, 2048, 4096};
+        const int nw = 16384/64;
+        uint64_t *w = malloc(2*(nw + 1)*sizeof(uint64_t));
+        if(w == NULL) {
+            ret = -1;
+        } else {
+            fw_from_digits(w, nw, l, max_ndigs);
+            tune_args sizes[] = {
+                {.nbits_u = 4096, .s = w, .c = w + nw},
+                {.nbits_u = 8192, .s = w, .c = w + nw},
+                {.nbits_u = 16384, .s = w, .c = w + nw},
+            };
+            ret |= tune_select(&bm_recursive_limit, candidates, TUNE_NELEMS(candidates),
+                               tune_berlekamp_massey, sizes, TUNE_NELEMS(sizes));
+            free(w);
+        }
+    }
+#undef TUNE_NELEMS
+
+    free(buf);
+    if(ret < 0)
+        return PyErr_NoMemory();
+    return pygf2x_get_thresholds(self, NULL);
+}
@@ -0,0 +1,82 @@
+/* -*- mode: c; c-basic-offset: 4; -*- */
+/*******************************************************************************
+ *
+ * Copyright (c) 2021 Oskar Enoksson. All rights reserved.
+ * Licensed under the MIT license. See LICENSE file in the project root for details.
+ *
+ * Description:
+ * Reusable scratch memory for the kernels
+ *
+ * Scratch digits are taken from one module-wide buffer as a stack: ws_push and
+ * ws_pop must be paired in reverse order. If the buffer is too small, the request is
+ * served from the heap instead, and the buffer is grown to the largest demand seen
+ * the next time it is empty, i.e. on the next call from Python. Repeated operations
+ * of similar size therefore run without any malloc after the first one.
+ *
+ * The kernels run with the GIL held and never call back into Python, so one buffer
+ * is enough.
+ *
+ *******************************************************************************/
+
+#define WS_MAX_DIGITS ((1 << 20)/(Py_ssize_t)sizeof(digit))  // Larger demands are not kept
+
+static struct {
+    digit *buf;
+    Py_ssize_t size;        // Digits allocated
+    Py_ssize_t used;        // Digits pushed within buf
+    Py_ssize_t demand;      // Digits pushed, including those served from the heap
+    Py_ssize_t peak;        // Largest demand, up to WS_MAX_DIGITS
+} pygf2x_ws;
+
+static digit *
+ws_push(Py_ssize_t ndigs)
+//
+// Take ndigs scratch digits, to be released by ws_pop
+//
+{
+    if(pygf2x_ws.demand == 0 && pygf2x_ws.size < pygf2x_ws.peak) {
+        digit *buf = stats_malloc(pygf2x_ws.peak*sizeof(digit));
+        if(buf) {
+            free(pygf2x_ws.buf);
+            pygf2x_ws.buf = buf;
+            pygf2x_ws.size = pygf2x_ws.peak;
+        }
+    }
+    pygf2x_ws.demand += ndigs;
+    if(pygf2x_ws.demand <= WS_MAX_DIGITS)
+        pygf2x_ws.peak = GF2X_MAX(pygf2x_ws.peak, pygf2x_ws.demand);
+    if(pygf2x_ws.size - pygf2x_ws.used < ndigs)
+        return stats_malloc(ndigs*sizeof(digit));
+    digit *p = pygf2x_ws.buf + pygf2x_ws.used;
+    pygf2x_ws.used += ndigs;
+    return p;
+}
+
+static void
+ws_pop(digit *p, Py_ssize_t ndigs)
+//
+// Release the ndigs digits at p, which must be the latest ws_push not yet released
+//
+{
+    pygf2x_ws.demand -= ndigs;
+    if(pygf2x_ws.used >= ndigs && p == pygf2x_ws.buf + (pygf2x_ws.used - ndigs))
+        pygf2x_ws.used -= ndigs;
+    else
+        free(p);
+}
+
+static inline uint64_t *
+ws_push_words(Py_ssize_t nwords)
+//
+// Take scratch for nwords 64-bit words, to be released by ws_pop_words. They are
+// aligned as long as everything pushed below them is whole words.
+//
+{
+    return (uint64_t *)ws_push(nwords*(Py_ssize_t)(sizeof(uint64_t)/sizeof(digit)));
+}
+
+static inline void
+ws_pop_words(uint64_t *p, Py_ssize_t nwords)
+{
+    ws_pop((digit *)p, nwords*(Py_ssize_t)(sizeof(uint64_t)/sizeof(digit)));
+}
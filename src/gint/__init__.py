@@ -10,3 +10,6 @@
 
 from .base import gint
 
+from . import tuning
+
+tuning.load()
@@ -40,12 +40,12 @@ class gint(int):
     def __truediv__(self,value):
         if not isinstance(value, gint):
             raise TypeError('Cannot divide gint with %s'%type(value).__name__)
-        return gint(pygf2x.divmod(self,value)[0])
+        return gint(pygf2x.div(self,value))
 
     def __rtruediv__(self,value):
         if not isinstance(value, gint):
             raise TypeError('Cannot divide %s with gint'%type(value).__name__)
-        return gint(pygf2x.divmod(self,value)[0])
+        return gint(pygf2x.div(value,self))
 
     def __floordiv__(self,value):
         raise TypeError("Don't use // with gint")
@@ -66,12 +66,12 @@ class gint(int):
     def __mod__(self, value):
         if not isinstance(value, gint):
             raise TypeError('Cannot modulo gint with %s'%type(value).__name__)
-        return gint(pygf2x.divmod(self,value)[1])
+        return gint(pygf2x.mod(self,value))
 
     def __rmod__(self, value):
         if not isinstance(value, gint):
             raise TypeError('Cannot modulo %s with gint'%type(value).__name__)
-        return gint(pygf2x.divmod(value,self)[1])
+        return gint(pygf2x.mod(value,self))
 
     def __add__(self,value):
         if not isinstance(value, gint):
@@ -177,8 +177,8 @@ class gint(int):
         return gint(pygf2x.inv(self, nbits))
 
     def rinv(self, nbits):
-        ''' Multiplicative inverse of x, with nbits precision, i.e. 
-        x*inv(x) = (r<<(nbits-1)) + 1, where r.bit_length() < nbits
+        ''' Multiplicative inverse of odd x modulo 1<<nbits, i.e.
+        x*rinv(x) = (r<<nbits) + 1
         '''
         return gint(pygf2x.rinv(self, nbits))
 
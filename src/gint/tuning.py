@@ -0,0 +1,82 @@
+################################################################################
+#
+# Copyright (c) 2021 Oskar Enoksson. All rights reserved.
+# Licensed under the MIT license. See LICENSE file in the project root for details.
+#
+# Description:
+#
+# Persistent per-host thresholds between the algorithms of pygf2x
+#
+# The thresholds measured by pygf2x.tune() are stored as JSON, in the file named by
+# the environment variable GINT_TUNING_FILE, or by default in
+# $XDG_CONFIG_HOME/gint/tuning.json (~/.config/gint/tuning.json). The file holds one
+# entry per backend and digit size, so that differently built extensions on the same
+# host do not share thresholds. The entry matching the loaded extension is applied
+# when gint is imported. Set GINT_TUNING_FILE to an empty string to disable this.
+#
+################################################################################
+
+import json
+import os
+import sys
+
+import pygf2x
+
+def tuning_file():
+    ''' Path of the tuning file, or None if disabled '''
+    path = os.environ.get('GINT_TUNING_FILE')
+    if path is not None:
+        return path or None
+    config = os.environ.get('XDG_CONFIG_HOME') or os.path.join(os.path.expanduser('~'), '.config')
+    return os.path.join(config, 'gint', 'tuning.json')
+
+def _key():
+    return '%s-%d' % (pygf2x.BACKEND, sys.int_info.bits_per_digit)
+
+def _read(path):
+    try:
+        with open(path) as f:
+            entries = json.load(f)
+    except (OSError, ValueError):
+        return {}
+    return entries if isinstance(entries, dict) else {}
+
+def load(path=None):
+    ''' Apply the stored thresholds for this extension, if there are any.
+    Return the applied thresholds, or None if there were none or they were invalid.
+    '''
+    path = path or tuning_file()
+    if path is None:
+        return None
+    thresholds = _read(path).get(_key())
+    if not isinstance(thresholds, dict):
+        return None
+    try:
+        pygf2x.set_thresholds(thresholds)
+    except (KeyError, TypeError, ValueError, OverflowError):
+        return None
+    return pygf2x.get_thresholds()
+
+def save(thresholds=None, path=None):
+    ''' Store thresholds (default the current ones) for this extension '''
+    path = path or tuning_file()
+    if path is None:
+        raise ValueError('Tuning file is disabled by GINT_TUNING_FILE')
+    entries = _read(path)
+    entries[_key()] = thresholds if thresholds is not None else pygf2x.get_thresholds()
+    directory = os.path.dirname(path)
+    if directory:
+        os.makedirs(directory, exist_ok=True)
+    tmp = path + '.tmp'
+    with open(tmp, 'w') as f:
+        json.dump(entries, f, indent=2, sort_keys=True)
+    os.replace(tmp, path)
+
+def tune(save_to_file=True, path=None):
+    ''' Measure the thresholds on this host, apply them, optionally store them, and
+    return them
+    '''
+    thresholds = pygf2x.tune()
+    if save_to_file:
+        save(thresholds, path)
+    return thresholds
@@ -0,0 +1,263 @@
+/* -*- mode: c; c-basic-offset: 4; -*- */
+/*******************************************************************************
+ *
+ * Copyright (c) 2021 Oskar Enoksson. All rights reserved.
+ * Licensed under the MIT license. See LICENSE file in the project root for details.
+ *
+ * Description:
+ * Benchmark of the C kernels, without the Python interpreter
+ *
+ * The extension source is included directly, so the kernels of whichever backend
+ * the compiler flags select are timed. Build and run from the project root with e.g.
+ *
+ *   gcc -O2 -Ic_ext $(python3-config --includes) tests/bench_kernels.c \
+ *       -o bench_kernels $(python3-config --ldflags --embed)
+ *   ./bench_kernels --format json > generic.json
+ *
+ * and add -mpclmul -msse4.1 (x86) or -march=armv8-a+crypto (ARM) for the CLMUL
+ * backends. Every kernel is run over a sweep of operand sizes. For each size the
+ * repetition count is calibrated to run for at least --min-time seconds, a few
+ * warmup runs are made, and the median of --samples runs is reported as ns (and
+ * on x86 also TSC cycles) per call.
+ *
+ * Options:
+ *   --format csv|json   Output format (default csv)
+ *   --max-bits N        Largest operand size in bits (default 100000)
+ *   --samples N         Timed runs per size (default 11)
+ *   --min-time T        Minimum duration of one run in seconds (default 0.002)
+ *   --kernel NAME       Only run kernels whose name contains NAME
+ *
+ *******************************************************************************/
+
+#include "../c_ext/pygf2x.c"
+
+#include <time.h>
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <x86intrin.h>
+#define BENCH_HAVE_TSC
+#endif
+
+#define BENCH_WARMUP 3
+#define BENCH_MAX_SAMPLES 101
+
+typedef struct {
+    int ndigs;         // Operand size
+    digit *a, *b;      // Operands
+    digit *p;          // Result, 2*ndigs+1 digits
+    digit *q;          // Quotient, ndigs+1 digits
+} bench_args;
+
+typedef void (*bench_kernel)(bench_args *);
+
+static void
+bench_mul_nl_nr_IMPL(bench_args *x)
+{
+    memset(x->p, 0, 2*x->ndigs*sizeof(digit));
+    mul_nl_nr_IMPL(x->p, x->a, x->ndigs, x->b, x->ndigs);
+}
+
+static void
+bench_mul_nl_nr(bench_args *x)
+{
+    memset(x->p, 0, 2*x->ndigs*sizeof(digit));
+    mul_nl_nr(x->p, x->a, x->ndigs, x->b, x->ndigs);
+}
+
+static void
+bench_square_n(bench_args *x)
+{
+    memset(x->p, 0, 2*x->ndigs*sizeof(digit));
+    square_n(x->p, x->a, x->ndigs);
+}
+
+static void
+bench_inverse(bench_args *x)
+{
+    // Inverse with as many bits as the operand
+    int nbits_a = fw_digits_nbits(x->a, x->ndigs);
+    memset(x->p, 0, x->ndigs*sizeof(digit));
+    inverse(x->p, x->ndigs, nbits_a, x->a, x->ndigs, nbits_a);
+}
+
+static void
+bench_divmod(bench_args *x)
+{
+    // Numerator a*x^(n*PyLong_SHIFT) + b of 2n digits, by the n digit denominator a
+    int nbits_d = fw_digits_nbits(x->a, x->ndigs);
+    memcpy(x->p, x->b, x->ndigs*sizeof(digit));
+    memcpy(x->p + x->ndigs, x->a, x->ndigs*sizeof(digit));
+    memset(x->q, 0, (x->ndigs+1)*sizeof(digit));
+    divmod_digits(x->q, x->p, x->a, x->ndigs*PyLong_SHIFT + nbits_d, nbits_d, DIVMOD_Q | DIVMOD_R);
+}
+
+static const struct {
+    const char *name;
+    bench_kernel kernel;
+    int max_ndigs;     // Sizes above this are skipped, because the kernel is quadratic
+} bench_kernels[] = {
+    {"mul_nl_nr_IMPL", bench_mul_nl_nr_IMPL, 4096/PyLong_SHIFT},
+    {"mul_nl_nr", bench_mul_nl_nr, 0},
+    {"square_n", bench_square_n, 0},
+    {"inverse", bench_inverse, 0},
+    {"divmod", bench_divmod, 0},
+};
+
+static double
+bench_now(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + 1e-9*t.tv_nsec;
+}
+
+static uint64_t
+bench_tsc(void)
+{
+#ifdef BENCH_HAVE_TSC
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+static int
+bench_cmp(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static void
+bench_run(bench_kernel kernel, bench_args *x, int nsamples, double min_time,
+          double *ns, double *cycles, long *reps)
+//
+// Median time per call over nsamples timed runs of *reps calls each
+//
+{
+    // Calibrate the repetition count, doubling until one run takes min_time
+    long n = 1;
+    for(;;) {
+        double t0 = bench_now();
+        for(long i=0; i<n; i++)
+            kernel(x);
+        if(bench_now() - t0 >= min_time)
+            break;
+        n *= 2;
+    }
+    for(int w=0; w<BENCH_WARMUP; w++)
+        for(long i=0; i<n; i++)
+            kernel(x);
+
+    double t[BENCH_MAX_SAMPLES], c[BENCH_MAX_SAMPLES];
+    for(int s=0; s<nsamples; s++) {
+        uint64_t c0 = bench_tsc();
+        double t0 = bench_now();
+        for(long i=0; i<n; i++)
+            kernel(x);
+        double t1 = bench_now();
+        uint64_t c1 = bench_tsc();
+        t[s] = (t1 - t0)*1e9/n;
+        c[s] = (double)(c1 - c0)/n;
+    }
+    qsort(t, nsamples, sizeof(double), bench_cmp);
+    qsort(c, nsamples, sizeof(double), bench_cmp);
+    *ns = t[nsamples/2];
+    *cycles = c[nsamples/2];
+    *reps = n;
+}
+
+static void
+bench_random(digit *d, int ndigs)
+{
+    for(int i=0; i<ndigs; i++)
+        d[i] = ((digit)rand() ^ ((digit)rand() << 15)) & PyLong_MASK;
+    d[ndigs-1] |= (digit)1 << (PyLong_SHIFT-1);  // Full bit length
+    d[0] |= 1;                                   // Invertible
+}
+
+int
+main(int argc, char *argv[])
+{
+    const char *format = "csv";
+    const char *only = NULL;
+    int max_bits = 100000;
+    int nsamples = 11;
+    double min_time = 0.002;
+    for(int i=1; i<argc; i++) {
+        if(i+1 < argc && strcmp(argv[i], "--format") == 0)
+            format = argv[++i];
+        else if(i+1 < argc && strcmp(argv[i], "--max-bits") == 0)
+            max_bits = atoi(argv[++i]);
+        else if(i+1 < argc && strcmp(argv[i], "--samples") == 0)
+            nsamples = atoi(argv[++i]);
+        else if(i+1 < argc && strcmp(argv[i], "--min-time") == 0)
+            min_time = atof(argv[++i]);
+        else if(i+1 < argc && strcmp(argv[i], "--kernel") == 0)
+            only = argv[++i];
+        else {
+            fprintf(stderr, "Usage: %s [--format csv|json] [--max-bits N] [--samples N] [--min-time T] [--kernel NAME]\n", argv[0]);
+            return 2;
+        }
+    }
+    const bool json = strcmp(format, "json") == 0;
+    if((!json && strcmp(format, "csv") != 0) || nsamples < 1 || nsamples > BENCH_MAX_SAMPLES || max_bits < 1) {
+        fprintf(stderr, "Invalid option value\n");
+        return 2;
+    }
+
+    const int max_ndigs = (max_bits + (PyLong_SHIFT-1))/PyLong_SHIFT;
+    bench_args x = {
+        .a = malloc(max_ndigs*sizeof(digit)),
+        .b = malloc(max_ndigs*sizeof(digit)),
+        .p = malloc((2*max_ndigs+1)*sizeof(digit)),
+        .q = malloc((max_ndigs+1)*sizeof(digit)),
+    };
+    if(!x.a || !x.b || !x.p || !x.q) {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+    srand(1234567890);
+    bench_random(x.a, max_ndigs);
+    bench_random(x.b, max_ndigs);
+
+    if(json)
+        printf("{\n  \"backend\": \"%s\",\n  \"digit_bits\": %d,\n  \"karatsuba_limit\": %d,\n  \"results\": [",
+               PYGF2X_BACKEND, PyLong_SHIFT, karatsuba_limit);
+    else
+        printf("backend,digit_bits,kernel,bits,ns,cycles,reps\n");
+
+    bool first = true;
+    for(size_t k=0; k<sizeof(bench_kernels)/sizeof(bench_kernels[0]); k++) {
+        if(only && !strstr(bench_kernels[k].name, only))
+            continue;
+        // Sizes 1, 2, 3, 4, 6, 8, 12, 16, ... digits
+        for(int ndigs=1; ndigs<=max_ndigs; ndigs = (ndigs & (ndigs-1)) ? ndigs/3*4 : (ndigs < 2 ? 2 : ndigs/2*3)) {
+            if(bench_kernels[k].max_ndigs && ndigs > bench_kernels[k].max_ndigs)
+                break;
+            // Operands are the top ndigs digits, so that they keep their full bit length
+            bench_args xi = x;
+            xi.ndigs = ndigs;
+            xi.a += max_ndigs - ndigs;
+            xi.b += max_ndigs - ndigs;
+            double ns, cycles;
+            long reps;
+            bench_run(bench_kernels[k].kernel, &xi, nsamples, min_time, &ns, &cycles, &reps);
+            if(json)
+                printf("%s\n    {\"kernel\": \"%s\", \"bits\": %d, \"ns\": %.1f, \"cycles\": %.0f, \"reps\": %ld}",
+                       first ? "" : ",", bench_kernels[k].name, ndigs*PyLong_SHIFT, ns, cycles, reps);
+            else
+                printf("%s,%d,%s,%d,%.1f,%.0f,%ld\n",
+                       PYGF2X_BACKEND, PyLong_SHIFT, bench_kernels[k].name, ndigs*PyLong_SHIFT, ns, cycles, reps);
+            fflush(stdout);
+            first = false;
+        }
+    }
+    if(json)
+        printf("\n  ]\n}\n");
+
+    free(x.a);
+    free(x.b);
+    free(x.p);
+    free(x.q);
+    return 0;
+}
@@ -2,10 +2,16 @@
 
 import unittest
 import random
+import os
+import sys
+import json
+import functools
+import tempfile
 from random import randint,uniform
 
 import gint
 from gint import gint as gi
+from gint import tuning
 
 import pygf2x as gf2
 
@@ -64,11 +70,43 @@ class test_sqr(unittest.TestCase):
             x = randint(1<<30,(1<<60)-1)
             self.assertEqual(gf2.sqr(x),self.model_sqr(x))
 
+    def test_fixed_width(self):
+        for n in range(1,540):
+            f = randint(1<<(n-1), (1<<n)-1)
+            self.assertEqual(gf2.sqr(f), self.model_sqr(f), n)
+
     def test_1000(self):
         for n in range(0,100):
             x = randint(1,(1<<1000)-1)
             self.assertEqual(gf2.sqr(x),self.model_sqr(x))
 
+    def test_vector_widths(self):
+        # All digit counts across several vector widths, with the digit size of this build
+        shift = sys.int_info.bits_per_digit
+        for ndigs in range(1,80):
+            f = randint(1<<(ndigs*shift-1), (1<<(ndigs*shift))-1)
+            self.assertEqual(gf2.sqr(f), self.model_sqr(f), ndigs)
+            f = (1<<(ndigs*shift))-1
+            self.assertEqual(gf2.sqr(f), self.model_sqr(f), ndigs)
+
+    def test_into(self):
+        with self.assertRaises(TypeError):
+            gf2.sqr_into(3.14, bytearray(1))
+        with self.assertRaises(TypeError):
+            gf2.sqr_into(3, bytes(1))
+        with self.assertRaises(ValueError):
+            gf2.sqr_into(-1, bytearray(1))
+        with self.assertRaises(ValueError):
+            gf2.sqr_into(0x100, bytearray(2))
+        self.assertEqual(gf2.sqr_into(0, bytearray()), 0)
+        for n in (1,7,8,9,30,63,64,65,127,128,129,1000,3000):
+            f = randint(1<<(n-1), (1<<n)-1)
+            buf = bytearray(b'\xa5'*(n//4+3))
+            nbytes = gf2.sqr_into(f, buf)
+            self.assertEqual(nbytes, (2*n-1+7)//8, n)
+            self.assertEqual(int.from_bytes(buf[:nbytes],'little'), self.model_sqr(f), n)
+            self.assertEqual(buf[nbytes:], b'\xa5'*(len(buf)-nbytes), n)
+
             
 class test_mul(unittest.TestCase):
 
@@ -190,12 +228,244 @@ class test_mul(unittest.TestCase):
                 r = randint(1<<(nr-1), (1<<nr)-1)
                 self.assertEqual(gf2.mul(l,r),self.model_mul(l,r))
     
+    def test_fixed_width(self):
+        # Around the limits of the 64/128/256/512-bit kernels and the general code
+        sizes = (1,30,63,64,65,120,127,128,129,240,255,256,257,480,510,511,512,513,540)
+        for nl in sizes:
+            for nr in sizes:
+                l = randint(1<<(nl-1), (1<<nl)-1)
+                r = randint(1<<(nr-1), (1<<nr)-1)
+                self.assertEqual(gf2.mul(l,r),self.model_mul(l,r),(nl,nr))
+                self.assertEqual(gf2.mul(l,(1<<nr)-1),self.model_mul(l,(1<<nr)-1),(nl,nr))
+
     def test_1000_1000(self):
         for n in range(0,100):
             l = randint(1,(1<<1000)-1)
             r = randint(1,(1<<1000)-1)
             self.assertEqual(gf2.mul(l,r),self.model_mul(l,r))
 
+    def test_square(self):
+        # Same object, and equal but distinct objects
+        for n in (1,30,64,100,1000,5000):
+            l = randint(1<<(n-1), (1<<n)-1)
+            r = l + 0
+            self.assertEqual(gf2.mul(l,l),test_sqr.model_sqr(l),n)
+            self.assertEqual(gf2.mul(l,r),test_sqr.model_sqr(l),n)
+            self.assertEqual(gf2.mul(l,r^1),self.model_mul(l,r^1),n)
+
+    def test_unbalanced(self):
+        # Ratios of factor lengths on both sides of the Karatsuba splits and the chunking
+        saved = gf2.get_thresholds()
+        try:
+            for limit in (2, 5, saved['karatsuba_limit']):
+                gf2.set_thresholds({'karatsuba_limit':limit})
+                for nr in (61, 300, 1000):
+                    for ratio in (1.03, 1.1, 1.5, 1.9, 1.97, 2, 2.05, 3, 10):
+                        nl = int(nr*ratio)
+                        l = randint(1<<(nl-1), (1<<nl)-1)
+                        r = randint(1<<(nr-1), (1<<nr)-1)
+                        self.assertEqual(gf2.mul(l,r),self.model_mul(r,l),(limit,nl,nr))
+                        self.assertEqual(gf2.mul(r,l),self.model_mul(r,l),(limit,nl,nr))
+        finally:
+            gf2.set_thresholds(saved)
+
+    def test_toom(self):
+        # Unbalanced factors by Toom-(4,2), with and without a rest of the long factor
+        saved = gf2.get_thresholds()
+        try:
+            for limit in (1, 3, saved['toom_limit']):
+                gf2.set_thresholds({'toom_limit':limit})
+                for nr in (100, 1000, 5000):
+                    for ratio in (2, 2.1, 4, 4.3, 10):
+                        nl = int(nr*ratio)
+                        l = randint(1<<(nl-1), (1<<nl)-1)
+                        r = randint(1<<(nr-1), (1<<nr)-1)
+                        self.assertEqual(gf2.mul(l,r),self.model_mul(r,l),(limit,nl,nr))
+                        self.assertEqual(gf2.mul(r,l),self.model_mul(r,l),(limit,nl,nr))
+        finally:
+            gf2.set_thresholds(saved)
+
+    def test_sparse(self):
+        # Factors of low weight around the weight limit, on either side, and sparse moduli
+        saved = gf2.get_thresholds()
+        try:
+            for limit in (0, 1, saved['sparse_mul_limit'], 1000):
+                gf2.set_thresholds({'sparse_mul_limit':limit})
+                for n in (600, 1000, 5000, 20000):
+                    for w in (1, 2, 3, 5, 16, 17, 40, 200):
+                        l = randint(1<<(n-1), (1<<n)-1)
+                        r = sum(1<<randint(0, randint(0, n)) for i in range(w))
+                        self.assertEqual(gf2.mul(l,r),self.model_mul(r,l),(limit,n,w))
+                        self.assertEqual(gf2.mul(r,l),self.model_mul(r,l),(limit,n,w))
+                f = (1<<2000)|(1<<1500)|(1<<1200)|(1<<700)|(1<<3)|1
+                F = gf2.Field(f)
+                a, b = randint(0, (1<<2000)-1), randint(0, (1<<2000)-1)
+                self.assertEqual(int(F(a)*F(b)),gf2.mod(gf2.mul(a,b),f),limit)
+        finally:
+            gf2.set_thresholds(saved)
+
+
+class test_mullo(unittest.TestCase):
+
+    def test_args(self):
+        self.assertEqual(gf2.mullo(0,5,3),0)
+        self.assertEqual(gf2.mulhi(5,0,3),0)
+        self.assertEqual(gf2.mullo(7,7,0),0)
+        self.assertEqual(gf2.mulhi(7,7,0),0b10101)
+        self.assertEqual(gf2.mullo(7,7,3),0b101)
+        self.assertEqual(gf2.mulhi(7,7,3),0b10)
+        with self.assertRaises(TypeError):
+            gf2.mullo(1.0,1,1)
+        with self.assertRaises(ValueError):
+            gf2.mullo(-1,1,1)
+        with self.assertRaises(ValueError):
+            gf2.mulhi(1,1,-1)
+        with self.assertRaises(OverflowError):
+            gf2.mullo(too_large,too_large,1)
+
+    def test_random(self):
+        saved = gf2.get_thresholds()
+        try:
+            for limit in (2, 5, saved['karatsuba_limit']):
+                gf2.set_thresholds({'karatsuba_limit':limit})
+                for i in range(200):
+                    a = randint(0, 1<<randint(0, 5000))
+                    b = randint(0, 1<<randint(0, 5000))
+                    n = randint(0, 11000)
+                    p = gf2.mul(a,b)
+                    self.assertEqual(gf2.mullo(a,b,n), p & ((1<<n)-1), (limit, n))
+                    self.assertEqual(gf2.mulhi(a,b,n), p >> n, (limit, n))
+        finally:
+            gf2.set_thresholds(saved)
+
+
+class test_mul_batch(unittest.TestCase):
+
+    def test_args(self):
+        with self.assertRaises(TypeError):
+            gf2.mul_batch(1,[1])
+        with self.assertRaises(TypeError):
+            gf2.mul_batch([1,3.14],[1,1])
+        with self.assertRaises(ValueError):
+            gf2.mul_batch([1,-1],[1,1])
+        with self.assertRaises(ValueError):
+            gf2.mul_batch([1,2],[1])
+        with self.assertRaises(ValueError):
+            gf2.mul_batch([too_large],[1])
+        self.assertEqual(gf2.mul_batch([],[]),[])
+        self.assertEqual(gf2.mul_batch((0,1,3),[5,0,3]),[0,0,5])
+
+    def test_random(self):
+        # Batch sizes around the bit-sliced lane counts, mixed bit lengths
+        for n in (1,15,16,17,64,255,256,257,600):
+            for nbits in (1,7,64,65,300,1000,2100):
+                l = [randint(0,(1<<randint(0,nbits))-1) for i in range(n)]
+                r = [randint(0,(1<<randint(0,nbits))-1) for i in range(n)]
+                self.assertEqual(gf2.mul_batch(l,r),[test_mul.model_mul(a,b) for a,b in zip(l,r)],(n,nbits))
+
+    def test_mixed(self):
+        # Large operands interrupting runs of small ones
+        l = [randint(0,(1<<100)-1) for i in range(300)]
+        r = [randint(0,(1<<100)-1) for i in range(300)]
+        for i in (0,20,40,41,299):
+            l[i] = randint(1<<3000,1<<3001)
+        self.assertEqual(gf2.mul_batch(l,r),[gf2.mul(a,b) for a,b in zip(l,r)])
+
+
+class test_prod(unittest.TestCase):
+
+    def test_args(self):
+        with self.assertRaises(TypeError):
+            gf2.prod(1)
+        with self.assertRaises(TypeError):
+            gf2.prod([1,3.14])
+        with self.assertRaises(ValueError):
+            gf2.prod([1,-1])
+        with self.assertRaises(OverflowError):
+            gf2.prod([too_large,3])
+        self.assertEqual(gf2.prod([]),1)
+        self.assertEqual(gf2.prod([5]),5)
+        self.assertEqual(gf2.prod((3,0,too_large)),0)
+        self.assertEqual(gf2.prod(iter([3,3,1])),5)
+
+    def test_random(self):
+        # Equal and very unequal factor lengths, compared with a sequential product
+        for n in (2,3,7,64,300):
+            for nbits in (1,30,64,1000):
+                f = [randint(1,(1<<randint(1,nbits))-1) for i in range(n)]
+                if n < 64:
+                    f[randint(0,n-1)] = randint(1<<5000,1<<5001)
+                self.assertEqual(gf2.prod(f),functools.reduce(gf2.mul,f),(n,nbits))
+
+
+class test_multiplier(unittest.TestCase):
+
+    def test_args(self):
+        with self.assertRaises(TypeError):
+            gf2.Multiplier(1.0)
+        with self.assertRaises(ValueError):
+            gf2.Multiplier(-1)
+        with self.assertRaises(ValueError):
+            gf2.Multiplier(too_large)
+        M = gf2.Multiplier(7)
+        self.assertEqual(M.b,7)
+        with self.assertRaises(TypeError):
+            M.mul(1.0)
+        with self.assertRaises(ValueError):
+            M.mul(-1)
+        with self.assertRaises(ValueError):
+            M.mul(too_large)
+        with self.assertRaises(OverflowError):
+            M.mul(1<<(too_large.bit_length()-2))
+        with self.assertRaises(TypeError):
+            M.mul_many(7)
+        with self.assertRaises(ValueError):
+            M.mul_many([1,-1])
+        self.assertEqual(M.mul_many([]),[])
+        self.assertEqual(M.mul_many(iter((0,1,3))),[0,7,9])
+        self.assertEqual(gf2.Multiplier(0).mul(5),0)
+
+    def test_random(self):
+        # Around the block widths of b and beyond the longest blocked b, dense and sparse
+        for nb in (1,30,31,64,65,128,129,256,257,512,513,1000,4096,4097,16384,16385,20000):
+            for b in (randint(1<<(nb-1),(1<<nb)-1), (1<<(nb-1))|1):
+                M = gf2.Multiplier(b)
+                a = [randint(0,(1<<randint(0,n))-1) for n in (1,64,65,600,5000,40000)]
+                self.assertEqual(M.mul_many(a),[gf2.mul(x,b) for x in a],nb)
+                self.assertEqual(M.mul(a[2]),test_mul.model_mul(a[2],b),nb)
+
+    def test_toom(self):
+        # Long b with its Toom-(4,2) values kept, compared with mul by chunks
+        saved = gf2.get_thresholds()
+        try:
+            for nb in (5000, 20001, 40000):
+                b = randint(1<<(nb-1),(1<<nb)-1)
+                M = gf2.Multiplier(b)
+                a = [randint(1<<(n-1),(1<<n)-1) for n in (nb//2, 2*nb, int(4.3*nb), 10*nb)]
+                gf2.set_thresholds({'toom_limit':0})
+                p = [gf2.mul(x,b) for x in a]
+                for limit in (0, 1, 7, saved['toom_limit']):
+                    gf2.set_thresholds({'toom_limit':limit})
+                    self.assertEqual(M.mul_many(a),p,(nb,limit))
+        finally:
+            gf2.set_thresholds(saved)
+
+    def test_sparse(self):
+        # Sparse factors short enough for blocks, with and without the sparse kernel
+        saved = gf2.get_thresholds()
+        try:
+            for limit in (0, saved['sparse_mul_limit']):
+                gf2.set_thresholds({'sparse_mul_limit':limit})
+                for b in ((1<<16000)|1, (1<<3000)|(1<<1500)|(1<<7)|1, 0x11b):
+                    M = gf2.Multiplier(b)
+                    a = [randint(0,(1<<n)-1) for n in (64,5000,40000)] + [(1<<40000)|(1<<20)|1]
+                    self.assertEqual(M.mul_many(a),[test_mul.model_mul(x,b) for x in a],(limit,b))
+                M = gf2.Multiplier(randint(1<<999,(1<<1000)-1))
+                a = (1<<40000)|(1<<20000)|1
+                self.assertEqual(M.mul(a),test_mul.model_mul(a,M.b),limit)
+        finally:
+            gf2.set_thresholds(saved)
+
 
 class test_inv(unittest.TestCase):
     @staticmethod
@@ -297,6 +567,36 @@ class test_inv(unittest.TestCase):
             self.assertEqual((gi(gf2.inv(i,ne))*i)>>(ni-1), 1<<(ne-1))
             ne = ni+1
             self.assertEqual((gi(gf2.inv(i,ne))*i)>>(ni-1), 1<<(ne-1))
+
+
+    def test_rinv_args(self):
+        with self.assertRaises(TypeError):
+            gf2.rinv(3.0,1)
+        with self.assertRaises(ZeroDivisionError):
+            gf2.rinv(0,1)
+        with self.assertRaises(ValueError):
+            gf2.rinv(2,1)
+        with self.assertRaises(ValueError):
+            gf2.rinv(-1,1)
+        with self.assertRaises(ValueError):
+            gf2.rinv(1,0)
+        with self.assertRaises(ValueError):
+            gf2.rinv(too_large|1, 10)
+        with self.assertRaises(OverflowError):
+            gf2.rinv(1, too_large.bit_length())
+
+    def test_rinv(self):
+        for ni in range(1,200,7):
+            for ne in list(range(1,130)) + [500, 1000, 5000]:
+                i = randint(1<<(ni-1),(1<<ni)-1) | 1
+                e = gf2.rinv(i,ne)
+                self.assertLess(e.bit_length(), ne+1)
+                self.assertEqual(gf2.mul(e,i) & ((1<<ne)-1), 1, (ni,ne))
+        for ni in (1000, 10000, 100000):
+            i = randint(1<<(ni-1),(1<<ni)-1) | 1
+            for ne in (ni//3, ni, 3*ni+1):
+                e = gi(i).rinv(ne)
+                self.assertEqual((e*gi(i)) & ((1<<ne)-1), 1, (ni,ne))
             
 
 class test_div(unittest.TestCase):
@@ -504,6 +804,75 @@ class test_div(unittest.TestCase):
                 self.assertEqual(gf2.mul(q,d)^r,u,'divmod(%x,%x)'%(u,d))
                 self.assertTrue(r.bit_length() < d.bit_length(),'divmod(\n%x,\n%x)\n%d,%d\n%x'%(u,d,r.bit_length(),d.bit_length(),r))
             
+    def test_fixed_width(self):
+        for nd in range(1,130):
+            for nu in range(0,130,7):
+                u = randint(1<<nu>>1, (1<<nu)-1)
+                d = randint(1<<(nd-1), (1<<nd)-1)
+                self.assertEqual(gf2.divmod(u,d), self.model_divmod(u,d), 'divmod(%x,%x)'%(u,d))
+
+    def test_word(self):
+        # Denominators of at most 64 bits, with nibble and byte tables
+        for nd in range(2,67):
+            for nu in (nd+1,129,200,255,256,257,258,300,1000,5000):
+                nu = max(nu,nd)
+                u = randint(1<<(nu-1), (1<<nu)-1)
+                for d in (randint(1<<(nd-1), (1<<nd)-1), (1<<nd)-1, (1<<(nd-1))|1):
+                    q,r = gf2.divmod(u,d)
+                    self.assertEqual(gf2.mul(q,d)^r,u,'divmod(%x,%x)'%(u,d))
+                    self.assertTrue(r.bit_length() < d.bit_length(),'divmod(%x,%x)'%(u,d))
+
+    def test_references(self):
+        # The results are owned by the returned tuple only
+        for nu,nd in ((5000,100),(5000,4000),(5000,5000),(100,5000)):
+            u = randint(1<<(nu-1),(1<<nu)-1)
+            d = randint(1<<(nd-1),(1<<nd)-1)
+            q,r = gf2.divmod(u,d)
+            # Only q or r and the argument, unless shared small integers
+            if q > 256:
+                self.assertEqual(sys.getrefcount(q),2)
+            if r > 256:
+                self.assertEqual(sys.getrefcount(r),2)
+            self.assertEqual(gf2.mul(q,d)^r,u)
+
+    def test_div_mod(self):
+        # Quotient and remainder alone, as from divmod
+        for f in (gf2.div, gf2.mod):
+            with self.assertRaises(TypeError):
+                f(3.14,1)
+            with self.assertRaises(ValueError):
+                f(-10,5)
+            with self.assertRaises(ZeroDivisionError):
+                f(1<<200,0)
+        for nu,nd in ((0,1),(1,1),(100,1),(100,30),(100,64),(100,100),(5000,100),(5000,2500),
+                      (5000,2499),(5000,4000),(5000,5000),(100,5000),(20000,1000)):
+            for n in range(10):
+                u = randint(1<<nu>>1,(1<<nu)-1)
+                d = randint(1<<(nd-1),(1<<nd)-1)
+                q,r = gf2.divmod(u,d)
+                self.assertEqual(gf2.div(u,d),q,'div(%x,%x)'%(u,d))
+                self.assertEqual(gf2.mod(u,d),r,'mod(%x,%x)'%(u,d))
+
+    def test_divexact(self):
+        with self.assertRaises(TypeError):
+            gf2.divexact(3.14,1)
+        with self.assertRaises(ValueError):
+            gf2.divexact(-10,5)
+        with self.assertRaises(ZeroDivisionError):
+            gf2.divexact(10,0)
+        with self.assertRaises(ValueError):
+            gf2.divexact(0b101,0b10)
+        with self.assertRaises(ValueError):
+            gf2.divexact(1<<100,(1<<101)|(1<<100))
+        self.assertEqual(gf2.divexact(0,7),0)
+        for nq in (1,2,30,64,65,100,1000,5000):
+            for nd in (1,2,30,64,100,1000,5000):
+                for t in (0,1,31,100):
+                    q = randint(1<<(nq-1),(1<<nq)-1)
+                    d = randint(1<<(nd-1),(1<<nd)-1) | 1
+                    d <<= t
+                    self.assertEqual(gf2.divexact(gf2.mul(q,d),d),q,'divexact(%x,%x)'%(gf2.mul(q,d),d))
+
     def test_10000_100(self):
         for n in range(0,100):
             u = randint(0,(1<<10000)-1)
@@ -522,5 +891,779 @@ class test_div(unittest.TestCase):
             self.assertTrue(r.bit_length() < d.bit_length())
 
 
+class test_thresholds(unittest.TestCase):
+
+    def setUp(self):
+        self.saved = gf2.get_thresholds()
+
+    def tearDown(self):
+        gf2.set_thresholds(self.saved)
+
+    def test_args(self):
+        self.assertEqual(sorted(self.saved),['bm_recursive_limit','div_bitwise_limit','div_inverse_limit','karatsuba_limit','sparse_mul_limit','toom_limit'])
+        with self.assertRaises(TypeError):
+            gf2.set_thresholds(1)
+        with self.assertRaises(KeyError):
+            gf2.set_thresholds({'no_such_limit':1})
+        with self.assertRaises(TypeError):
+            gf2.set_thresholds({'karatsuba_limit':2.5})
+        with self.assertRaises(ValueError):
+            gf2.set_thresholds({'karatsuba_limit':1})
+        with self.assertRaises(ValueError):
+            gf2.set_thresholds({'div_bitwise_limit':1, 'div_inverse_limit':-1})
+        self.assertEqual(gf2.get_thresholds(),self.saved)
+        gf2.set_thresholds({'karatsuba_limit':7})
+        self.assertEqual(gf2.get_thresholds()['karatsuba_limit'],7)
+
+    def test_mul(self):
+        for limit in (2,3,5,1000):
+            gf2.set_thresholds({'karatsuba_limit':limit})
+            for n in range(20):
+                l = randint(1,(1<<randint(1,3000))-1)
+                r = randint(1,(1<<randint(1,3000))-1)
+                self.assertEqual(gf2.mul(l,r),test_mul.model_mul(l,r),limit)
+
+    def test_divmod(self):
+        for bitwise,inverse in ((0,1),(0,3),(100,0),(10000,0)):
+            gf2.set_thresholds({'div_bitwise_limit':bitwise, 'div_inverse_limit':inverse})
+            for n in range(20):
+                u = randint(1,(1<<randint(1,3000))-1)
+                d = randint(1,(1<<randint(1,1500))-1)
+                q,r = test_div.model_divmod(u,d)
+                self.assertEqual(gf2.divmod(u,d),(q,r),(bitwise,inverse))
+                self.assertEqual(gf2.div(u,d),q,(bitwise,inverse))
+                self.assertEqual(gf2.mod(u,d),r,(bitwise,inverse))
+
+    def test_tune(self):
+        thresholds = gf2.tune()
+        self.assertEqual(thresholds,gf2.get_thresholds())
+        self.assertEqual(sorted(thresholds),sorted(self.saved))
+
+    def test_file(self):
+        with tempfile.TemporaryDirectory() as d:
+            path = os.path.join(d,'sub','tuning.json')
+            self.assertIsNone(tuning.load(path))
+            tuning.save({'karatsuba_limit':5, 'div_bitwise_limit':0, 'div_inverse_limit':2},path)
+            self.assertEqual(tuning.load(path)['karatsuba_limit'],5)
+            self.assertEqual(gf2.get_thresholds()['div_inverse_limit'],2)
+            with open(path) as f:
+                self.assertEqual(len(json.load(f)),1)
+            with open(path,'w') as f:
+                f.write('{not json')
+            self.assertIsNone(tuning.load(path))
+
+
+class test_stats(unittest.TestCase):
+
+    def tearDown(self):
+        gf2.enable_stats(False)
+        gf2.reset_stats()
+
+    def test_disabled(self):
+        gf2.enable_stats(False)
+        gf2.reset_stats()
+        gf2.mul(12345,678)
+        stats = gf2.stats()
+        self.assertFalse(stats['enabled'])
+        self.assertEqual(stats['kernels']['mul']['calls'],0)
+        self.assertEqual(stats['alloc_calls'],0)
+
+    def test_counts(self):
+        self.assertFalse(gf2.enable_stats(True))
+        self.assertTrue(gf2.enable_stats(True))
+        gf2.reset_stats()
+        l = randint(1<<9999,1<<10000)
+        r = randint(1<<9999,1<<10000)
+        for i in range(3):
+            gf2.mul(l,r)
+        gf2.divmod(l*r,r)
+        gf2.inv(r,100)
+        stats = gf2.stats()
+        self.assertTrue(stats['enabled'])
+        kernels = stats['kernels']
+        self.assertEqual(kernels['mul']['calls'],3)
+        self.assertEqual(kernels['divmod']['calls'],1)
+        self.assertEqual(kernels['inv']['calls'],1)
+        self.assertEqual(kernels['sqr']['calls'],0)
+        self.assertGreater(kernels['mul']['ticks'],0)
+        self.assertGreaterEqual(kernels['mul_nl_nr']['nbits'][16384],3)
+        self.assertEqual(kernels['inverse']['nbits'][128],1)
+        self.assertEqual(kernels['divmod_digits']['calls'],1)
+        self.assertEqual(stats['mul_nl_nr_depth'][0],kernels['mul_nl_nr']['calls'])
+        self.assertGreater(len(stats['mul_nl_nr_depth']),1)
+        self.assertGreaterEqual(stats['pylong_calls'],5)
+        gf2.reset_stats()
+        self.assertTrue(gf2.stats()['enabled'])
+        self.assertEqual(gf2.stats()['kernels']['mul']['calls'],0)
+
+    def test_division_counts(self):
+        # Each kind of division is counted on its own
+        gf2.enable_stats(True)
+        gf2.reset_stats()
+        l = randint(1<<9999,1<<10000)
+        r = randint(1<<4999,1<<5000)
+        u = gf2.mul(l,r)
+        gf2.div(u,r)
+        gf2.mod(u,r)
+        gf2.mod(l,r)
+        gf2.divexact(u,r)
+        kernels = gf2.stats()['kernels']
+        self.assertEqual(kernels['divmod']['calls'],0)
+        self.assertEqual(kernels['div']['calls'],1)
+        self.assertEqual(kernels['mod']['calls'],2)
+        self.assertEqual(kernels['divexact']['calls'],1)
+
+    def test_workspace(self):
+        # Scratch memory is reused, so repeated operations do not allocate
+        gf2.enable_stats(True)
+        l = randint(1<<19999,1<<20000)
+        r = randint(1<<9999,1<<10000)
+        u = gf2.mul(l,r)
+        for i in range(3):
+            gf2.reset_stats()
+            gf2.mul(l,r)
+            gf2.sqr(l)
+            gf2.divmod(u,r)
+            gf2.divmod(u,l)
+            gf2.divmod(u,r>>9950)
+            gf2.inv(r,20000)
+        self.assertEqual(gf2.stats()['alloc_calls'],0)
+
+
+class test_crc(unittest.TestCase):
+
+    # Catalog entries (name, width, poly, init, refin, refout, xorout, check)
+    catalog = [
+        ('CRC-3/GSM', 3, 0x3, 0x0, False, False, 0x7, 0x4),
+        ('CRC-5/USB', 5, 0x05, 0x1f, True, True, 0x1f, 0x19),
+        ('CRC-8/SMBUS', 8, 0x07, 0x00, False, False, 0x00, 0xf4),
+        ('CRC-16/ARC', 16, 0x8005, 0x0000, True, True, 0x0000, 0xbb3d),
+        ('CRC-16/RIELLO', 16, 0x1021, 0xb2aa, True, True, 0x0000, 0x63d0),
+        ('CRC-16/XMODEM', 16, 0x1021, 0x0000, False, False, 0x0000, 0x31c3),
+        ('CRC-32/ISO-HDLC', 32, 0x04c11db7, 0xffffffff, True, True, 0xffffffff, 0xcbf43926),
+        ('CRC-32/BZIP2', 32, 0x04c11db7, 0xffffffff, False, False, 0xffffffff, 0xfc891918),
+        ('CRC-32C', 32, 0x1edc6f41, 0xffffffff, True, True, 0xffffffff, 0xe3069283),
+        ('CRC-64/ECMA-182', 64, 0x42f0e1eba9ea3693, 0x0, False, False, 0x0, 0x6c40df5f0b497347),
+        ('CRC-64/XZ', 64, 0x42f0e1eba9ea3693, 0xffffffffffffffff, True, True, 0xffffffffffffffff, 0x995dc9bbdf1939fa),
+    ]
+
+    @staticmethod
+    def model_crc(data, poly, width, refin, refout, init, xorout):
+        mask = (1<<width)-1
+        reg = init
+        for b in data:
+            for i in range(0,8):
+                bit = (b>>i)&1 if refin else (b>>(7-i))&1
+                top = (reg>>(width-1))&1
+                reg = (reg<<1)&mask
+                if top^bit:
+                    reg ^= poly
+        if refout:
+            reg = int(format(reg,'0%db'%width)[::-1],2)
+        return reg^xorout
+
+    @staticmethod
+    def random_params():
+        width = randint(1,64)
+        return (randint(0,(1<<width)-1), width, bool(randint(0,1)), bool(randint(0,1)),
+                randint(0,(1<<width)-1), randint(0,(1<<width)-1))
+
+    def test_args(self):
+        with self.assertRaises(ValueError):
+            gf2.CRC(0x7, 0)
+        with self.assertRaises(ValueError):
+            gf2.CRC(0x7, 65)
+        with self.assertRaises(ValueError):
+            gf2.CRC(0x1ff, 4)
+        with self.assertRaises(ValueError):
+            gf2.CRC(0x7, 8, init=0x100)
+        with self.assertRaises(TypeError):
+            gf2.CRC(3.14, 8)
+        with self.assertRaises(TypeError):
+            gf2.CRC(0x7, 8).update('text')
+
+    def test_catalog(self):
+        for name, width, poly, init, refin, refout, xorout, check in self.catalog:
+            crc = gf2.CRC(poly, width, refin, refout, init, xorout)
+            self.assertEqual(crc.update(b'123456789'), check, name)
+            # Also with the leading x^width term included
+            crc = gf2.CRC(poly | (1<<width), width, refin, refout, init, xorout)
+            self.assertEqual(crc.update(b'123456789'), check, name)
+
+    def test_random(self):
+        for n in range(0,200):
+            params = self.random_params()
+            data = bytes(randint(0,255) for i in range(randint(0,300)))
+            crc = gf2.CRC(*params)
+            self.assertEqual(crc.update(data), self.model_crc(data, *params), params)
+
+    def test_long(self):
+        for name, width, poly, init, refin, refout, xorout, check in self.catalog:
+            for n in (63,64,127,128,129,200,1000,4099):
+                data = bytes(randint(0,255) for i in range(n))
+                crc = gf2.CRC(poly, width, refin, refout, init, xorout)
+                self.assertEqual(crc.update(data), self.model_crc(data, poly, width, refin, refout, init, xorout), (name, n))
+
+    def test_incremental(self):
+        for n in range(0,50):
+            params = self.random_params()
+            data = bytes(randint(0,255) for i in range(randint(0,2000)))
+            crc = gf2.CRC(*params)
+            whole = crc.update(data)
+            crc.reset()
+            i = 0
+            while i < len(data):
+                j = i + randint(1,300)
+                crc.update(data[i:j])
+                i = j
+            self.assertEqual(crc.value, whole, params)
+
+    def test_combine(self):
+        for n in range(0,100):
+            params = self.random_params()
+            a = bytes(randint(0,255) for i in range(randint(0,300)))
+            b = bytes(randint(0,255) for i in range(randint(0,300)))
+            crc1 = gf2.CRC(*params).update(a)
+            crc2 = gf2.CRC(*params).update(b)
+            crc12 = gf2.CRC(*params).update(a+b)
+            self.assertEqual(gf2.CRC(*params).combine(crc1, crc2, len(b)), crc12, params)
+
+class test_field(unittest.TestCase):
+
+    # Irreducible moduli, sparse and dense, covering all element widths
+    irreducible = [
+        0x3,                                   # x+1
+        0x11b,                                 # AES
+        (1<<64)|0x1b,
+        (1<<127)|(1<<1)|1,
+        (1<<128)|0x87,                         # GCM
+        0x101da01354f468977,                   # dense, degree 64
+        (1<<163)|(1<<7)|(1<<6)|(1<<3)|1,       # NIST B-163
+        (1<<233)|(1<<74)|1,                    # NIST B-233
+        (1<<283)|(1<<12)|(1<<7)|(1<<5)|1,      # NIST B-283
+        (1<<571)|(1<<10)|(1<<5)|(1<<2)|1,      # NIST B-571
+        (1<<1279)|(1<<216)|1,
+    ]
+
+    @staticmethod
+    def model_mulmod(a, b, f):
+        return int((gi(a)*gi(b)) % gi(f))
+
+    @staticmethod
+    def model_powmod(a, k, f):
+        p = 1
+        for i in range(k.bit_length()-1,-1,-1):
+            p = test_field.model_mulmod(p, p, f)
+            if (k>>i)&1:
+                p = test_field.model_mulmod(p, a, f)
+        return p
+
+    @staticmethod
+    def model_trace(a, f):
+        t = a
+        s = a
+        for i in range(1,f.bit_length()-1):
+            t = test_field.model_mulmod(t, t, f)
+            s ^= t
+        return s
+
+    @staticmethod
+    def is_irreducible(f):
+        # Ben-Or: f is irreducible iff gcd(x^(2^i)-x, f) = 1 for i <= n/2
+        n = f.bit_length()-1
+        t = 2
+        for i in range(1,n//2+1):
+            t = test_field.model_mulmod(t, t, f)
+            a, b = f, t^2
+            while b:
+                a, b = b, int(gi(a) % gi(b))
+            if a != 1:
+                return False
+        return True
+
+    @staticmethod
+    def random_irreducible(n):
+        while True:
+            f = (1<<n) | randint(0,(1<<n)-1) | 1
+            if test_field.is_irreducible(f):
+                return f
+
+    def test_args(self):
+        with self.assertRaises(TypeError):
+            gf2.Field(3.14)
+        with self.assertRaises(ValueError):
+            gf2.Field(1)
+        with self.assertRaises(ValueError):
+            gf2.Field(-0x11b)
+        F = gf2.Field(0x11b)
+        self.assertEqual(F.modulus, 0x11b)
+        self.assertEqual(F.degree, 8)
+        with self.assertRaises(TypeError):
+            F(3.14)
+        with self.assertRaises(ValueError):
+            F(-1)
+        with self.assertRaises(ValueError):
+            F(1<<16)
+        with self.assertRaises(ValueError):
+            F(1) + gf2.Field(0x13)(1)
+        with self.assertRaises(ZeroDivisionError):
+            F(0).inverse()
+        with self.assertRaises(ZeroDivisionError):
+            F(1)/F(0)
+        with self.assertRaises(ValueError):
+            F(0)**0
+        with self.assertRaises(TypeError):
+            pow(F(3), 2, 5)
+
+    def test_element(self):
+        F = gf2.Field(0x11b)
+        a = F(0x53)
+        self.assertEqual(int(a), 0x53)
+        self.assertEqual(a, 0x53)
+        self.assertEqual(a, gf2.Field(0x11b)(0x53))
+        self.assertEqual(hash(a), hash(0x53))
+        self.assertIs(a.field, F)
+        self.assertEqual(repr(a), 'Field(0x11b)(0x53)')
+        self.assertEqual(F(0x11b), 0)
+        self.assertEqual(a*F(0xca), 1)
+        self.assertEqual(a*0xca, 1)
+        self.assertEqual(0xca*a, 1)
+        self.assertEqual(a+a, 0)
+        self.assertEqual(a-0x50, 3)
+        self.assertEqual(-a, a)
+        self.assertFalse(F(0))
+        self.assertTrue(a)
+
+    def test_random(self):
+        for n in (1,2,7,8,31,63,64,65,100,127,128,129,200,255,256,257,400,571,576,577,700,1500):
+            for sparse in (False, True):
+                if sparse:
+                    f = (1<<n) | (1<<randint(0,n//2)) | 1
+                else:
+                    f = (1<<n) | randint(0,(1<<n)-1)
+                F = gf2.Field(f)
+                for i in range(0,20):
+                    a = randint(0,(1<<n)-1)
+                    b = randint(0,(1<<n)-1)
+                    c = randint(0,(1<<(2*n))-1)
+                    k = randint(1,1<<randint(1,80))
+                    self.assertEqual(int(F(a)*F(b)), self.model_mulmod(a, b, f), (f, a, b))
+                    self.assertEqual(int(F(a)+F(b)), a^b)
+                    self.assertEqual(int(F(c)), int(gi(c) % gi(f)), (f, c))
+                    self.assertEqual(int(F(a)**2), self.model_mulmod(a, a, f), (f, a))
+                    self.assertEqual(int(F(a)**k), self.model_powmod(a, k, f), (f, a, k))
+
+    def test_irreducible(self):
+        moduli = self.irreducible + [self.random_irreducible(n) for n in (100,200,300,600)]
+        for f in moduli:
+            n = f.bit_length()-1
+            F = gf2.Field(f)
+            for i in range(0,5):
+                a = randint(1,(1<<n)-1)
+                b = randint(1,(1<<n)-1)
+                self.assertEqual(a*F(a).inverse(), 1, (f, a))
+                self.assertEqual(F(a)**-1, F(a).inverse())
+                self.assertEqual(F(a)/F(b)*F(b), a)
+                self.assertEqual(F(a).sqrt()**2, a)
+                self.assertEqual(F(a).trace(), self.model_trace(a, f), (f, a))
+                self.assertEqual(F(a)**((1<<n)-1), 1)
+
+    def test_sqrt(self):
+        # Odd number of digits in use, stored in whole words
+        F = gf2.Field((1<<1279)|(1<<216)|1)
+        for a in [2, 12345, 1<<1278] + [randint(1,(1<<1279)-1) for i in range(0,5)]:
+            self.assertEqual(F(a).sqrt()**2, a)
+            self.assertEqual((F(a)**2).sqrt(), a)
+
+    def test_compare(self):
+        # Elements stored as digits, compared and tested after powers through scratch words
+        F = gf2.Field((1<<607)|(1<<105)|1)
+        for i in range(0,20):
+            a = F(randint(1,(1<<607)-1))
+            self.assertEqual(a**4, a*a*a*a)
+            self.assertFalse(a**4 + a*a*a*a)
+            self.assertEqual(hash(a**4), hash(int(a*a*a*a)))
+            self.assertEqual(a**-1 * a, 1)
+
+    def test_reducible(self):
+        F = gf2.Field(0b101)  # (x+1)^2
+        with self.assertRaises(ValueError):
+            F(0b11).inverse()
+        with self.assertRaises(ValueError):
+            F(1)/F(0b11)
+        with self.assertRaises(ValueError):
+            F(0b10).sqrt()
+
+
+class test_packed(unittest.TestCase):
+
+    @staticmethod
+    def model_mul(F, a, b):
+        c = [F(0)]*(len(a)+len(b)-1)
+        for i in range(len(a)):
+            for j in range(len(b)):
+                c[i+j] += F(a[i])*F(b[j])
+        return [int(x) for x in c]
+
+    def test_pack(self):
+        self.assertEqual(gf2.pack([], 8), 0)
+        self.assertEqual(gf2.unpack(0, 8), [])
+        self.assertEqual(gf2.pack([0x12, 0x34, 0], 8), 0x3412)
+        self.assertEqual(gf2.unpack(0x3412, 8), [0x12, 0x34])
+        self.assertEqual(gf2.unpack(0x3412, 5), [0x12, 0x0, 0xd])
+        for k in (1, 3, 15, 30, 31, 63, 64):
+            c = [randint(0, (1<<k)-1) for i in range(100)] + [1]
+            self.assertEqual(gf2.unpack(gf2.pack(c, k), k), c)
+        with self.assertRaises(ValueError):
+            gf2.pack([256], 8)
+        with self.assertRaises(ValueError):
+            gf2.pack([-1], 8)
+        with self.assertRaises(ValueError):
+            gf2.pack([1], 0)
+        with self.assertRaises(ValueError):
+            gf2.unpack(1, 65)
+        with self.assertRaises(TypeError):
+            gf2.pack([1.0], 8)
+        with self.assertRaises(ValueError):
+            gf2.unpack(-1, 8)
+
+    def test_mul(self):
+        for f in test_subproduct.moduli + [(1<<64)|(1<<63)|1, 0x7]:
+            F = gf2.Field(f)
+            k = F.degree
+            for na, nb in ((1, 1), (1, 9), (4, 5), (5, 5), (30, 40), (200, 3), (100, 257)):
+                a = [randint(0, (1<<k)-1) for i in range(na-1)] + [randint(1, (1<<k)-1)]
+                b = [randint(0, (1<<k)-1) for i in range(nb-1)] + [randint(1, (1<<k)-1)]
+                p = gf2.pack(self.model_mul(F, a, b), k)
+                self.assertEqual(gf2.mul_packed(gf2.pack(a, k), gf2.pack(b, k), k, f), p, (f, na, nb))
+                self.assertEqual(gf2.mul_packed(gf2.pack(a, k), gf2.pack(b, k), k, F), p, (f, na, nb))
+        self.assertEqual(gf2.mul_packed(0, 0x1234, 8, 0x11b), 0)
+        with self.assertRaises(ValueError):
+            gf2.mul_packed(1, 1, 8, 0x1100b)
+        with self.assertRaises(ValueError):
+            gf2.mul_packed(1, 1, 16, gf2.Field(0x11b))
+        with self.assertRaises(ValueError):
+            gf2.mul_packed(-1, 1, 8, 0x11b)
+        with self.assertRaises(TypeError):
+            gf2.mul_packed(1, 1, 8, 1.5)
+
+
+class test_subproduct(unittest.TestCase):
+
+    # Irreducible moduli of degree <= 64, including 1 and 64
+    moduli = [f for f in test_field.irreducible if f.bit_length() <= 65] + [0x1100b, (1<<32)|0x8d]
+
+    @staticmethod
+    def model_eval(F, coeffs, x):
+        v = F(0)
+        for c in reversed(coeffs):
+            v = v*F(x) + F(c)
+        return int(v)
+
+    def test_args(self):
+        F = gf2.Field(0x11b)
+        with self.assertRaises(TypeError):
+            gf2.SubproductTree(0x11b, [1, 2])
+        with self.assertRaises(ValueError):
+            gf2.SubproductTree(gf2.Field((1<<65)|1), [1, 2])
+        with self.assertRaises(ValueError):
+            gf2.SubproductTree(F, [])
+        with self.assertRaises(TypeError):
+            gf2.SubproductTree(F, [1.0])
+        T = gf2.SubproductTree(F, (F(x) for x in (1, 2, 3)))
+        self.assertEqual(len(T), 3)
+        self.assertIs(T.field, F)
+        # (y+1)(y+2)(y+3) = y^3 + (1+2+3)y^2 + (1*2+1*3+2*3)y + 1*2*3
+        self.assertEqual(T.product, gf2.pack([6, 7, 0, 1], 8))
+        with self.assertRaises(ValueError):
+            T.evaluate(-1)
+        with self.assertRaises(TypeError):
+            T.evaluate(1.0)
+        with self.assertRaises(ValueError):
+            T.interpolate([1, 2])
+        with self.assertRaises(ValueError):
+            gf2.SubproductTree(F, [5, 7, 5]).interpolate([1, 2, 3])
+
+    def test_random(self):
+        for f in self.moduli:
+            F = gf2.Field(f)
+            k = F.degree
+            for n in (1, 2, 3, 16, 17, 40, 333):
+                if n > 1<<k:
+                    continue
+                points = random.sample(range(1<<k), n) if k < 32 else [randint(0, (1<<k)-1) for i in range(n)]
+                T = gf2.SubproductTree(F, points)
+                for ncoeffs in (1, n//2+1, n, n+1, 3*n+5):
+                    c = [randint(0, (1<<k)-1) for i in range(ncoeffs)]
+                    self.assertEqual(T.evaluate(gf2.pack(c, k)), [self.model_eval(F, c, x) for x in points], (f, n, ncoeffs))
+                self.assertEqual(T.evaluate(T.product), [0]*n)
+                values = [randint(0, (1<<k)-1) for i in range(n)]
+                a = T.interpolate(values)
+                self.assertLess(len(gf2.unpack(a, k)), n+1)
+                self.assertEqual(T.evaluate(a), values, (f, n))
+
+    def test_large(self):
+        F = gf2.Field(0x1100b)
+        points = random.sample(range(1<<16), 5000)
+        T = gf2.SubproductTree(F, points)
+        a = gf2.pack([randint(0, (1<<16)-1) for i in range(5000)], 16)
+        self.assertEqual(T.interpolate(T.evaluate(a)), a)
+
+
+class test_remainder_tree(unittest.TestCase):
+
+    @staticmethod
+    def gcd(a, b):
+        while b:
+            a, b = b, gf2.mod(a, b)
+        return a
+
+    def coprime(self, k, sizes):
+        moduli = []
+        while len(moduli) < k:
+            nbits = random.choice(sizes)
+            m = randint(1<<(nbits-1), (1<<nbits)-1) | 2
+            if all(self.gcd(m, x) == 1 for x in moduli):
+                moduli.append(m)
+        return moduli
+
+    def test_args(self):
+        with self.assertRaises(ValueError):
+            gf2.RemainderTree([])
+        with self.assertRaises(ValueError):
+            gf2.RemainderTree([3, 1])
+        with self.assertRaises(ValueError):
+            gf2.RemainderTree([3, -7])
+        with self.assertRaises(TypeError):
+            gf2.RemainderTree([3, 7.0])
+        with self.assertRaises(TypeError):
+            gf2.RemainderTree(3)
+        T = gf2.RemainderTree([3, 7, 0xb])
+        self.assertEqual(len(T), 3)
+        self.assertEqual(T.product, gf2.mul(gf2.mul(3, 7), 0xb))
+        with self.assertRaises(TypeError):
+            T.reduce(1.0)
+        with self.assertRaises(ValueError):
+            T.reduce(-1)
+        with self.assertRaises(ValueError):
+            T.crt([1, 2])
+        with self.assertRaises(ValueError):
+            T.crt([1, 2, -3])
+        with self.assertRaises(ValueError):
+            gf2.crt([0, 1], [3, 5])
+        self.assertEqual(T.reduce(0), [0, 0, 0])
+        self.assertEqual(gf2.multi_mod(0x1234, [2, 3]), [0, 1])
+        self.assertEqual(gf2.crt([0, 1], [2, 3]), 2)
+        self.assertEqual(gf2.crt([1], [0x11b]), 1)
+
+    def test_random(self):
+        for k in (1, 2, 3, 17, 100):
+            for sizes in ((2, 3, 17), (33, 64, 65), (2, 100, 1000)):
+                moduli = self.coprime(k, sizes)
+                T = gf2.RemainderTree(moduli)
+                for nbits in (0, 10, 1000, 30000):
+                    a = randint(0, (1<<nbits)-1)
+                    r = T.reduce(a)
+                    self.assertEqual(r, [gf2.mod(a, m) for m in moduli], (k, sizes, nbits))
+                    self.assertEqual(gf2.multi_mod(a, moduli), r)
+                    self.assertEqual(T.crt(r), gf2.mod(a, T.product), (k, sizes, nbits))
+                    self.assertEqual(gf2.crt(r, T), T.crt(r))
+                # Residues need not be reduced
+                r = [randint(0, 1<<2000) for m in moduli]
+                self.assertEqual(T.reduce(T.crt(r)), [gf2.mod(x, m) for x, m in zip(r, moduli)])
+
+    def test_large(self):
+        moduli = [(1<<32)|randint(0, (1<<32)-1)|1 for i in range(3000)]
+        a = randint(0, 1<<100000)
+        self.assertEqual(gf2.multi_mod(a, moduli), [gf2.mod(a, m) for m in moduli])
+
+
+class test_berlekamp_massey(unittest.TestCase):
+
+    def setUp(self):
+        self.saved = gf2.get_thresholds()
+
+    def tearDown(self):
+        gf2.set_thresholds(self.saved)
+
+    @staticmethod
+    def model_bm(s):
+        L, C, B, m = 0, 1, 1, 1
+        for n in range(len(s)):
+            d = s[n]
+            for i in range(1, L+1):
+                d ^= (C >> i) & s[n-i]
+            if d == 0:
+                m += 1
+            elif 2*L <= n:
+                C, B, L, m = C ^ (B << m), C, n+1-L, 1
+            else:
+                C ^= B << m
+                m += 1
+        return L, C
+
+    @staticmethod
+    def to_bytes(s):
+        return sum(b << i for i, b in enumerate(s)).to_bytes((len(s)+7)//8, 'little')
+
+    @staticmethod
+    def lfsr(C, L, init, n):
+        # Bit j of w is the bit j+1 steps back
+        s = [(init >> i) & 1 for i in range(min(L, n))]
+        w = int(''.join(map(str, s)) or '0', 2)
+        for i in range(L, n):
+            b = bin((C >> 1) & w).count('1') & 1
+            s.append(b)
+            w = (w << 1 | b) & ((1 << L) - 1)
+        return s
+
+    def test_args(self):
+        self.assertEqual(gf2.berlekamp_massey(b''), (0, 1))
+        self.assertEqual(gf2.berlekamp_massey(b'\0\0'), (0, 1))
+        self.assertEqual(gf2.berlekamp_massey(b'\x80', 7), (0, 1))
+        self.assertEqual(gf2.berlekamp_massey(b'\x80'), (8, 0x101))
+        self.assertEqual(gf2.berlekamp_massey(bytearray(b'\xff')), (1, 3))
+        with self.assertRaises(ValueError):
+            gf2.berlekamp_massey(b'\0', 9)
+        with self.assertRaises(ValueError):
+            gf2.berlekamp_massey(b'\0', -2)
+        with self.assertRaises(TypeError):
+            gf2.berlekamp_massey([0, 1])
+        with self.assertRaises(TypeError):
+            gf2.berlekamp_massey('01')
+
+    def test_lfsr(self):
+        for limit in (64, 1024):
+            gf2.set_thresholds({'bm_recursive_limit':limit})
+            for f in test_field.irreducible:
+                L = f.bit_length() - 1
+                # Connection polynomial x^L f(1/x)
+                C = int(bin(f)[:1:-1], 2)
+                s = self.lfsr(C, L, randint(1, (1<<L)-1), 2*L + 50)
+                self.assertEqual(gf2.berlekamp_massey(self.to_bytes(s), len(s)), (L, C), (limit, f))
+
+    def test_random(self):
+        for limit in (64, 100, 1024):
+            gf2.set_thresholds({'bm_recursive_limit':limit})
+            for n in (1, 2, 63, 64, 65, 127, 128, 129, 300, 1000, 2500):
+                s = [randint(0, 1) for i in range(n)]
+                self.assertEqual(gf2.berlekamp_massey(self.to_bytes(s), n), self.model_bm(s), (limit, n))
+                # Short LFSR followed by noise
+                L = n//3
+                C = randint(0, (1<<L)-1)*2 + 1
+                s = self.lfsr(C, L, randint(0, (1<<L)-1), n)
+                self.assertEqual(gf2.berlekamp_massey(self.to_bytes(s), n), self.model_bm(s), (limit, n))
+
+    def test_large(self):
+        # The recursive and non-recursive variants agree, and the result generates the sequence
+        L = 4000
+        C = randint(0, (1<<L)-1)*2 + 1 | 1<<L
+        s = self.lfsr(C, L, randint(0, (1<<L)-1), 2*L)
+        r = gf2.berlekamp_massey(self.to_bytes(s))
+        self.assertLessEqual(r[0], L)
+        self.assertEqual(self.lfsr(r[1], r[0], sum(s[i] << i for i in range(r[0])), 2*L), s)
+        gf2.set_thresholds({'bm_recursive_limit':1<<20})
+        self.assertEqual(gf2.berlekamp_massey(self.to_bytes(s)), r)
+
+
+class test_jump(unittest.TestCase):
+
+    moduli = test_field.irreducible + [0x4, (1<<64)|(1<<63), (1<<700)|randint(0, (1<<700)-1), (1<<1000)|(1<<500)|(1<<3)|1]
+
+    @staticmethod
+    def step(s, f):
+        # One step of the Galois LFSR with characteristic polynomial f
+        s <<= 1
+        return s ^ f if s >> (f.bit_length()-1) else s
+
+    def test_xpow_mod(self):
+        for f in self.moduli:
+            F = gf2.Field(f)
+            n = f.bit_length()-1
+            for N in (0, 1, 2, n-1, n, n+1, 2*n, randint(0, 1<<200), 1<<100):
+                r = test_field.model_powmod(2, N, f)
+                self.assertEqual(gf2.xpow_mod(N, f), r, (f, N))
+                self.assertEqual(gf2.xpow_mod(N, F), r, (f, N))
+                if N:
+                    self.assertEqual(int(F(2)**N), r, (f, N))
+
+    def test_apply_jump(self):
+        for f in self.moduli:
+            F = gf2.Field(f)
+            n = f.bit_length()-1
+            s0 = randint(1, (1<<n)-1)
+            s = s0
+            for i in range(300):
+                s = self.step(s, f)
+            self.assertEqual(gf2.apply_jump(s0, gf2.xpow_mod(300, f), f), s, f)
+            self.assertEqual(gf2.apply_jump(F(s0), gf2.xpow_mod(300, F), F), s, f)
+            # Streams 2^100 steps apart
+            j = gf2.xpow_mod(1<<100, F)
+            s1 = gf2.apply_jump(s0, j, F)
+            s2 = gf2.apply_jump(s1, j, F)
+            self.assertEqual(s2, gf2.apply_jump(s0, gf2.xpow_mod(1<<101, F), F), f)
+
+    def test_args(self):
+        with self.assertRaises(ValueError):
+            gf2.xpow_mod(-1, 0x11b)
+        with self.assertRaises(ValueError):
+            gf2.xpow_mod(5, 1)
+        with self.assertRaises(TypeError):
+            gf2.xpow_mod(5, 1.5)
+        with self.assertRaises(TypeError):
+            gf2.xpow_mod(5.0, 0x11b)
+        with self.assertRaises(TypeError):
+            gf2.apply_jump(1.0, 2, 0x11b)
+        with self.assertRaises(ValueError):
+            gf2.apply_jump(-1, 2, 0x11b)
+        with self.assertRaises(ValueError):
+            gf2.apply_jump(gf2.Field(0x11d)(1), 2, 0x11b)
+
+
+class test_compose_mod(unittest.TestCase):
+
+    @staticmethod
+    def model_compose(f, g, h):
+        # Horner's scheme, one multiplication mod h per coefficient of f
+        r = 0
+        for i in reversed(range(f.bit_length())):
+            r = gf2.mod(gf2.mul(r, g), h) ^ (f >> i & 1)
+        return gf2.mod(r, h)
+
+    def test_random(self):
+        for h in test_jump.moduli:
+            F = gf2.Field(h)
+            n = h.bit_length()-1
+            for nbits in (0, 1, 2, 3, 17, 64, 300, 2000):
+                f = randint(0, (1<<nbits)-1) | (nbits and 1<<(nbits-1))
+                g = randint(0, (1<<n)-1)
+                r = self.model_compose(f, g, h)
+                self.assertEqual(gf2.compose_mod(f, g, h), r, (h, nbits))
+                self.assertEqual(gf2.compose_mod(f, F(g), F), r, (h, nbits))
+            # f(x) mod h, and the Frobenius x^(2^k) composed with itself
+            f = randint(0, 1<<3000)
+            self.assertEqual(gf2.compose_mod(f, 2, F), gf2.mod(f, h), h)
+            x2 = gf2.xpow_mod(1<<5, F)
+            self.assertEqual(gf2.compose_mod(x2, x2, F), gf2.xpow_mod(1<<10, F), h)
+
+    def test_args(self):
+        with self.assertRaises(ValueError):
+            gf2.compose_mod(-1, 2, 0x11b)
+        with self.assertRaises(ValueError):
+            gf2.compose_mod(too_large, 2, 0x11b)
+        with self.assertRaises(ValueError):
+            gf2.compose_mod(3, -2, 0x11b)
+        with self.assertRaises(ValueError):
+            gf2.compose_mod(3, 2, 1)
+        with self.assertRaises(TypeError):
+            gf2.compose_mod(3, 2.0, 0x11b)
+        with self.assertRaises(TypeError):
+            gf2.compose_mod(3.0, 2, 0x11b)
+        with self.assertRaises(ValueError):
+            gf2.compose_mod(3, gf2.Field(0x11d)(1), 0x11b)
+        self.assertEqual(gf2.compose_mod(0, 5, 0x11b), 0)
+        self.assertEqual(gf2.compose_mod(1, 5, 0x11b), 1)
+
+
 if __name__ == '__main__':
     unittest.main()